@@ -0,0 +1,166 @@
+#include "arena.h"
+#include <stdbool.h>
+#include <assert.h>
+
+#define FIRST_BLOCK_SIZE 4096
+#define MAX_BLOCK_SIZE (1 << 20)
+#define FREE_LIST_COUNT (ARENA_MAX_RECYCLED_SIZE / ARENA_ALIGNMENT)
+
+//A block's header. Its objects follow it, starting at the first aligned address.
+typedef struct ArenaBlock_t
+{
+    struct ArenaBlock_t* next;
+    size_t size; //Including the header.
+} *ArenaBlock;
+
+//A released object, linked into the free list of its size.
+typedef struct ArenaFreeObject_t
+{
+    struct ArenaFreeObject_t* next;
+} *ArenaFreeObject;
+
+struct Arena_t
+{
+    ArenaBlock blocks; //The newest block first; objects are carved out of it.
+    char* position;
+    char* end;
+    size_t next_block_size;
+    size_t reserved_bytes;
+    MemoryCategory category;
+
+    //free_lists[i] holds the released objects of (i + 1) * ARENA_ALIGNMENT bytes.
+    ArenaFreeObject free_lists[FREE_LIST_COUNT];
+};
+
+//Declaring static auxiliary functions:
+static size_t alignSize(size_t size);
+//Starts a new block with room for at least size bytes. Returns false if the allocation failed.
+static bool addBlock(Arena arena, size_t size);
+
+Arena arenaCreate(MemoryCategory category)
+{
+    Arena arena = trackedMalloc(category, sizeof(*arena));
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    arena->category = category;
+    arena->blocks = NULL;
+    arena->position = NULL;
+    arena->end = NULL;
+    arena->next_block_size = FIRST_BLOCK_SIZE;
+    arena->reserved_bytes = 0;
+    for (int list = 0; list < FREE_LIST_COUNT; ++list)
+    {
+        arena->free_lists[list] = NULL;
+    }
+
+    return arena;
+}
+
+void arenaDestroy(Arena arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    ArenaBlock block = arena->blocks;
+    while (block != NULL)
+    {
+        ArenaBlock next = block->next;
+        trackedFree(arena->category, block, block->size);
+        block = next;
+    }
+
+    trackedFree(arena->category, arena, sizeof(*arena));
+}
+
+void* arenaAllocate(Arena arena, size_t size)
+{
+    assert(arena != NULL);
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    size = alignSize(size);
+    if (size <= ARENA_MAX_RECYCLED_SIZE)
+    {
+        ArenaFreeObject* list = &arena->free_lists[size / ARENA_ALIGNMENT - 1];
+        if (*list != NULL)
+        {
+            ArenaFreeObject object = *list;
+            *list = object->next;
+            return object;
+        }
+    }
+
+    if ((size_t)(arena->end - arena->position) < size && !addBlock(arena, size))
+    {
+        return NULL;
+    }
+
+    void* object = arena->position;
+    arena->position += size;
+    return object;
+}
+
+void arenaRelease(Arena arena, void* pointer, size_t size)
+{
+    assert(arena != NULL);
+    size = alignSize(size);
+    if (pointer == NULL || size == 0 || size > ARENA_MAX_RECYCLED_SIZE)
+    {
+        return;
+    }
+
+    ArenaFreeObject object = pointer;
+    ArenaFreeObject* list = &arena->free_lists[size / ARENA_ALIGNMENT - 1];
+    object->next = *list;
+    *list = object;
+}
+
+size_t arenaGetReservedBytes(Arena arena)
+{
+    return arena->reserved_bytes;
+}
+
+
+//Static auxiliary functions:
+static size_t alignSize(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static bool addBlock(Arena arena, size_t size)
+{
+    size_t header_size = alignSize(sizeof(struct ArenaBlock_t));
+    size_t block_size = arena->next_block_size;
+    if (block_size < header_size + size)
+    {
+        block_size = header_size + size; //A dedicated block for a large object.
+    }
+
+    ArenaBlock block = trackedMalloc(arena->category, block_size);
+    if (block == NULL)
+    {
+        return false;
+    }
+
+    //The rest of the current block is given up. Blocks grow geometrically, so that is at most a
+    //small fraction of the reserved bytes.
+    block->size = block_size;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->position = (char*)block + header_size;
+    arena->end = (char*)block + block_size;
+    arena->reserved_bytes += block_size;
+    if (arena->next_block_size < MAX_BLOCK_SIZE)
+    {
+        arena->next_block_size *= 2;
+    }
+
+    return true;
+}
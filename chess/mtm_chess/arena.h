@@ -0,0 +1,70 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "memoryStats.h"
+
+/**
+* Region allocator
+*
+* Objects are carved out of large blocks, one after the other. Destroying the arena frees all of
+* its blocks at once, however many objects were allocated from them.
+*
+* Released objects of up to ARENA_MAX_RECYCLED_SIZE bytes go to per-size free lists and are handed
+* out again by later allocations of the same size, so a steady churn of small objects (map nodes,
+* players) doesn't make the arena grow. Larger released objects stay reserved until the arena is
+* destroyed.
+*
+* An arena is not thread safe.
+*
+* The following functions are available:
+*   arenaCreate			- Creates an empty arena
+*   arenaDestroy		- Frees every block of the arena
+*   arenaAllocate		- Allocates an object from the arena
+*   arenaRelease		- Gives an object back to the arena
+*   arenaGetReservedBytes	- Returns the total size of the arena's blocks
+*/
+
+//Every object returned by arenaAllocate is aligned to this many bytes.
+#define ARENA_ALIGNMENT 16
+#define ARENA_MAX_RECYCLED_SIZE 256
+
+/** Type for defining the arena */
+typedef struct Arena_t *Arena;
+
+/**
+* arenaCreate: Creates an arena with no blocks; the first one is allocated on first use.
+* @param category - The category of memoryStats.h the arena and its blocks are counted in.
+* @return
+*   NULL - if an allocation failed.
+*   A new arena otherwise.
+*/
+Arena arenaCreate(MemoryCategory category);
+
+/**
+* arenaDestroy: Frees the arena and every object allocated from it.
+* @param arena - Target arena. If NULL, nothing is done.
+*/
+void arenaDestroy(Arena arena);
+
+/**
+* arenaAllocate: Allocates size bytes, aligned to ARENA_ALIGNMENT, from the arena.
+* @return
+*   NULL - if size is 0 or a new block could not be allocated.
+*   The object otherwise. It lives until it is released or the arena is destroyed.
+*/
+void* arenaAllocate(Arena arena, size_t size);
+
+/**
+* arenaRelease: Gives back an object, so later allocations of the same size may reuse it.
+* @param pointer - An object allocated from the arena, or NULL (nothing is done then).
+* @param size - The size the object was allocated with.
+*/
+void arenaRelease(Arena arena, void* pointer, size_t size);
+
+/**
+* arenaGetReservedBytes: Returns the total size of the blocks allocated by the arena so far.
+*/
+size_t arenaGetReservedBytes(Arena arena);
+
+#endif //ARENA_H
@@ -0,0 +1,234 @@
+#include "avlTree.h"
+#include <stddef.h>
+
+//Declaring static auxiliary functions:
+static int getHeight(const AvlLink* node);
+static void updateHeight(AvlLink* node);
+//Puts replacement where child hangs from parent (or at the root if parent is NULL).
+static void replaceChild(AvlTree* tree, AvlLink* parent, AvlLink* child, AvlLink* replacement);
+//Both return the node that took the rotated node's place.
+static AvlLink* rotateLeft(AvlTree* tree, AvlLink* node);
+static AvlLink* rotateRight(AvlTree* tree, AvlLink* node);
+//Restores the balance of every node from the given one up to the root.
+static void rebalanceUpwards(AvlTree* tree, AvlLink* node);
+//The deepest node reached from the given one preferring left children; the first of its subtree in post-order.
+static AvlLink* firstPostorderFrom(AvlLink* node);
+
+void avlInit(AvlTree* tree)
+{
+    tree->root = NULL;
+    tree->size = 0;
+}
+
+void avlLink(AvlTree* tree, AvlLink* node, AvlLink* parent, AvlLink** position)
+{
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = parent;
+    node->height = 1;
+    *position = node;
+    ++tree->size;
+
+    rebalanceUpwards(tree, parent);
+}
+
+void avlErase(AvlTree* tree, AvlLink* node)
+{
+    AvlLink* rebalance_from;
+
+    if (node->left != NULL && node->right != NULL)
+    {
+        //The successor has no left child, so it's moved into the node's place.
+        AvlLink* successor = node->right;
+        while (successor->left != NULL)
+        {
+            successor = successor->left;
+        }
+
+        if (successor->parent == node)
+        {
+            rebalance_from = successor;
+        }
+        else
+        {
+            rebalance_from = successor->parent;
+            rebalance_from->left = successor->right;
+            if (successor->right != NULL)
+            {
+                successor->right->parent = rebalance_from;
+            }
+            successor->right = node->right;
+            node->right->parent = successor;
+        }
+
+        successor->left = node->left;
+        node->left->parent = successor;
+        successor->parent = node->parent;
+        successor->height = node->height;
+        replaceChild(tree, node->parent, node, successor);
+    }
+    else
+    {
+        AvlLink* child = node->left != NULL ? node->left : node->right;
+        if (child != NULL)
+        {
+            child->parent = node->parent;
+        }
+        rebalance_from = node->parent;
+        replaceChild(tree, node->parent, node, child);
+    }
+
+    --tree->size;
+    rebalanceUpwards(tree, rebalance_from);
+}
+
+AvlLink* avlFirst(const AvlTree* tree)
+{
+    AvlLink* node = tree->root;
+    while (node != NULL && node->left != NULL)
+    {
+        node = node->left;
+    }
+    return node;
+}
+
+AvlLink* avlNext(const AvlLink* node)
+{
+    if (node->right != NULL)
+    {
+        AvlLink* next = node->right;
+        while (next->left != NULL)
+        {
+            next = next->left;
+        }
+        return next;
+    }
+
+    while (node->parent != NULL && node->parent->right == node)
+    {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+AvlLink* avlFirstPostorder(const AvlTree* tree)
+{
+    return tree->root == NULL ? NULL : firstPostorderFrom(tree->root);
+}
+
+AvlLink* avlNextPostorder(const AvlLink* node)
+{
+    AvlLink* parent = node->parent;
+    if (parent != NULL && parent->left == node && parent->right != NULL)
+    {
+        return firstPostorderFrom(parent->right);
+    }
+    return parent;
+}
+
+
+//Static auxiliary functions:
+static int getHeight(const AvlLink* node)
+{
+    return node == NULL ? 0 : node->height;
+}
+
+static void updateHeight(AvlLink* node)
+{
+    int left = getHeight(node->left), right = getHeight(node->right);
+    node->height = 1 + (left > right ? left : right);
+}
+
+static void replaceChild(AvlTree* tree, AvlLink* parent, AvlLink* child, AvlLink* replacement)
+{
+    if (parent == NULL)
+    {
+        tree->root = replacement;
+    }
+    else if (parent->left == child)
+    {
+        parent->left = replacement;
+    }
+    else
+    {
+        parent->right = replacement;
+    }
+}
+
+static AvlLink* rotateLeft(AvlTree* tree, AvlLink* node)
+{
+    AvlLink* pivot = node->right;
+
+    node->right = pivot->left;
+    if (pivot->left != NULL)
+    {
+        pivot->left->parent = node;
+    }
+    pivot->parent = node->parent;
+    replaceChild(tree, node->parent, node, pivot);
+    pivot->left = node;
+    node->parent = pivot;
+
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+static AvlLink* rotateRight(AvlTree* tree, AvlLink* node)
+{
+    AvlLink* pivot = node->left;
+
+    node->left = pivot->right;
+    if (pivot->right != NULL)
+    {
+        pivot->right->parent = node;
+    }
+    pivot->parent = node->parent;
+    replaceChild(tree, node->parent, node, pivot);
+    pivot->right = node;
+    node->parent = pivot;
+
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+static void rebalanceUpwards(AvlTree* tree, AvlLink* node)
+{
+    while (node != NULL)
+    {
+        int balance = getHeight(node->left) - getHeight(node->right);
+
+        if (balance > 1)
+        {
+            if (getHeight(node->left->left) < getHeight(node->left->right))
+            {
+                rotateLeft(tree, node->left);
+            }
+            node = rotateRight(tree, node);
+        }
+        else if (balance < -1)
+        {
+            if (getHeight(node->right->right) < getHeight(node->right->left))
+            {
+                rotateRight(tree, node->right);
+            }
+            node = rotateLeft(tree, node);
+        }
+        else
+        {
+            updateHeight(node);
+        }
+
+        node = node->parent;
+    }
+}
+
+static AvlLink* firstPostorderFrom(AvlLink* node)
+{
+    while (node->left != NULL || node->right != NULL)
+    {
+        node = node->left != NULL ? node->left : node->right;
+    }
+    return node;
+}
@@ -0,0 +1,63 @@
+#ifndef AVL_TREE_H
+#define AVL_TREE_H
+
+/**
+* Balanced binary search tree over links embedded in the caller's nodes
+*
+* The tree never compares keys: the caller walks down from the root with its own comparison, and
+* hands the position it stopped at to avlLink. That way the comparisons of a typed container
+* (see typedMap.h) are inlined into its search, while the rebalancing is written once.
+* The tree allocates nothing either; nodes belong to the caller.
+*
+* The heights of any node's two subtrees differ by at most one, so searches take O(log n).
+*
+* The following functions are available:
+*   avlInit		- Makes an empty tree
+*   avlLink		- Adds a node at the position found by a search
+*   avlErase		- Takes a node out of the tree
+*   avlFirst		- Returns the smallest node
+*   avlNext		- Returns the node after the given one, in order
+*   avlFirstPostorder	- Returns the first node of a walk visiting children before their parents
+*   avlNextPostorder	- Returns the next node of that walk
+*/
+
+//The part of a node the tree links. Its fields are the tree's: callers only read left and right
+//while searching.
+typedef struct AvlLink_t
+{
+    struct AvlLink_t* left;
+    struct AvlLink_t* right;
+    struct AvlLink_t* parent;
+    int height; //Of the subtree under the node, a leaf being 1.
+} AvlLink;
+
+typedef struct AvlTree_t
+{
+    AvlLink* root;
+    int size;
+} AvlTree;
+
+void avlInit(AvlTree* tree);
+
+/**
+* avlLink: Adds a node where a search for its key ended, then rebalances the tree.
+* @param parent - The last node the search visited, or NULL if the tree is empty.
+* @param position - The empty child pointer of parent the search stopped at (&tree->root for an empty tree).
+*/
+void avlLink(AvlTree* tree, AvlLink* node, AvlLink* parent, AvlLink** position);
+
+/**
+* avlErase: Takes the node out of the tree, then rebalances it. The node itself is left to the caller.
+*/
+void avlErase(AvlTree* tree, AvlLink* node);
+
+//In-order iteration; both return NULL past the last node.
+AvlLink* avlFirst(const AvlTree* tree);
+AvlLink* avlNext(const AvlLink* node);
+
+//Post-order iteration, so that every node can be freed once visited: avlNextPostorder only reads
+//nodes not visited yet, and must be called before the given node is freed.
+AvlLink* avlFirstPostorder(const AvlTree* tree);
+AvlLink* avlNextPostorder(const AvlLink* node);
+
+#endif //AVL_TREE_H
@@ -0,0 +1,384 @@
+#define _POSIX_C_SOURCE 200809L //For clock_gettime, getopt and mkstemp under -std=c99.
+
+/**
+* Throughput and latency of every public function in chessSystem.h on seeded synthetic workloads.
+*
+* The workload, fully determined by the options:
+*   - tournaments spread over a set of cities, each with a random group of players;
+*   - a round-robin schedule per tournament (circle method: every player meets every other once);
+*   - half of the tournaments ended, average play time and per-city queries;
+*   - both exports;
+*   - a removal storm of players, then of tournaments.
+*
+* Output is one line per function:
+*   api=<name> ops=<n> seconds=<s> ops_per_sec=<r> p50_ns=<t> p90_ns=<t> p99_ns=<t> max_ns=<t>
+*
+* Usage: chess_bench [-s seed] [-p players] [-t tournaments] [-g group size] [-r removed players] [-w workers] [-a]
+* -a creates the system with chessCreateWithArena.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../chessSystem.h"
+
+#define DEFAULT_SEED 1
+#define DEFAULT_PLAYERS 4000
+#define DEFAULT_TOURNAMENTS 200
+#define DEFAULT_GROUP_SIZE 16
+#define DEFAULT_REMOVED_PLAYERS 400
+#define DEFAULT_WORKERS 4
+#define MAX_GAME_TIME 7200
+#define EXPORT_REPEATS 5
+#define STATISTICS_PATH_TEMPLATE "/tmp/chess_bench_statistics_XXXXXX"
+
+static const char* CITIES[] = {"London", "Paris", "Berlin", "Madrid", "Rome", "Vienna", "Prague", "Warsaw",
+                               "Lisbon", "Dublin", "Oslo", "Helsinki", "Athens", "Budapest", "Zurich", "Haifa"};
+#define CITY_COUNT ((int)(sizeof(CITIES) / sizeof(*CITIES)))
+
+typedef struct BenchOptions_t
+{
+    unsigned int seed;
+    int players;
+    int tournaments;
+    int group_size;
+    int removed_players;
+    int workers;
+    bool arena;
+} BenchOptions;
+
+//Latencies of one function, in nanoseconds.
+typedef struct Recorder_t
+{
+    const char* api;
+    long long* samples;
+    int count;
+    int capacity;
+} Recorder;
+
+static unsigned int random_state;
+
+//Declaring static auxiliary functions:
+static bool parseOptions(int argc, char** argv, BenchOptions* options);
+static unsigned int nextRandom(void);
+static long long now(void);
+static bool record(Recorder* recorder, long long start);
+static int compareSamples(const void* sample1, const void* sample2);
+static void report(Recorder* recorder);
+static void shuffle(int* values, int count);
+
+static bool runWorkload(const BenchOptions* options);
+static bool scheduleRoundRobin(ChessSystem chess, int tournament_id, const int* group, int group_size,
+                               Recorder* recorder);
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, &options))
+    {
+        fprintf(stderr, "Usage: %s [-s seed] [-p players] [-t tournaments] [-g group size] "
+                        "[-r removed players] [-w workers] [-a]\n", argv[0]);
+        return 1;
+    }
+
+    printf("seed=%u players=%d tournaments=%d group_size=%d removed_players=%d workers=%d arena=%d\n",
+           options.seed, options.players, options.tournaments, options.group_size,
+           options.removed_players, options.workers, options.arena);
+    if (!runWorkload(&options))
+    {
+        fprintf(stderr, "chess_bench: the workload failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+
+//Static auxiliary functions:
+static bool parseOptions(int argc, char** argv, BenchOptions* options)
+{
+    options->seed = DEFAULT_SEED;
+    options->players = DEFAULT_PLAYERS;
+    options->tournaments = DEFAULT_TOURNAMENTS;
+    options->group_size = DEFAULT_GROUP_SIZE;
+    options->removed_players = DEFAULT_REMOVED_PLAYERS;
+    options->workers = DEFAULT_WORKERS;
+    options->arena = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:p:t:g:r:w:a")) != -1)
+    {
+        int value = optarg == NULL ? 0 : atoi(optarg);
+        switch (option)
+        {
+            case 's': options->seed = (unsigned int)value; break;
+            case 'p': options->players = value; break;
+            case 't': options->tournaments = value; break;
+            case 'g': options->group_size = value; break;
+            case 'r': options->removed_players = value; break;
+            case 'w': options->workers = value; break;
+            case 'a': options->arena = true; break;
+            default: return false;
+        }
+    }
+
+    if (options->removed_players > options->players)
+    {
+        options->removed_players = options->players;
+    }
+    return options->players >= 2 && options->tournaments > 0 && options->group_size >= 2
+        && options->group_size <= options->players && options->removed_players >= 0 && options->workers > 0;
+}
+
+//xorshift32: the same sequence on every platform, unlike rand().
+static unsigned int nextRandom(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static long long now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+static bool record(Recorder* recorder, long long start)
+{
+    long long latency = now() - start;
+    if (recorder->count == recorder->capacity)
+    {
+        int capacity = recorder->capacity == 0 ? 1024 : 2 * recorder->capacity;
+        long long* samples = realloc(recorder->samples, sizeof(*samples) * capacity);
+        if (samples == NULL)
+        {
+            return false;
+        }
+        recorder->samples = samples;
+        recorder->capacity = capacity;
+    }
+    recorder->samples[recorder->count++] = latency;
+    return true;
+}
+
+static int compareSamples(const void* sample1, const void* sample2)
+{
+    long long first = *(const long long*)sample1, second = *(const long long*)sample2;
+    return (first > second) - (first < second);
+}
+
+static void report(Recorder* recorder)
+{
+    if (recorder->count == 0)
+    {
+        return;
+    }
+
+    long long total = 0;
+    for (int sample = 0; sample < recorder->count; ++sample)
+    {
+        total += recorder->samples[sample];
+    }
+    qsort(recorder->samples, recorder->count, sizeof(*(recorder->samples)), &compareSamples);
+
+    long long* samples = recorder->samples;
+    int last = recorder->count - 1;
+    printf("api=%s ops=%d seconds=%.6f ops_per_sec=%.0f p50_ns=%lld p90_ns=%lld p99_ns=%lld max_ns=%lld\n",
+           recorder->api, recorder->count, total / 1e9, recorder->count / (total / 1e9),
+           samples[last * 50 / 100], samples[last * 90 / 100], samples[last * 99 / 100], samples[last]);
+
+    free(recorder->samples);
+    recorder->samples = NULL;
+    recorder->count = recorder->capacity = 0;
+}
+
+static void shuffle(int* values, int count)
+{
+    for (int current = count - 1; current > 0; --current)
+    {
+        int other = nextRandom() % (current + 1);
+        int temp = values[current];
+        values[current] = values[other];
+        values[other] = temp;
+    }
+}
+
+//Circle method: player 0 stays put while the others rotate, so every round pairs everyone once.
+static bool scheduleRoundRobin(ChessSystem chess, int tournament_id, const int* group, int group_size,
+                               Recorder* recorder)
+{
+    int slots = group_size + group_size % 2; //An odd group gets a bye slot.
+    for (int round = 0; round < slots - 1; ++round)
+    {
+        for (int pair = 0; pair < slots / 2; ++pair)
+        {
+            int first = pair == 0 ? 0 : 1 + (round + pair - 1) % (slots - 1);
+            int second = 1 + (round + slots - 2 - pair) % (slots - 1);
+            if (first >= group_size || second >= group_size)
+            {
+                continue;
+            }
+
+            Winner winner = (Winner)(nextRandom() % 3);
+            int play_time = (int)(nextRandom() % MAX_GAME_TIME);
+            long long start = now();
+            ChessResult result = chessAddGame(chess, tournament_id, group[first], group[second], winner, play_time);
+            if (result != CHESS_SUCCESS || !record(recorder, start))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool runWorkload(const BenchOptions* options)
+{
+    random_state = options->seed == 0 ? 1 : options->seed;
+
+    enum { CREATE, SET_WORKERS, ADD_TOURNAMENT, ADD_GAME, END_TOURNAMENT, AVERAGE_TIME, LOCATION_TOURNAMENTS,
+           LOCATION_STATISTICS, SAVE_LEVELS, SAVE_STATISTICS, REMOVE_PLAYER, REMOVE_TOURNAMENT, DESTROY,
+           API_COUNT };
+    Recorder recorders[API_COUNT] = {
+        {"chessCreate"}, {"chessSetWorkerCount"}, {"chessAddTournament"}, {"chessAddGame"},
+        {"chessEndTournament"}, {"chessCalculateAveragePlayTime"}, {"chessGetLocationTournaments"},
+        {"chessGetLocationStatistics"}, {"chessSavePlayersLevels"}, {"chessSaveTournamentStatistics"},
+        {"chessRemovePlayer"}, {"chessRemoveTournament"}, {"chessDestroy"}
+    };
+
+    int* players = malloc(sizeof(*players) * options->players);
+    int* tournaments = malloc(sizeof(*tournaments) * options->tournaments);
+    int* listed = malloc(sizeof(*listed) * options->tournaments);
+    char statistics_path[] = STATISTICS_PATH_TEMPLATE;
+    int statistics_file = mkstemp(statistics_path);
+    FILE* levels_file = tmpfile();
+    bool success = players != NULL && tournaments != NULL && listed != NULL && statistics_file != -1 && levels_file != NULL;
+    ChessSystem chess = NULL;
+    ChessResult result;
+    long long start;
+
+    if (success)
+    {
+        start = now();
+        chess = options->arena ? chessCreateWithArena() : chessCreate();
+        success = chess != NULL && record(&recorders[CREATE], start);
+    }
+    if (success)
+    {
+        start = now();
+        success = chessSetWorkerCount(chess, options->workers) == CHESS_SUCCESS
+            && record(&recorders[SET_WORKERS], start);
+    }
+
+    for (int player = 0; success && player < options->players; ++player)
+    {
+        players[player] = player + 1;
+    }
+    for (int tournament = 0; success && tournament < options->tournaments; ++tournament)
+    {
+        tournaments[tournament] = tournament + 1;
+    }
+    shuffle(tournaments, options->tournaments);
+
+    //Tournaments and their round-robin schedules:
+    for (int tournament = 0; success && tournament < options->tournaments; ++tournament)
+    {
+        start = now();
+        success = chessAddTournament(chess, tournaments[tournament], options->group_size - 1,
+                                     CITIES[tournaments[tournament] % CITY_COUNT]) == CHESS_SUCCESS
+            && record(&recorders[ADD_TOURNAMENT], start);
+
+        shuffle(players, options->players);
+        success = success && scheduleRoundRobin(chess, tournaments[tournament], players, options->group_size,
+                                                &recorders[ADD_GAME]);
+    }
+
+    //Queries while half of the tournaments end:
+    for (int tournament = 0; success && tournament < options->tournaments; tournament += 2)
+    {
+        start = now();
+        success = chessEndTournament(chess, tournaments[tournament]) == CHESS_SUCCESS
+            && record(&recorders[END_TOURNAMENT], start);
+    }
+    for (int player = 0; success && player < options->players; ++player)
+    {
+        start = now();
+        chessCalculateAveragePlayTime(chess, players[player], &result);
+        success = (result == CHESS_SUCCESS || result == CHESS_PLAYER_NOT_EXIST)
+            && record(&recorders[AVERAGE_TIME], start);
+    }
+    for (int city = 0; success && city < CITY_COUNT; ++city)
+    {
+        ChessLocationStatistics statistics;
+        start = now();
+        chessGetLocationTournaments(chess, CITIES[city], true, listed, options->tournaments, &result);
+        success = result == CHESS_SUCCESS && record(&recorders[LOCATION_TOURNAMENTS], start);
+
+        start = now();
+        success = success && chessGetLocationStatistics(chess, CITIES[city], &statistics) == CHESS_SUCCESS
+            && record(&recorders[LOCATION_STATISTICS], start);
+    }
+
+    //Exports:
+    for (int repeat = 0; success && repeat < EXPORT_REPEATS; ++repeat)
+    {
+        rewind(levels_file);
+        start = now();
+        success = chessSavePlayersLevels(chess, levels_file) == CHESS_SUCCESS
+            && record(&recorders[SAVE_LEVELS], start);
+
+        start = now();
+        success = success && chessSaveTournamentStatistics(chess, statistics_path) == CHESS_SUCCESS
+            && record(&recorders[SAVE_STATISTICS], start);
+    }
+
+    //Removal storms:
+    shuffle(players, options->players);
+    for (int player = 0; success && player < options->removed_players; ++player)
+    {
+        start = now();
+        result = chessRemovePlayer(chess, players[player]);
+        success = (result == CHESS_SUCCESS || result == CHESS_PLAYER_NOT_EXIST)
+            && record(&recorders[REMOVE_PLAYER], start);
+    }
+    for (int tournament = 0; success && tournament < options->tournaments; ++tournament)
+    {
+        start = now();
+        success = chessRemoveTournament(chess, tournament + 1) == CHESS_SUCCESS
+            && record(&recorders[REMOVE_TOURNAMENT], start);
+    }
+
+    if (chess != NULL)
+    {
+        start = now();
+        chessDestroy(chess);
+        success = success && record(&recorders[DESTROY], start);
+    }
+
+    for (int api = 0; api < API_COUNT; ++api)
+    {
+        if (success)
+        {
+            report(&recorders[api]);
+        }
+        free(recorders[api].samples);
+    }
+
+    if (levels_file != NULL)
+    {
+        fclose(levels_file);
+    }
+    if (statistics_file != -1)
+    {
+        close(statistics_file);
+        remove(statistics_path);
+    }
+    free(players);
+    free(tournaments);
+    free(listed);
+    return success;
+}
@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200112L //For clock_gettime and getrusage under -std=c99.
+
+/**
+* Micro-benchmarks of the Map ADT (map.h): mapPut, mapGet, mapRemove, mapCopy and a full MAP_FOREACH,
+* with sequential, random and reverse-ordered int keys, at sizes 10, 100, ..., up to the maximal size.
+*
+* The same source is linked against every engine implementing map.h (see the map_bench targets), so
+* the engines can be compared line by line. map_bench_btree is the in-tree map.c with its maps
+* created by mapCreateBTree, and map_bench_skiplist the same with mapCreateSkipList. The allocations are counted by wrapping malloc, calloc
+* and realloc at link time (-Wl,--wrap=...), which also catches the ones inside a prebuilt
+* library; builds without MAP_BENCH_COUNT_ALLOCATIONS report -1.
+*
+* Output is one line per measurement:
+*   engine=<e> order=<o> size=<n> op=<put|get|foreach|copy|remove> ns_per_op=<t> allocs_per_op=<a> peak_rss_kb=<k>
+* peak_rss_kb is the process peak so far.
+*
+* Sizes grow tenfold. An order stops growing once the next size is predicted (from the growth of
+* the last two sizes) to take longer than the time budget, so quadratic engines finish too.
+*
+* Usage: map_bench [-n maximal size] [-b budget in seconds] [-s seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "../map.h"
+
+#ifndef MAP_BENCH_ENGINE
+#define MAP_BENCH_ENGINE "map"
+#endif
+
+//map_bench_btree and map_bench_skiplist run the in-tree map with its other structures; the other
+//engines only have mapCreate.
+#if defined(MAP_BENCH_BTREE)
+#define BENCH_MAP_CREATE mapCreateBTree
+#elif defined(MAP_BENCH_SKIP_LIST)
+#define BENCH_MAP_CREATE mapCreateSkipList
+#else
+#define BENCH_MAP_CREATE mapCreate
+#endif
+
+#define DEFAULT_MAXIMAL_SIZE 10000000
+#define DEFAULT_BUDGET_SECONDS 2.0
+#define DEFAULT_SEED 1
+#define MINIMAL_SIZE 10
+#define SIZE_GROWTH 10
+
+typedef enum {
+    ORDER_SEQUENTIAL,
+    ORDER_RANDOM,
+    ORDER_REVERSE,
+    ORDER_COUNT
+} KeyOrder;
+
+static const char* ORDER_NAMES[] = {"sequential", "random", "reverse"};
+
+static long long allocation_count;
+
+//Declaring static auxiliary functions:
+static double now(void);
+static long peakRssKb(void);
+static void report(KeyOrder order, int size, const char* op, double seconds, long long allocations, int ops);
+static void fillKeys(int* keys, int size, KeyOrder order, unsigned int* seed);
+static double runCase(KeyOrder order, int size, unsigned int* seed);
+
+static MapDataElement copyInt(MapDataElement element);
+static void freeInt(MapDataElement element);
+static int compareInts(MapKeyElement key1, MapKeyElement key2);
+
+#ifdef MAP_BENCH_COUNT_ALLOCATIONS
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    ++allocation_count;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    ++allocation_count;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size)
+{
+    ++allocation_count;
+    return __real_realloc(pointer, size);
+}
+#else
+#define NO_ALLOCATION_COUNT (-1)
+#endif
+
+int main(int argc, char** argv)
+{
+    int maximal_size = DEFAULT_MAXIMAL_SIZE;
+    double budget = DEFAULT_BUDGET_SECONDS;
+    unsigned int seed = DEFAULT_SEED;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:b:s:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': maximal_size = atoi(optarg); break;
+            case 'b': budget = atof(optarg); break;
+            case 's': seed = (unsigned int)atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n maximal size] [-b budget in seconds] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    for (int order = 0; order < ORDER_COUNT; ++order)
+    {
+        double previous_seconds = 0;
+        for (long size = MINIMAL_SIZE; size <= maximal_size; size *= SIZE_GROWTH)
+        {
+            double seconds = runCase((KeyOrder)order, (int)size, &seed);
+            if (seconds < 0)
+            {
+                fprintf(stderr, "map_bench: out of memory at size %ld\n", size);
+                return 1;
+            }
+
+            double growth = previous_seconds > 0 ? seconds / previous_seconds : SIZE_GROWTH;
+            growth = growth < SIZE_GROWTH ? SIZE_GROWTH : growth;
+            if (seconds * growth > budget)
+            {
+                break;
+            }
+            previous_seconds = seconds;
+        }
+    }
+
+    return 0;
+}
+
+
+//Static auxiliary functions:
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static long peakRssKb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void report(KeyOrder order, int size, const char* op, double seconds, long long allocations, int ops)
+{
+#ifndef MAP_BENCH_COUNT_ALLOCATIONS
+    allocations = NO_ALLOCATION_COUNT * (long long)ops;
+#endif
+    printf("engine=%s order=%s size=%d op=%s ns_per_op=%.1f allocs_per_op=%.2f peak_rss_kb=%ld\n",
+           MAP_BENCH_ENGINE, ORDER_NAMES[order], size, op, seconds * 1e9 / ops,
+           (double)allocations / ops, peakRssKb());
+}
+
+static void fillKeys(int* keys, int size, KeyOrder order, unsigned int* seed)
+{
+    for (int key = 0; key < size; ++key)
+    {
+        keys[key] = order == ORDER_REVERSE ? size - key : key + 1;
+    }
+    if (order != ORDER_RANDOM)
+    {
+        return;
+    }
+
+    for (int key = size - 1; key > 0; --key)
+    {
+        *seed = *seed * 1103515245u + 12345u;
+        int other = (int)((*seed >> 1) % (unsigned int)(key + 1));
+        int temp = keys[key];
+        keys[key] = keys[other];
+        keys[other] = temp;
+    }
+}
+
+//Runs every operation once over size keys. Returns the total time, or -1 if an allocation failed.
+static double runCase(KeyOrder order, int size, unsigned int* seed)
+{
+    int* keys = malloc(sizeof(*keys) * size);
+    Map map = BENCH_MAP_CREATE(&copyInt, &copyInt, &freeInt, &freeInt, &compareInts);
+    if (keys == NULL || map == NULL)
+    {
+        free(keys);
+        mapDestroy(map);
+        return -1;
+    }
+    fillKeys(keys, size, order, seed);
+
+    double total = 0, start, elapsed;
+    long long allocations;
+
+    allocations = allocation_count;
+    start = now();
+    for (int key = 0; key < size; ++key)
+    {
+        if (mapPut(map, &keys[key], &keys[key]) != MAP_SUCCESS)
+        {
+            free(keys);
+            mapDestroy(map);
+            return -1;
+        }
+    }
+    elapsed = now() - start;
+    total += elapsed;
+    report(order, size, "put", elapsed, allocation_count - allocations, size);
+
+    long long checksum = 0;
+    allocations = allocation_count;
+    start = now();
+    for (int key = 0; key < size; ++key)
+    {
+        checksum += *(int*)mapGet(map, &keys[key]);
+    }
+    elapsed = now() - start;
+    total += elapsed;
+    report(order, size, "get", elapsed, allocation_count - allocations, size);
+
+    allocations = allocation_count;
+    start = now();
+    MAP_FOREACH(int*, key, map)
+    {
+        checksum += *key;
+        freeInt(key);
+    }
+    elapsed = now() - start;
+    total += elapsed;
+    report(order, size, "foreach", elapsed, allocation_count - allocations, size);
+
+    allocations = allocation_count;
+    start = now();
+    Map copy = mapCopy(map);
+    elapsed = now() - start;
+    total += elapsed;
+    report(order, size, "copy", elapsed, allocation_count - allocations, size);
+    mapDestroy(copy);
+
+    allocations = allocation_count;
+    start = now();
+    for (int key = 0; key < size; ++key)
+    {
+        mapRemove(map, &keys[key]);
+    }
+    elapsed = now() - start;
+    total += elapsed;
+    report(order, size, "remove", elapsed, allocation_count - allocations, size);
+
+    if (checksum == 0 || copy == NULL)
+    {
+        total = -1;
+    }
+    mapDestroy(map);
+    free(keys);
+    return total;
+}
+
+static MapDataElement copyInt(MapDataElement element)
+{
+    int* copy = malloc(sizeof(*copy));
+    if (copy != NULL)
+    {
+        *copy = *(int*)element;
+    }
+    return copy;
+}
+
+static void freeInt(MapDataElement element)
+{
+    free(element);
+}
+
+static int compareInts(MapKeyElement key1, MapKeyElement key2)
+{
+    return *(int*)key1 - *(int*)key2;
+}
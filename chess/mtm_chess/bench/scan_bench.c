@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200112L //For clock_gettime under -std=c99.
+
+/**
+* Throughput of the tournament game scans (see gameKernels.h), in games per second.
+*
+* Each kernel level runs the two scans (time statistics and a player's play time) over a table of
+* GAME_COUNT games. The same scans are also run as the MAP_FOREACH loop the tournament used before its
+* games were stored in columns. Building that Map is quadratic, so it uses MAP_GAME_COUNT games.
+*
+* Output is one line per run:
+*   scan=<times|player_times> impl=<scalar|sse2|avx2|map_foreach> games=<n> seconds=<s> games_per_sec=<r>
+*
+* Usage: scan_bench [game_count]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../gameKernels.h"
+#include "../map.h"
+
+#define GAME_COUNT 10000000
+#define MAP_GAME_COUNT 20000
+#define PLAYER_COUNT 1000
+#define MAX_GAME_TIME 3600
+#define MINIMAL_SECONDS 0.5
+
+typedef struct BenchGame_t
+{
+    int player1;
+    int player2;
+    int time;
+} BenchGame;
+
+typedef struct BenchTable_t
+{
+    int* player1;
+    int* player2;
+    int* time;
+    int count;
+} BenchTable;
+
+static volatile int sink;
+
+//Declaring static auxiliary functions:
+static double now(void);
+static void report(const char* scan, const char* implementation, long games, double seconds);
+static bool fillTable(BenchTable* table, int count);
+static void benchKernels(const BenchTable* table);
+static void benchMapForeach(const BenchTable* table);
+
+static MapDataElement copyBenchGame(MapDataElement game);
+static MapKeyElement copyGameId(MapKeyElement id);
+static void freeElement(void* element);
+static int compareGameIds(MapKeyElement first, MapKeyElement second);
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : GAME_COUNT;
+    BenchTable table;
+    if (count <= 0 || !fillTable(&table, count))
+    {
+        fprintf(stderr, "scan_bench: could not create %d games\n", count);
+        return 1;
+    }
+
+    benchKernels(&table);
+    table.count = table.count < MAP_GAME_COUNT ? table.count : MAP_GAME_COUNT;
+    benchMapForeach(&table);
+
+    free(table.player1);
+    free(table.player2);
+    free(table.time);
+    return 0;
+}
+
+
+//Static auxiliary functions:
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void report(const char* scan, const char* implementation, long games, double seconds)
+{
+    printf("scan=%s impl=%s games=%ld seconds=%.6f games_per_sec=%.0f\n",
+           scan, implementation, games, seconds, games / seconds);
+}
+
+static bool fillTable(BenchTable* table, int count)
+{
+    table->player1 = malloc(sizeof(int) * count);
+    table->player2 = malloc(sizeof(int) * count);
+    table->time = malloc(sizeof(int) * count);
+    table->count = count;
+    if (table->player1 == NULL || table->player2 == NULL || table->time == NULL)
+    {
+        free(table->player1);
+        free(table->player2);
+        free(table->time);
+        return false;
+    }
+
+    srand(1);
+    for (int game = 0; game < count; ++game)
+    {
+        table->player1[game] = 1 + rand() % PLAYER_COUNT;
+        table->player2[game] = 1 + (table->player1[game] + rand() % (PLAYER_COUNT - 1)) % PLAYER_COUNT;
+        table->time[game] = rand() % MAX_GAME_TIME;
+    }
+    return true;
+}
+
+static void benchKernels(const BenchTable* table)
+{
+    const GameKernelsLevel levels[] = {GAME_KERNELS_SCALAR, GAME_KERNELS_SSE2, GAME_KERNELS_AVX2};
+    const char* names[] = {"scalar", "sse2", "avx2"};
+    GameKernelsLevel best = getGameKernelsLevel();
+
+    for (int level = 0; level < (int)(sizeof(levels) / sizeof(*levels)); ++level)
+    {
+        if (!setGameKernelsLevel(levels[level]))
+        {
+            continue;
+        }
+
+        long games = 0;
+        double start = now(), elapsed;
+        do
+        {
+            int longest, total;
+            scanGameTimes(table->time, table->count, &longest, &total);
+            sink = longest + total;
+            games += table->count;
+        } while ((elapsed = now() - start) < MINIMAL_SECONDS);
+        report("times", names[level], games, elapsed);
+
+        games = 0;
+        start = now();
+        do
+        {
+            int game_count;
+            sink = scanPlayerGameTimes(table->player1, table->player2, table->time, table->count,
+                                       1 + games % PLAYER_COUNT, &game_count);
+            games += table->count;
+        } while ((elapsed = now() - start) < MINIMAL_SECONDS);
+        report("player_times", names[level], games, elapsed);
+    }
+
+    setGameKernelsLevel(best);
+}
+
+static void benchMapForeach(const BenchTable* table)
+{
+    Map games = mapCreate(&copyBenchGame, &copyGameId, &freeElement, &freeElement, &compareGameIds);
+    if (games == NULL)
+    {
+        return;
+    }
+    for (int game = 0; game < table->count; ++game)
+    {
+        int id = game + 1;
+        BenchGame data = {table->player1[game], table->player2[game], table->time[game]};
+        if (mapPut(games, &id, &data) != MAP_SUCCESS)
+        {
+            mapDestroy(games);
+            return;
+        }
+    }
+
+    long scanned = 0;
+    double start = now(), elapsed;
+    do
+    {
+        int longest = 0, total = 0;
+        MAP_FOREACH(int*, game_id, games)
+        {
+            BenchGame* game = mapGet(games, game_id);
+            longest = game->time > longest ? game->time : longest;
+            total += game->time;
+            free(game_id);
+        }
+        sink = longest + total;
+        scanned += table->count;
+    } while ((elapsed = now() - start) < MINIMAL_SECONDS);
+    report("times", "map_foreach", scanned, elapsed);
+
+    scanned = 0;
+    start = now();
+    do
+    {
+        int player_id = 1 + scanned % PLAYER_COUNT, total = 0;
+        MAP_FOREACH(int*, game_id, games)
+        {
+            BenchGame* game = mapGet(games, game_id);
+            if (game->player1 == player_id || game->player2 == player_id)
+            {
+                total += game->time;
+            }
+            free(game_id);
+        }
+        sink = total;
+        scanned += table->count;
+    } while ((elapsed = now() - start) < MINIMAL_SECONDS);
+    report("player_times", "map_foreach", scanned, elapsed);
+
+    mapDestroy(games);
+}
+
+static MapDataElement copyBenchGame(MapDataElement game)
+{
+    BenchGame* copy = malloc(sizeof(*copy));
+    if (copy != NULL)
+    {
+        *copy = *(BenchGame*)game;
+    }
+    return copy;
+}
+
+static MapKeyElement copyGameId(MapKeyElement id)
+{
+    int* copy = malloc(sizeof(*copy));
+    if (copy != NULL)
+    {
+        *copy = *(int*)id;
+    }
+    return copy;
+}
+
+static void freeElement(void* element)
+{
+    free(element);
+}
+
+static int compareGameIds(MapKeyElement first, MapKeyElement second)
+{
+    return *(int*)first - *(int*)second;
+}
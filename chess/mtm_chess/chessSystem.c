@@ -1,8 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <math.h>
 #include "chessSystem.h"
-#include "map.h"
+#include "arena.h"
+#include "executor.h"
+#include "location.h"
+#include "memoryStats.h"
+#include "metrics.h"
 #include "player.h"
 #include "tournament.h"
 
@@ -27,77 +32,283 @@ GOLLUM:
 
 #define INVALID -1
 
+//Number of executor workers of a new chess system, until changed by chessSetWorkerCount.
+#define DEFAULT_WORKER_COUNT 4
+//Upper bound on the number of pieces an export is split into.
+#define MAX_EXPORT_CHUNKS 64
+//Below this many items per worker, splitting the work costs more than it saves.
+#define MINIMAL_PLAYERS_PER_THREAD 2048
+#define MINIMAL_TOURNAMENTS_PER_THREAD 64
+//Tournaments scanned by a single task in the cross-tournament scans.
+#define TOURNAMENTS_PER_TASK 8
+//Longest possible "<id> <level>\n" line: an int id, a level in [-10, 6] (or nan) and the separators.
+#define LEVEL_LINE_MAX_LENGTH 32
+//Longest possible statistics block, not counting the location: five ints, an average and the newlines.
+#define STATISTICS_BLOCK_MAX_LENGTH 128
+
+//The players in printing order as of the last chessSavePlayersLevels, with the levels printed then.
+//The next export only sorts the players changed since (see isPlayerLevelDirty) and merges them back in.
+typedef struct LevelOrder_t
+{
+    int* ids;
+    double* levels;
+    int size;
+    //False before the first export: every player is sorted then.
+    bool valid;
+} LevelOrder;
+
 struct chess_system_t
 {
-    Map players;
-    Map tournaments;
+    //Every player id met so far, with the results of the players in the system (see player.h).
+    PlayerTable players;
+    //The system owns the tournaments linked into this balanced tree (see typedMap.h).
+    TournamentMap tournaments;
+    //Every tournament's location, stored once per distinct string. Each location also indexes
+    //the tournaments stored in it.
+    LocationTable locations;
+    //Set by chessCreateWithArena: the tournaments are allocated from it.
+    Arena arena;
 
     //Used in saveTournamentStatistics because the "no tournaments ended" takes precedence
     //over the "save failure" error.
     bool tournament_ended;
+
+    //Runs the scans over all tournaments and the exports. Created on first use;
+    //NULL while everything runs on the calling thread.
+    Executor executor;
+    int worker_count;
+
+    LevelOrder level_order;
 };
 
+//The public functions record their calls and latencies (see metrics.h) around these:
+static ChessSystem chessCreateImpl(bool use_arena);
+static void chessDestroyImpl(ChessSystem chess);
+static ChessResult chessSetWorkerCountImpl(ChessSystem chess, int worker_count);
+static ChessResult chessAddTournamentImpl(ChessSystem chess, int tournament_id, int max_games_per_player,
+                                          const char* tournament_location);
+static ChessResult chessAddGameImpl(ChessSystem chess, int tournament_id, int first_player, int second_player,
+                                    Winner winner, int play_time);
+static ChessResult chessRemoveTournamentImpl(ChessSystem chess, int tournament_id);
+static ChessResult chessRemovePlayerImpl(ChessSystem chess, int player_id);
+static ChessResult chessEndTournamentImpl(ChessSystem chess, int tournament_id);
+static double chessCalculateAveragePlayTimeImpl(ChessSystem chess, int player_id, ChessResult* chess_result);
+static ChessResult chessSavePlayersLevelsImpl(ChessSystem chess, FILE* file);
+static ChessResult chessSaveTournamentStatisticsImpl(ChessSystem chess, char* path_file);
+static int chessGetLocationTournamentsImpl(ChessSystem chess, const char* location, bool ended_only,
+                                           int* tournament_ids, int max_count, ChessResult* chess_result);
+static ChessResult chessGetLocationStatisticsImpl(ChessSystem chess, const char* location,
+                                                  ChessLocationStatistics* statistics);
+static int chessGetCommonPlayersImpl(ChessSystem chess, int first_tournament, int second_tournament,
+                                     int* player_ids, int max_count, ChessResult* chess_result);
+static ChessResult chessGetMemoryStatsImpl(ChessMemoryStats* statistics);
+
+//Returns the system's executor, creating it on first use.
+//NULL (running everything on the calling thread) if there's a single worker or the creation failed.
+static Executor getExecutor(ChessSystem chess);
+static int exportChunkCount(ChessSystem chess, int item_count, int minimal_items_per_chunk);
+//Puts the tournaments in id order into the given array, which must fit all of them.
+//Returns the number of tournaments put.
+static int gatherTournaments(ChessSystem chess, Tournament* tournaments, bool finished_only);
+static int compareIds(const void* id1, const void* id2);
+
 //Declaring those for use in chessSavePlayersLevels:
-static void swapIntegers(int *a, int *b);
-static void swapDoubles(double *a, double *b);
-static int partition(int *ids, double *levels, int length);
-static void quicksort(int *ids, double *levels, int length);
+
+//Forgets the order; the next export sorts every player.
+static void invalidateLevelOrder(LevelOrder* order);
+
+//One thread's share of the levels pipeline: a [begin, end) range of the players array.
+typedef struct LevelsChunk_t
+{
+    Player* players;
+    int* ids;
+    double* levels;
+    int begin;
+    int end;
+
+    //Merge phase: merges the sorted runs [begin, middle) and [middle, end) of the source arrays.
+    int middle;
+    int* destination_ids;
+    double* destination_levels;
+
+    //Formatting phase:
+    char* buffer;
+    size_t length;
+} LevelsChunk;
+
+static bool precedesInLevelOrder(int id1, double level1, int id2, double level2);
+static void mergeLevelRuns(const int* ids, const double* levels, int begin, int middle, int end,
+                           int* destination_ids, double* destination_levels);
+static void mergeSortLevels(int* ids, double* levels, int* temp_ids, double* temp_levels, int length);
+//Executor range functions; each handles the chunks [begin, end) of the given chunks array.
+static void computeLevelsWorker(void* chunks, int begin, int end);
+static void sortLevelsWorker(void* chunks, int begin, int end);
+static void mergeLevelsWorker(void* chunks, int begin, int end);
+static void formatLevelsWorker(void* chunks, int begin, int end);
+//Sorts ids/levels into printing order: each chunk is sorted separately, then the runs are merged pairwise.
+//Returns false if the temporary arrays could not be allocated.
+static bool parallelSortLevels(Executor executor, LevelsChunk* chunks, int chunk_count, int size);
+
+//Declaring those for use in chessSaveTournamentStatistics:
+
+//One thread's share of the statistics export: a [begin, end) range of the finished tournaments,
+//formatted into a single buffer.
+typedef struct StatisticsChunk_t
+{
+    Tournament* tournaments;
+    int begin;
+    int end;
+    char* buffer;
+    size_t length;
+} StatisticsChunk;
+
+static void formatStatisticsWorker(void* chunks, int begin, int end);
+
+//Declaring those for use in the scans over all tournaments:
+
+typedef struct RemovePlayerScan_t
+{
+    Tournament* tournaments;
+    int player_index;
+    //Tournament i puts the opponents which now win a forfeited game at promoted + offsets[i],
+    //and their number at promoted_counts[i].
+    int* offsets;
+    int* promoted;
+    int* promoted_counts;
+} RemovePlayerScan;
+
+typedef struct PlayTimeScan_t
+{
+    Tournament* tournaments;
+    int player_index;
+    int* total_times;
+    int* game_counts;
+} PlayTimeScan;
+
+static void removePlayerWorker(void* scan, int begin, int end);
+static void playTimeWorker(void* scan, int begin, int end);
 
 //Construction & destruction:
-ChessSystem chessCreate()                 
+ChessSystem chessCreate(void)
+{
+    long long start = metricsStart();
+    ChessSystem chess = chessCreateImpl(false);
+    metricsRecord(METRICS_CHESS_CREATE, start, chess == NULL);
+    return chess;
+}
+
+ChessSystem chessCreateWithArena(void)
+{
+    long long start = metricsStart();
+    ChessSystem chess = chessCreateImpl(true);
+    metricsRecord(METRICS_CHESS_CREATE_WITH_ARENA, start, chess == NULL);
+    return chess;
+}
+
+static ChessSystem chessCreateImpl(bool use_arena)
 {   
-    Map tournaments = mapCreate(&mapTournamentCopy,
-                                &mapTournamentIdCopy,
-                                &mapTournamentDataFree,
-                                &mapTournamentIdFree,
-                                &mapTournamentKeyCompare);
-    
-    if(tournaments == NULL)
+    Arena arena = NULL;
+    if(use_arena && (arena = arenaCreate(MEMORY_ARENAS)) == NULL)
     {
         return NULL;
     }
 
-    Map players = mapCreate(&mapPlayerCopy,
-                                &mapPlayerIdCopy,
-                                &mapPlayerDataFree,
-                                &mapPlayerIdFree,
-                                &mapPlayerKeyCompare);
-
-    if(players == NULL)
+    LocationTable locations = createLocationTable();
+    if(locations == NULL)
     {
-        mapDestroy(tournaments);
+        arenaDestroy(arena);
         return NULL;
     }
 
-    ChessSystem chess_system = malloc(sizeof(*chess_system));
+    ChessSystem chess_system = trackedMalloc(MEMORY_SYSTEMS, sizeof(*chess_system));
     if(chess_system == NULL)
     {
-        mapDestroy(tournaments);
-        mapDestroy(players);
+        destroyLocationTable(locations);
+        arenaDestroy(arena);
         return NULL;
     }
 
-    chess_system->tournaments = tournaments;
-    chess_system->players = players;
+    tournamentMapInit(&chess_system->tournaments);
+    initPlayerTable(&chess_system->players);
+    chess_system->locations = locations;
+    chess_system->arena = arena;
     chess_system->tournament_ended = false;
+    chess_system->executor = NULL;
+    chess_system->worker_count = DEFAULT_WORKER_COUNT;
+    chess_system->level_order = (LevelOrder){ NULL, NULL, 0, false };
 
     return chess_system;        
 }
 
 void chessDestroy(ChessSystem chess)
+{
+    long long start = metricsStart();
+    chessDestroyImpl(chess);
+    metricsRecord(METRICS_CHESS_DESTROY, start, false);
+}
+
+static void chessDestroyImpl(ChessSystem chess)
 {
     if(chess == NULL)
     {
         return;
     }
 
-    mapDestroy(chess->tournaments);
-    mapDestroy(chess->players);
-    free(chess);
+    //Tournaments are freed one by one even from the arena, as they hold arenas and location references
+    //of their own. Their games go with their arenas.
+    Tournament tournament = tournamentMapFirstPostorder(&chess->tournaments);
+    while (tournament != NULL)
+    {
+        Tournament next = tournamentMapNextPostorder(&chess->tournaments, tournament);
+        freeTournament(tournament, chess->arena);
+        tournament = next;
+    }
+    freePlayerTable(&chess->players);
+    destroyLocationTable(chess->locations);
+    arenaDestroy(chess->arena);
+    executorDestroy(chess->executor);
+    invalidateLevelOrder(&chess->level_order);
+    trackedFree(MEMORY_SYSTEMS, chess, sizeof(*chess));
+}
+
+ChessResult chessSetWorkerCount(ChessSystem chess, int worker_count)
+{
+    long long start = metricsStart();
+    ChessResult result = chessSetWorkerCountImpl(chess, worker_count);
+    metricsRecord(METRICS_CHESS_SET_WORKER_COUNT, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessSetWorkerCountImpl(ChessSystem chess, int worker_count)
+{
+    if (chess == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if (worker_count <= 0)
+    {
+        return CHESS_INVALID_WORKER_COUNT;
+    }
+
+    //The new executor is created on the next parallel scan.
+    executorDestroy(chess->executor);
+    chess->executor = NULL;
+    chess->worker_count = worker_count;
+
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessAddTournament(ChessSystem chess, int tournament_id, int max_games_per_player,
+                               const char* tournament_location)
+{
+    long long start = metricsStart();
+    ChessResult result = chessAddTournamentImpl(chess, tournament_id, max_games_per_player, tournament_location);
+    metricsRecord(METRICS_CHESS_ADD_TOURNAMENT, start, result != CHESS_SUCCESS);
+    return result;
 }
 
-ChessResult chessAddTournament (ChessSystem chess, int tournament_id,
-                                int max_games_per_player, const char* tournament_location)
+static ChessResult chessAddTournamentImpl(ChessSystem chess, int tournament_id, int max_games_per_player,
+                                          const char* tournament_location)
 {
     if(tournament_location == NULL || chess == NULL)
     {
@@ -107,15 +318,15 @@ ChessResult chessAddTournament (ChessSystem chess, int tournament_id,
     {
         return CHESS_INVALID_ID;
     }
-    if(mapContains(chess->tournaments, &tournament_id))
+    if(tournamentMapGet(&chess->tournaments, tournament_id) != NULL)
     {
         return CHESS_TOURNAMENT_ALREADY_EXISTS;
     }
 
     ChessResult error;
 
-    Tournament tournament = createTournament(tournament_id, tournament_location,
-                            max_games_per_player, &error);
+    Tournament tournament = createTournament(tournament_id, chess->locations, tournament_location,
+                            max_games_per_player, chess->arena, &error);
 
     if(tournament == NULL)
     {
@@ -125,22 +336,28 @@ ChessResult chessAddTournament (ChessSystem chess, int tournament_id,
         }
         return error;
     }
+    tournamentMapInsert(&chess->tournaments, tournament);
 
-    MapResult result = mapPut(chess->tournaments, &tournament_id, tournament);
-    freeTournament(tournament);
-
-    if(result == MAP_OUT_OF_MEMORY)
+    if(!addLocationTournament(getLocationHandle(tournament), tournament_id, tournament))
     {
         chessDestroy(chess);
         return CHESS_OUT_OF_MEMORY;
     }
-    assert(result != MAP_NULL_ARGUMENT);
     
     return CHESS_SUCCESS;
 }
 
-ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player,
-                         int second_player, Winner winner, int play_time)
+ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player, int second_player,
+                         Winner winner, int play_time)
+{
+    long long start = metricsStart();
+    ChessResult result = chessAddGameImpl(chess, tournament_id, first_player, second_player, winner, play_time);
+    metricsRecord(METRICS_CHESS_ADD_GAME, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessAddGameImpl(ChessSystem chess, int tournament_id, int first_player, int second_player,
+                                    Winner winner, int play_time)
 {
     if(chess == NULL)
     {
@@ -152,15 +369,40 @@ ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player,
         return CHESS_INVALID_ID;
     }
 
-    Tournament tournament = mapGet(chess->tournaments, &tournament_id);
+    Tournament tournament = tournamentMapGet(&chess->tournaments, tournament_id);
 
     if (tournament == NULL)
     {
         return CHESS_TOURNAMENT_NOT_EXIST;
     }
 
+    //New ids are only given indices once their game is known to be accepted, so rejected games
+    //don't grow the table.
+    int first_index = findPlayerIndex(&chess->players, first_player);
+    int second_index = findPlayerIndex(&chess->players, second_player);
+    if (first_index == NO_PLAYER_INDEX || second_index == NO_PLAYER_INDEX)
+    {
+        ChessResult error = validateGame(tournament, first_index, second_index, play_time);
+        if (error == CHESS_SUCCESS && first_player == second_player)
+        {
+            error = CHESS_INVALID_ID;
+        }
+        if (error != CHESS_SUCCESS)
+        {
+            return error;
+        }
+
+        first_index = addPlayerIndex(&chess->players, first_player);
+        second_index = addPlayerIndex(&chess->players, second_player);
+        if (first_index == NO_PLAYER_INDEX || second_index == NO_PLAYER_INDEX)
+        {
+            chessDestroy(chess);
+            return CHESS_OUT_OF_MEMORY;
+        }
+    }
+
     ChessResult error =
-            addGameToTournament(tournament, first_player, second_player, winner, play_time, chess->players);
+            addGameToTournament(tournament, first_index, second_index, winner, play_time, &chess->players);
     
     if (error == CHESS_OUT_OF_MEMORY)
     {
@@ -169,7 +411,15 @@ ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player,
     return error;
 }
 
-ChessResult chessRemoveTournament (ChessSystem chess, int tournament_id)
+ChessResult chessRemoveTournament(ChessSystem chess, int tournament_id)
+{
+    long long start = metricsStart();
+    ChessResult result = chessRemoveTournamentImpl(chess, tournament_id);
+    metricsRecord(METRICS_CHESS_REMOVE_TOURNAMENT, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessRemoveTournamentImpl(ChessSystem chess, int tournament_id)
 {  
     if(chess == NULL)
     {
@@ -180,21 +430,35 @@ ChessResult chessRemoveTournament (ChessSystem chess, int tournament_id)
         return CHESS_INVALID_ID;
     }
     
-    Tournament tournament = mapGet(chess->tournaments, &tournament_id);
+    Tournament tournament = tournamentMapGet(&chess->tournaments, tournament_id);
     if(tournament == NULL)
     {
         return CHESS_TOURNAMENT_NOT_EXIST;
     }
     
-    removeTournamentFromStatistics(tournament, chess->players);
+    if (removeTournamentFromStatistics(tournament, &chess->players) == CHESS_OUT_OF_MEMORY)
+    {
+        chessDestroy(chess);
+        return CHESS_OUT_OF_MEMORY;
+    }
+    removeLocationTournament(getLocationHandle(tournament), tournament_id);
     
-    mapRemove(chess->tournaments, &tournament_id);
+    tournamentMapRemove(&chess->tournaments, tournament);
+    freeTournament(tournament, chess->arena);
     
     return CHESS_SUCCESS;
 }
 
 
 ChessResult chessRemovePlayer(ChessSystem chess, int player_id)
+{
+    long long start = metricsStart();
+    ChessResult result = chessRemovePlayerImpl(chess, player_id);
+    metricsRecord(METRICS_CHESS_REMOVE_PLAYER, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessRemovePlayerImpl(ChessSystem chess, int player_id)
 {
     if (chess == NULL)
     {
@@ -205,51 +469,91 @@ ChessResult chessRemovePlayer(ChessSystem chess, int player_id)
         return CHESS_INVALID_ID;
     }
 
-    Player player = mapGet(chess->players, &player_id);
-    if(player == NULL)
+    int player_index = findPlayerIndex(&chess->players, player_id);
+    if(getPlayerAt(&chess->players, player_index) == NULL)
     {
         return CHESS_PLAYER_NOT_EXIST;
     }
 
-    Tournament tournament;
     ChessResult error = CHESS_SUCCESS;
-
-    MAP_FOREACH(int*, current_tournament, chess->tournaments)
+    int tournament_count = tournamentMapGetSize(&chess->tournaments);
+    RemovePlayerScan scan = { NULL, player_index, NULL, NULL, NULL };
+    //Room for one more than needed, as malloc(0) may return NULL for a system without tournaments.
+    scan.tournaments = malloc(sizeof(*(scan.tournaments)) * (tournament_count + 1));
+    scan.offsets = malloc(sizeof(*(scan.offsets)) * (tournament_count + 1));
+    scan.promoted_counts = malloc(sizeof(*(scan.promoted_counts)) * (tournament_count + 1));
+
+    if (scan.tournaments == NULL || scan.offsets == NULL || scan.promoted_counts == NULL)
     {
-        tournament = mapGet(chess->tournaments, current_tournament);
-        if (isFinished(tournament))
+        error = CHESS_OUT_OF_MEMORY;
+    }
+    else
+    {
+        //Finished tournaments are not affected by the removal.
+        tournament_count = gatherTournaments(chess, scan.tournaments, false);
+        int game_count = 0;
+        for (int current = 0; current < tournament_count; ++current)
         {
-            free(current_tournament);
-            continue;
+            scan.offsets[current] = game_count;
+            game_count += isFinished(scan.tournaments[current]) ? 0 : getGameCount(scan.tournaments[current]);
         }
-        error = removePlayer(tournament, player_id, chess->players);
-        free(current_tournament);
-        if (error != CHESS_SUCCESS)
+
+        scan.promoted = malloc(sizeof(*(scan.promoted)) * (game_count + 1));
+        if (scan.promoted == NULL)
         {
-            break;
+            error = CHESS_OUT_OF_MEMORY;
         }
     }
 
     if (error == CHESS_SUCCESS)
     {
-        MapResult result = mapRemove(chess->players, &player_id); //This also frees it.
-        if (result == MAP_OUT_OF_MEMORY)
-        {
-            error = CHESS_OUT_OF_MEMORY;
-            chessDestroy(chess);
-        }
-        else if (result == MAP_NULL_ARGUMENT)
+        //Each tournament only touches its own games, so they are scanned in parallel.
+        //Player statistics are shared between tournaments, so they're updated afterwards.
+        executorParallelFor(getExecutor(chess), 0, tournament_count, TOURNAMENTS_PER_TASK,
+                            &removePlayerWorker, &scan);
+
+        for (int current = 0; current < tournament_count; ++current)
         {
-            error = CHESS_NULL_ARGUMENT;
+            for (int promoted = 0; promoted < scan.promoted_counts[current]; ++promoted)
+            {
+                int opponent_index = scan.promoted[scan.offsets[current] + promoted];
+                Player opponent = getPlayerAt(&chess->players, opponent_index);
+                assert(opponent != NULL);
+                increaseWins(opponent);
+                decreaseLosses(opponent);
+            }
         }
+    }
+
+    free(scan.tournaments);
+    free(scan.offsets);
+    free(scan.promoted);
+    free(scan.promoted_counts);
+
+    if (error == CHESS_OUT_OF_MEMORY)
+    {
+        chessDestroy(chess);
+        return error;
+    }
 
-        assert(result != MAP_ITEM_DOES_NOT_EXIST);
+    if (error == CHESS_SUCCESS)
+    {
+        //The next export drops the player from the order, as it's no longer in the table.
+        removePlayer(&chess->players, player_index);
     }
     
     return error;
 }
 
-ChessResult chessEndTournament (ChessSystem chess, int tournament_id)
+ChessResult chessEndTournament(ChessSystem chess, int tournament_id)
+{
+    long long start = metricsStart();
+    ChessResult result = chessEndTournamentImpl(chess, tournament_id);
+    metricsRecord(METRICS_CHESS_END_TOURNAMENT, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessEndTournamentImpl(ChessSystem chess, int tournament_id)
 {
     if (chess == NULL)
     {
@@ -259,22 +563,35 @@ ChessResult chessEndTournament (ChessSystem chess, int tournament_id)
     {
         return CHESS_INVALID_ID;
     }
-    Tournament tournament = mapGet(chess->tournaments, &tournament_id);
+    Tournament tournament = tournamentMapGet(&chess->tournaments, tournament_id);
 
     if (tournament == NULL)
     {
         return CHESS_TOURNAMENT_NOT_EXIST;
     }
 
-    ChessResult error = endTournament(tournament);
+    ChessResult error = endTournament(tournament, &chess->players);
     if (error == CHESS_SUCCESS)
     {
         chess->tournament_ended = true;
     }
+    else if (error == CHESS_OUT_OF_MEMORY)
+    {
+        chessDestroy(chess);
+    }
     return error;
 }
 
-double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessResult* chess_result)
+double chessCalculateAveragePlayTime(ChessSystem chess, int player_id, ChessResult* chess_result)
+{
+    long long start = metricsStart();
+    double value = chessCalculateAveragePlayTimeImpl(chess, player_id, chess_result);
+    metricsRecord(METRICS_CHESS_CALCULATE_AVERAGE_PLAY_TIME, start,
+                  chess_result != NULL && *chess_result != CHESS_SUCCESS);
+    return value;
+}
+
+static double chessCalculateAveragePlayTimeImpl(ChessSystem chess, int player_id, ChessResult* chess_result)
 {
     if(chess_result == NULL || chess == NULL)
     {
@@ -288,19 +605,45 @@ double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessRes
         return INVALID;
     }
 
+    //Removed players are still found: their games in ended tournaments count.
+    int player_index = findPlayerIndex(&chess->players, player_id);
+    if (player_index == NO_PLAYER_INDEX)
+    {
+        *chess_result = CHESS_PLAYER_NOT_EXIST;
+        return INVALID;
+    }
+
     double total_time = 0;
-    int num_of_games = 0, tournament_games;
-    
-    MAP_FOREACH(int*, current_tournament_id, chess->tournaments)
+    int num_of_games = 0;
+    int tournament_count = tournamentMapGetSize(&chess->tournaments);
+    PlayTimeScan scan = { NULL, player_index, NULL, NULL };
+    //Room for one more than needed, as malloc(0) may return NULL for a system without tournaments.
+    scan.tournaments = malloc(sizeof(*(scan.tournaments)) * (tournament_count + 1));
+    scan.total_times = malloc(sizeof(*(scan.total_times)) * (tournament_count + 1));
+    scan.game_counts = malloc(sizeof(*(scan.game_counts)) * (tournament_count + 1));
+    if (scan.tournaments == NULL || scan.total_times == NULL || scan.game_counts == NULL)
     {
-        Tournament tournament = mapGet(chess->tournaments, current_tournament_id);
-        assert(tournament != NULL);
+        free(scan.tournaments);
+        free(scan.total_times);
+        free(scan.game_counts);
+        chessDestroy(chess);
+        *chess_result = CHESS_OUT_OF_MEMORY;
+        return INVALID;
+    }
 
-        total_time += getTotalPlayerPlayTime(tournament, player_id, &tournament_games);
-        num_of_games += tournament_games;
+    tournament_count = gatherTournaments(chess, scan.tournaments, false);
+    executorParallelFor(getExecutor(chess), 0, tournament_count, TOURNAMENTS_PER_TASK,
+                        &playTimeWorker, &scan);
 
-        free(current_tournament_id);
+    for (int current = 0; current < tournament_count; ++current)
+    {
+        total_time += scan.total_times[current];
+        num_of_games += scan.game_counts[current];
     }
+
+    free(scan.tournaments);
+    free(scan.total_times);
+    free(scan.game_counts);
      
     if(num_of_games == 0)
     {
@@ -314,64 +657,166 @@ double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessRes
     return avg_time;
 }
 
-ChessResult chessSavePlayersLevels (ChessSystem chess, FILE* file)
+ChessResult chessSavePlayersLevels(ChessSystem chess, FILE* file)
+{
+    long long start = metricsStart();
+    ChessResult result = chessSavePlayersLevelsImpl(chess, file);
+    metricsRecord(METRICS_CHESS_SAVE_PLAYERS_LEVELS, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessSavePlayersLevelsImpl(ChessSystem chess, FILE* file)
 {
     if (chess == NULL || file == NULL)
     {
         return CHESS_NULL_ARGUMENT;
     }
-    double player_level;
-    Player current_player;
-    int wins, losses, draws;
-    int counter = 0;
-    int size = mapGetSize(chess->players);
-
-    double* player_levels = malloc(sizeof(*player_levels) * size);
-    if(player_levels == NULL)
+    LevelOrder* order = &chess->level_order;
+    PlayerTable* players = &chess->players;
+    int size = getPlayerTableSize(players);
+    int thread_count = exportChunkCount(chess, size, MINIMAL_PLAYERS_PER_THREAD);
+    Executor executor = getExecutor(chess);
+
+    //ids/player_levels hold the kept entries of the order, followed by the changed players.
+    //Each array has room for one more player, as malloc(0) may return NULL for a system without players.
+    double* player_levels = malloc(sizeof(*player_levels) * (size + 1));
+    int* ids = malloc(sizeof(*ids) * (size + 1));
+    Player* changed_players = malloc(sizeof(*changed_players) * (size + 1));
+    int* changed_ids = malloc(sizeof(*changed_ids) * (size + 1));
+    //The order is kept for the next export, so it is counted with the players.
+    double* order_levels = trackedMalloc(MEMORY_PLAYERS, sizeof(*order_levels) * (size + 1));
+    int* order_ids = trackedMalloc(MEMORY_PLAYERS, sizeof(*order_ids) * (size + 1));
+    LevelsChunk* chunks = malloc(sizeof(*chunks) * thread_count);
+    if(player_levels == NULL || ids == NULL || changed_players == NULL || changed_ids == NULL
+       || order_levels == NULL || order_ids == NULL || chunks == NULL)
     {
+        free(player_levels);
+        free(ids);
+        free(changed_players);
+        free(changed_ids);
+        trackedFree(MEMORY_PLAYERS, order_levels, sizeof(*order_levels) * (size + 1));
+        trackedFree(MEMORY_PLAYERS, order_ids, sizeof(*order_ids) * (size + 1));
+        free(chunks);
         chessDestroy(chess);
         return CHESS_OUT_OF_MEMORY;
     }
-    int* ids = malloc(sizeof(*ids) * size);
-    if(ids == NULL)
+
+    //Gathering the changed players is a single pass over the table's arrays.
+    int changed_count = 0;
+    int index_bound = getPlayerIndexBound(players);
+    for (int player_index = NO_PLAYER_INDEX + 1; player_index < index_bound; ++player_index)
     {
+        Player player = getPlayerAt(players, player_index);
+        if (player != NULL && (!order->valid || isPlayerLevelDirty(player)))
+        {
+            changed_players[changed_count] = player;
+            changed_ids[changed_count++] = getIndexedPlayerId(players, player_index);
+        }
+    }
+
+    //Dropping the stale entries (players changed or removed since) keeps the rest of the order sorted.
+    int kept_count = 0;
+    for (int current = 0; current < order->size; ++current)
+    {
+        Player player = getPlayerAt(players, findPlayerIndex(players, order->ids[current]));
+        if (player != NULL && !isPlayerLevelDirty(player))
+        {
+            ids[kept_count] = order->ids[current];
+            player_levels[kept_count++] = order->levels[current];
+        }
+    }
+    assert(kept_count + changed_count == size);
+    memcpy(ids + kept_count, changed_ids, sizeof(*ids) * changed_count);
+
+    //Only the changed players are computed and sorted, then merged into the kept ones.
+    int changed_thread_count = exportChunkCount(chess, changed_count, MINIMAL_PLAYERS_PER_THREAD);
+    for (int current = 0; current < changed_thread_count; ++current)
+    {
+        chunks[current].players = changed_players;
+        chunks[current].ids = ids + kept_count;
+        chunks[current].levels = player_levels + kept_count;
+        chunks[current].begin = (int)((long)changed_count * current / changed_thread_count);
+        chunks[current].end = (int)((long)changed_count * (current + 1) / changed_thread_count);
+    }
+
+    executorParallelFor(executor, 0, changed_thread_count, 1, &computeLevelsWorker, chunks);
+
+    if (changed_count > 0 && !parallelSortLevels(executor, chunks, changed_thread_count, changed_count))
+    {
+        free(chunks);
+        free(changed_players);
+        free(changed_ids);
+        free(ids);
         free(player_levels);
+        trackedFree(MEMORY_PLAYERS, order_ids, sizeof(*order_ids) * (size + 1));
+        trackedFree(MEMORY_PLAYERS, order_levels, sizeof(*order_levels) * (size + 1));
         chessDestroy(chess);
         return CHESS_OUT_OF_MEMORY;
     }
 
-	MAP_FOREACH(int*, current_player_id, chess->players)
-    {
-        current_player = mapGet(chess->players, current_player_id);
-        wins = getWins(current_player);
-        losses = getLosses(current_player);
-        draws = getDraws(current_player);
-
-        player_level = ((double)(6*wins - 10*losses + 2*draws) / (wins + losses + draws));
+    mergeLevelRuns(ids, player_levels, 0, kept_count, size, order_ids, order_levels);
+    invalidateLevelOrder(order);
+    order->ids = order_ids;
+    order->levels = order_levels;
+    order->size = size;
+    order->valid = true;
 
-        player_levels[counter] = player_level;
-        ids[counter++] = *current_player_id;
-        free(current_player_id);
+    for (int current = 0; current < thread_count; ++current)
+    {
+        chunks[current].ids = order_ids;
+        chunks[current].levels = order_levels;
+        chunks[current].begin = (int)((long)size * current / thread_count);
+        chunks[current].end = (int)((long)size * (current + 1) / thread_count);
+        chunks[current].buffer = NULL;
+        chunks[current].length = 0;
     }
 
-    quicksort(ids, player_levels, size);
+    executorParallelFor(executor, 0, thread_count, 1, &formatLevelsWorker, chunks);
 
     ChessResult error = CHESS_SUCCESS;
-    for(int current = 0; current < size && error == CHESS_SUCCESS; ++current)
+    for (int current = 0; current < thread_count; ++current)
+    {
+        if (chunks[current].buffer == NULL)
+        {
+            error = CHESS_OUT_OF_MEMORY;
+        }
+    }
+
+    for (int current = 0; current < thread_count && error == CHESS_SUCCESS; ++current)
     {
-        if (fprintf(file, "%d %.2f\n", ids[size - 1 - current], player_levels[size - 1 - current]) < 0)
+        if (fwrite(chunks[current].buffer, 1, chunks[current].length, file) != chunks[current].length)
         {
             error = CHESS_SAVE_FAILURE;
         }
     }
 
+    for (int current = 0; current < thread_count; ++current)
+    {
+        free(chunks[current].buffer);
+    }
+    free(chunks);
+    free(changed_players);
+    free(changed_ids);
     free(ids);
     free(player_levels);
 
+    if (error == CHESS_OUT_OF_MEMORY)
+    {
+        chessDestroy(chess);
+    }
+
     return error;
 }
 
-ChessResult chessSaveTournamentStatistics (ChessSystem chess, char* path_file)
+ChessResult chessSaveTournamentStatistics(ChessSystem chess, char* path_file)
+{
+    long long start = metricsStart();
+    ChessResult result = chessSaveTournamentStatisticsImpl(chess, path_file);
+    metricsRecord(METRICS_CHESS_SAVE_TOURNAMENT_STATISTICS, start, result != CHESS_SUCCESS);
+    return result;
+}
+
+static ChessResult chessSaveTournamentStatisticsImpl(ChessSystem chess, char* path_file)
 {
     if(chess == NULL || path_file == NULL)
     {
@@ -389,104 +834,578 @@ ChessResult chessSaveTournamentStatistics (ChessSystem chess, char* path_file)
         return CHESS_SAVE_FAILURE;
     }
 
-    MAP_FOREACH(int*, current_tournament_id, chess->tournaments)
+    Tournament* finished = malloc(sizeof(*finished) * (tournamentMapGetSize(&chess->tournaments) + 1));
+    if (finished == NULL)
     {
-        Tournament tournament = mapGet(chess->tournaments, current_tournament_id);
-        assert(tournament != NULL);
+        fclose(file);
+        chessDestroy(chess);
+        return CHESS_OUT_OF_MEMORY;
+    }
+
+    //The blocks are written in id order.
+    int finished_count = gatherTournaments(chess, finished, true);
 
-        if (isFinished(tournament))
+    int thread_count = exportChunkCount(chess, finished_count, MINIMAL_TOURNAMENTS_PER_THREAD);
+    StatisticsChunk chunks[MAX_EXPORT_CHUNKS];
+    for (int current = 0; current < thread_count; ++current)
+    {
+        chunks[current].tournaments = finished;
+        chunks[current].begin = (int)((long)finished_count * current / thread_count);
+        chunks[current].end = (int)((long)finished_count * (current + 1) / thread_count);
+        chunks[current].buffer = NULL;
+        chunks[current].length = 0;
+    }
+
+    executorParallelFor(getExecutor(chess), 0, thread_count, 1, &formatStatisticsWorker, chunks);
+
+    ChessResult error = CHESS_SUCCESS;
+    for (int current = 0; current < thread_count; ++current)
+    {
+        if (chunks[current].buffer == NULL)
         {
-            int longest_time;
-            double average_time;
-            getGameTimeStatistics(tournament, &longest_time, &average_time);
+            error = CHESS_OUT_OF_MEMORY;
+        }
+    }
 
-            fprintf(file, "%d\n", getTournamentWinner(tournament));
-            fprintf(file, "%d\n", longest_time);
-            fprintf(file, "%.2f\n", average_time);
-            fprintf(file, "%s\n", getLocation(tournament));
-            fprintf(file, "%d\n", getGameCount(tournament));
-            fprintf(file, "%d\n", getPlayerCount(tournament));
+    for (int current = 0; current < thread_count && error == CHESS_SUCCESS; ++current)
+    {
+        if (fwrite(chunks[current].buffer, 1, chunks[current].length, file) != chunks[current].length)
+        {
+            error = CHESS_SAVE_FAILURE;
         }
+    }
 
-        free(current_tournament_id);
+    for (int current = 0; current < thread_count; ++current)
+    {
+        free(chunks[current].buffer);
     }
+    free(finished);
 
-    if (fclose(file) == EOF)
+    if (fclose(file) == EOF && error == CHESS_SUCCESS)
     {
-        return CHESS_SAVE_FAILURE;
+        error = CHESS_SAVE_FAILURE;
+    }
+    if (error == CHESS_OUT_OF_MEMORY)
+    {
+        chessDestroy(chess);
+    }
+	return error;
+}
+
+int chessGetLocationTournaments(ChessSystem chess, const char* location, bool ended_only,
+                                int* tournament_ids, int max_count, ChessResult* chess_result)
+{
+    long long start = metricsStart();
+    int value = chessGetLocationTournamentsImpl(chess, location, ended_only, tournament_ids, max_count, chess_result);
+    metricsRecord(METRICS_CHESS_GET_LOCATION_TOURNAMENTS, start,
+                  chess_result != NULL && *chess_result != CHESS_SUCCESS);
+    return value;
+}
+
+static int chessGetLocationTournamentsImpl(ChessSystem chess, const char* location, bool ended_only,
+                                           int* tournament_ids, int max_count, ChessResult* chess_result)
+{
+    if (chess == NULL || location == NULL || (tournament_ids == NULL && max_count > 0))
+    {
+        *chess_result = CHESS_NULL_ARGUMENT;
+        return 0;
+    }
+
+    *chess_result = CHESS_SUCCESS;
+    Location handle = findLocation(chess->locations, location);
+    if (handle == NULL)
+    {
+        return 0;
+    }
+
+    int count = 0;
+    for (int current = 0; current < getLocationTournamentCount(handle); ++current)
+    {
+        if (ended_only && !isFinished(getLocationTournament(handle, current)))
+        {
+            continue;
+        }
+        if (count < max_count)
+        {
+            tournament_ids[count] = getLocationTournamentId(handle, current);
+        }
+        ++count;
     }
-	return CHESS_SUCCESS;
+
+    return count;
 }
 
-//Implementing quicksort for the player level file saving:
-static void swapIntegers(int *a, int *b)
+ChessResult chessGetLocationStatistics(ChessSystem chess, const char* location,
+                                       ChessLocationStatistics* statistics)
 {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
+    long long start = metricsStart();
+    ChessResult result = chessGetLocationStatisticsImpl(chess, location, statistics);
+    metricsRecord(METRICS_CHESS_GET_LOCATION_STATISTICS, start, result != CHESS_SUCCESS);
+    return result;
 }
-static void swapDoubles(double *a, double *b)
+
+static ChessResult chessGetLocationStatisticsImpl(ChessSystem chess, const char* location,
+                                                  ChessLocationStatistics* statistics)
 {
-    double temp = *a;
-    *a = *b;
-    *b = temp;
+    if (chess == NULL || location == NULL || statistics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+
+    statistics->tournament_count = 0;
+    statistics->ended_tournament_count = 0;
+    statistics->game_count = 0;
+    statistics->average_game_time = 0;
+
+    Location handle = findLocation(chess->locations, location);
+    if (handle == NULL)
+    {
+        return CHESS_SUCCESS;
+    }
+
+    long long total_time = 0;
+    for (int current = 0; current < getLocationTournamentCount(handle); ++current)
+    {
+        Tournament tournament = getLocationTournament(handle, current);
+        statistics->ended_tournament_count += isFinished(tournament);
+        statistics->game_count += getGameCount(tournament);
+        total_time += getTotalGameTime(tournament);
+    }
+
+    statistics->tournament_count = getLocationTournamentCount(handle);
+    if (statistics->game_count > 0)
+    {
+        statistics->average_game_time = (double)total_time / statistics->game_count;
+    }
+
+    return CHESS_SUCCESS;
 }
-static int partition(int *ids, double *levels, int length)
+
+int chessGetCommonPlayers(ChessSystem chess, int first_tournament, int second_tournament,
+                          int* player_ids, int max_count, ChessResult* chess_result)
 {
-    int left = 1, right = length - 1;
-    double pivot = levels[length/2];
-    swapIntegers(ids, ids + length/2);
-    swapDoubles(levels, levels + length/2);
+    long long start = metricsStart();
+    int value = chessGetCommonPlayersImpl(chess, first_tournament, second_tournament, player_ids, max_count,
+                                          chess_result);
+    metricsRecord(METRICS_CHESS_GET_COMMON_PLAYERS, start,
+                  chess_result != NULL && *chess_result != CHESS_SUCCESS);
+    return value;
+}
 
-    while (left <= right)
+static int chessGetCommonPlayersImpl(ChessSystem chess, int first_tournament, int second_tournament,
+                                     int* player_ids, int max_count, ChessResult* chess_result)
+{
+    if (chess == NULL || (player_ids == NULL && max_count > 0))
+    {
+        *chess_result = CHESS_NULL_ARGUMENT;
+        return 0;
+    }
+    if (first_tournament <= 0 || second_tournament <= 0)
+    {
+        *chess_result = CHESS_INVALID_ID;
+        return 0;
+    }
+
+    Tournament first = tournamentMapGet(&chess->tournaments, first_tournament);
+    Tournament second = tournamentMapGet(&chess->tournaments, second_tournament);
+    if (first == NULL || second == NULL)
+    {
+        *chess_result = CHESS_TOURNAMENT_NOT_EXIST;
+        return 0;
+    }
+
+    const RoaringBitmap* first_participants = getParticipants(first);
+    const RoaringBitmap* second_participants = getParticipants(second);
+    int capacity = bitmapGetCardinality(first_participants) < bitmapGetCardinality(second_participants)
+                   ? bitmapGetCardinality(first_participants) : bitmapGetCardinality(second_participants);
+    //Allocating at least one entry, so that NULL only ever means failure.
+    int* common = malloc(sizeof(*common) * (capacity + 1));
+    if (common == NULL)
+    {
+        chessDestroy(chess);
+        *chess_result = CHESS_OUT_OF_MEMORY;
+        return 0;
+    }
+
+    //The indices come out in ascending order; the ids they stand for are sorted afterwards.
+    int count = 0;
+    int common_count = bitmapIntersect(first_participants, second_participants, common);
+    for (int current = 0; current < common_count; ++current)
     {
-        while (levels[left] < pivot && left < right)
+        //Ended tournaments keep the players removed since.
+        if (getPlayerAt(&chess->players, common[current]) != NULL)
         {
-            ++left;
+            common[count++] = getIndexedPlayerId(&chess->players, common[current]);
         }
+    }
+    qsort(common, count, sizeof(*common), &compareIds);
+
+    if (max_count > 0)
+    {
+        memcpy(player_ids, common, sizeof(*common) * (count < max_count ? count : max_count));
+    }
+    free(common);
+    *chess_result = CHESS_SUCCESS;
+    return count;
+}
+
+ChessResult chessGetMemoryStats(ChessMemoryStats* statistics)
+{
+    long long start = metricsStart();
+    ChessResult result = chessGetMemoryStatsImpl(statistics);
+    metricsRecord(METRICS_CHESS_GET_MEMORY_STATS, start, result != CHESS_SUCCESS);
+    return result;
+}
 
-        while (levels[right] >= pivot && left < right)
+static ChessResult chessGetMemoryStatsImpl(ChessMemoryStats* statistics)
+{
+    if (statistics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+
+#if MEMORY_STATS_ENABLED
+    ChessMemoryUsage* usages[MEMORY_CATEGORY_COUNT];
+    usages[MEMORY_MAP_NODES] = &statistics->map_nodes;
+    usages[MEMORY_MAP_KEYS] = &statistics->map_keys;
+    usages[MEMORY_PLAYERS] = &statistics->players;
+    usages[MEMORY_GAMES] = &statistics->games;
+    usages[MEMORY_TOURNAMENTS] = &statistics->tournaments;
+    usages[MEMORY_LOCATIONS] = &statistics->locations;
+    usages[MEMORY_ARENAS] = &statistics->arenas;
+    usages[MEMORY_MAPS] = &statistics->maps;
+    usages[MEMORY_SYSTEMS] = &statistics->systems;
+
+    for (int category = 0; category < MEMORY_CATEGORY_COUNT; ++category)
+    {
+        MemoryUsage usage = getMemoryUsage((MemoryCategory)category);
+        usages[category]->allocations = usage.allocations;
+        usages[category]->live_bytes = usage.live_bytes;
+        usages[category]->peak_bytes = usage.peak_bytes;
+    }
+    return CHESS_SUCCESS;
+#else
+    return CHESS_MEMORY_STATS_DISABLED;
+#endif
+}
+
+ChessResult chessDumpMetrics(FILE* file)
+{
+    if (file == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+
+#if METRICS_ENABLED
+    return metricsDump(file) ? CHESS_SUCCESS : CHESS_SAVE_FAILURE;
+#else
+    return CHESS_METRICS_DISABLED;
+#endif
+}
+
+//Parallel scans & exports:
+static Executor getExecutor(ChessSystem chess)
+{
+    if (chess->executor == NULL && chess->worker_count > 1)
+    {
+        chess->executor = executorCreate(chess->worker_count);
+    }
+    return chess->executor;
+}
+
+static int exportChunkCount(ChessSystem chess, int item_count, int minimal_items_per_chunk)
+{
+    int chunk_count = item_count / minimal_items_per_chunk;
+    if (chunk_count > chess->worker_count)
+    {
+        chunk_count = chess->worker_count;
+    }
+    if (chunk_count > MAX_EXPORT_CHUNKS)
+    {
+        chunk_count = MAX_EXPORT_CHUNKS;
+    }
+    return chunk_count < 1 ? 1 : chunk_count;
+}
+
+static int gatherTournaments(ChessSystem chess, Tournament* tournaments, bool finished_only)
+{
+    int count = 0;
+
+    //Gathering walks the tree, so it stays serial.
+    for (Tournament tournament = tournamentMapFirst(&chess->tournaments); tournament != NULL;
+         tournament = tournamentMapNext(&chess->tournaments, tournament))
+    {
+        if (!finished_only || isFinished(tournament))
         {
-            if (levels[right] == pivot)
-            {
-                if (ids[0] < ids[right])
-                {
-                    break; //Equal level, larger ID; still need to swap.
-                }
-            }
-            --right;
+            tournaments[count++] = tournament;
+        }
+    }
+
+    return count;
+}
+
+static int compareIds(const void* id1, const void* id2)
+{
+    int first = *(const int*)id1, second = *(const int*)id2;
+    return (first > second) - (first < second);
+}
+
+static void removePlayerWorker(void* scan, int begin, int end)
+{
+    RemovePlayerScan* remove_scan = scan;
+
+    for (int current = begin; current < end; ++current)
+    {
+        Tournament tournament = remove_scan->tournaments[current];
+        remove_scan->promoted_counts[current] = isFinished(tournament) ? 0 :
+            forfeitPlayerGames(tournament, remove_scan->player_index,
+                               remove_scan->promoted + remove_scan->offsets[current]);
+    }
+}
+
+static void playTimeWorker(void* scan, int begin, int end)
+{
+    PlayTimeScan* time_scan = scan;
+
+    for (int current = begin; current < end; ++current)
+    {
+        time_scan->total_times[current] = getTotalPlayerPlayTime(time_scan->tournaments[current],
+                                                                 time_scan->player_index,
+                                                                 time_scan->game_counts + current);
+    }
+}
+
+static void invalidateLevelOrder(LevelOrder* order)
+{
+    trackedFree(MEMORY_PLAYERS, order->ids, sizeof(*(order->ids)) * (order->size + 1));
+    trackedFree(MEMORY_PLAYERS, order->levels, sizeof(*(order->levels)) * (order->size + 1));
+    *order = (LevelOrder){ NULL, NULL, 0, false };
+}
+
+//Parallel pipeline for the player level file saving:
+//Printing order: highest level first, equal levels by ascending id.
+//Players without games have an undefined (nan) level and are printed last.
+static bool precedesInLevelOrder(int id1, double level1, int id2, double level2)
+{
+    if (isnan(level1) || isnan(level2))
+    {
+        if (isnan(level1) && isnan(level2))
+        {
+            return id1 < id2;
         }
+        return isnan(level2);
+    }
+    if (level1 != level2)
+    {
+        return level1 > level2;
+    }
+    return id1 < id2;
+}
 
-        if (left == right)
+static void mergeLevelRuns(const int* ids, const double* levels, int begin, int middle, int end,
+                           int* destination_ids, double* destination_levels)
+{
+    int left = begin, right = middle;
+
+    for (int current = begin; current < end; ++current)
+    {
+        if (right >= end || (left < middle
+            && precedesInLevelOrder(ids[left], levels[left], ids[right], levels[right])))
         {
-            if (levels[left] < pivot)
-            {
-                swapIntegers(ids + left, ids);
-                swapDoubles(levels + left, levels);
-                return left;
-            }
-            swapIntegers(ids + left - 1, ids);
-            swapDoubles(levels + left - 1, levels);
-            return left - 1;
+            destination_ids[current] = ids[left];
+            destination_levels[current] = levels[left++];
+        }
+        else
+        {
+            destination_ids[current] = ids[right];
+            destination_levels[current] = levels[right++];
         }
-        swapIntegers(ids + left, ids + right);
-        swapDoubles(levels + left, levels + right);
-        ++left;
-        --right;
     }
-    return -1; //Shouldn't get here.
 }
-static void quicksort(int *ids, double *levels, int length)
+
+static void mergeSortLevels(int* ids, double* levels, int* temp_ids, double* temp_levels, int length)
 {
     if (length <= 1)
     {
         return;
     }
 
-    int pivot_index = partition(ids, levels, length);
+    int middle = length / 2;
+    mergeSortLevels(ids, levels, temp_ids, temp_levels, middle);
+    mergeSortLevels(ids + middle, levels + middle, temp_ids + middle, temp_levels + middle, length - middle);
+
+    mergeLevelRuns(ids, levels, 0, middle, length, temp_ids, temp_levels);
+    memcpy(ids, temp_ids, sizeof(*ids) * length);
+    memcpy(levels, temp_levels, sizeof(*levels) * length);
+}
+
+static void computeLevelsWorker(void* chunks, int begin, int end)
+{
+    for (int chunk = begin; chunk < end; ++chunk)
+    {
+        LevelsChunk* levels_chunk = (LevelsChunk*)chunks + chunk;
+        for (int current = levels_chunk->begin; current < levels_chunk->end; ++current)
+        {
+            levels_chunk->levels[current] = getPlayerLevel(levels_chunk->players[current]);
+        }
+    }
+}
+
+static void sortLevelsWorker(void* chunks, int begin, int end)
+{
+    for (int chunk = begin; chunk < end; ++chunk)
+    {
+        LevelsChunk* levels_chunk = (LevelsChunk*)chunks + chunk;
+        int first = levels_chunk->begin;
+
+        mergeSortLevels(levels_chunk->ids + first, levels_chunk->levels + first,
+                        levels_chunk->destination_ids + first, levels_chunk->destination_levels + first,
+                        levels_chunk->end - first);
+    }
+}
+
+static void mergeLevelsWorker(void* chunks, int begin, int end)
+{
+    for (int chunk = begin; chunk < end; ++chunk)
+    {
+        LevelsChunk* levels_chunk = (LevelsChunk*)chunks + chunk;
+
+        mergeLevelRuns(levels_chunk->ids, levels_chunk->levels, levels_chunk->begin, levels_chunk->middle,
+                       levels_chunk->end, levels_chunk->destination_ids, levels_chunk->destination_levels);
+    }
+}
+
+static void formatLevelsWorker(void* chunks, int begin, int end)
+{
+    for (int chunk = begin; chunk < end; ++chunk)
+    {
+        LevelsChunk* levels_chunk = (LevelsChunk*)chunks + chunk;
+        int line_count = levels_chunk->end - levels_chunk->begin;
+
+        //Allocating at least one byte, so that NULL only ever means failure.
+        levels_chunk->buffer = malloc(LEVEL_LINE_MAX_LENGTH * (size_t)line_count + 1);
+        if (levels_chunk->buffer == NULL)
+        {
+            continue;
+        }
+
+        for (int current = levels_chunk->begin; current < levels_chunk->end; ++current)
+        {
+            levels_chunk->length += sprintf(levels_chunk->buffer + levels_chunk->length, "%d %.2f\n",
+                                            levels_chunk->ids[current], levels_chunk->levels[current]);
+        }
+    }
+}
+
+static bool parallelSortLevels(Executor executor, LevelsChunk* chunks, int chunk_count, int size)
+{
+    int* temp_ids = malloc(sizeof(*temp_ids) * size);
+    double* temp_levels = malloc(sizeof(*temp_levels) * size);
+    if (temp_ids == NULL || temp_levels == NULL)
+    {
+        free(temp_ids);
+        free(temp_levels);
+        return false;
+    }
+
+    int* ids = chunks[0].ids;
+    double* levels = chunks[0].levels;
+    LevelsChunk merges[MAX_EXPORT_CHUNKS];
+    int run_bounds[MAX_EXPORT_CHUNKS + 1];
+    int run_count = chunk_count;
 
-    quicksort(ids, levels, pivot_index);
-    quicksort(ids + pivot_index + 1, levels + pivot_index + 1, length - (pivot_index + 1));
+    for (int current = 0; current < chunk_count; ++current)
+    {
+        chunks[current].destination_ids = temp_ids;
+        chunks[current].destination_levels = temp_levels;
+        run_bounds[current] = chunks[current].begin;
+    }
+    run_bounds[chunk_count] = size;
+
+    executorParallelFor(executor, 0, chunk_count, 1, &sortLevelsWorker, chunks);
+
+    //Each round merges neighbouring runs from one pair of arrays into the other.
+    while (run_count > 1)
+    {
+        int merge_count = (run_count + 1) / 2;
+        for (int current = 0; current < merge_count; ++current)
+        {
+            int first_run = 2 * current;
+            merges[current].ids = ids;
+            merges[current].levels = levels;
+            merges[current].destination_ids = temp_ids;
+            merges[current].destination_levels = temp_levels;
+            merges[current].begin = run_bounds[first_run];
+            merges[current].middle = run_bounds[first_run + 1];
+            //A run without a partner is simply copied over.
+            merges[current].end = first_run + 1 < run_count ? run_bounds[first_run + 2] : run_bounds[first_run + 1];
+        }
+
+        executorParallelFor(executor, 0, merge_count, 1, &mergeLevelsWorker, merges);
+
+        for (int current = 0; current < merge_count; ++current)
+        {
+            run_bounds[current] = merges[current].begin;
+        }
+        run_bounds[merge_count] = size;
+        run_count = merge_count;
+
+        int* swapped_ids = ids;
+        double* swapped_levels = levels;
+        ids = temp_ids;
+        levels = temp_levels;
+        temp_ids = swapped_ids;
+        temp_levels = swapped_levels;
+    }
+
+    //After an odd number of rounds the sorted result sits in the temporary arrays.
+    if (ids != chunks[0].ids)
+    {
+        memcpy(chunks[0].ids, ids, sizeof(*ids) * size);
+        memcpy(chunks[0].levels, levels, sizeof(*levels) * size);
+        temp_ids = ids;
+        temp_levels = levels;
+    }
+
+    free(temp_ids);
+    free(temp_levels);
+    return true;
+}
+
+
+//Parallel formatting for the tournament statistics file saving:
+static void formatStatisticsWorker(void* chunks, int begin, int end)
+{
+    for (int chunk = begin; chunk < end; ++chunk)
+    {
+        StatisticsChunk* statistics_chunk = (StatisticsChunk*)chunks + chunk;
+        size_t capacity = 1; //At least one byte, so that NULL only ever means failure.
+
+        for (int current = statistics_chunk->begin; current < statistics_chunk->end; ++current)
+        {
+            capacity += STATISTICS_BLOCK_MAX_LENGTH + strlen(getLocation(statistics_chunk->tournaments[current]));
+        }
+
+        statistics_chunk->buffer = malloc(capacity);
+        if (statistics_chunk->buffer == NULL)
+        {
+            continue;
+        }
+
+        for (int current = statistics_chunk->begin; current < statistics_chunk->end; ++current)
+        {
+            Tournament tournament = statistics_chunk->tournaments[current];
+            int longest_time;
+            double average_time;
+            getGameTimeStatistics(tournament, &longest_time, &average_time);
+
+            statistics_chunk->length += sprintf(statistics_chunk->buffer + statistics_chunk->length,
+                                                "%d\n%d\n%.2f\n%s\n%d\n%d\n",
+                                                getTournamentWinner(tournament), longest_time, average_time,
+                                                getLocation(tournament), getGameCount(tournament),
+                                                getPlayerCount(tournament));
+        }
+    }
 }
 
 
@@ -2,6 +2,7 @@
 #define _CHESSSYSTEM_H
 
 #include <stdio.h>
+#include <stdbool.h>
 
 
 
@@ -21,7 +22,11 @@ typedef enum {
     CHESS_NO_TOURNAMENTS_ENDED,
     CHESS_NO_GAMES,
     CHESS_SAVE_FAILURE,
-    CHESS_SUCCESS
+    CHESS_SUCCESS,
+    //Results added since go after CHESS_SUCCESS, so the original ones keep their values.
+    CHESS_INVALID_WORKER_COUNT,
+    CHESS_MEMORY_STATS_DISABLED,
+    CHESS_METRICS_DISABLED
 } ChessResult ;
 
 /*
@@ -33,6 +38,37 @@ typedef enum {
     DRAW
 } Winner;
 
+/** Aggregated statistics of the tournaments held in one location */
+typedef struct ChessLocationStatistics_t
+{
+    int tournament_count;
+    int ended_tournament_count;
+    int game_count;
+    double average_game_time; //Over all the location's games; 0 if there are none.
+} ChessLocationStatistics;
+
+/** Memory used by one category of objects */
+typedef struct ChessMemoryUsage_t
+{
+    long long allocations;
+    long long live_bytes;
+    long long peak_bytes;
+} ChessMemoryUsage;
+
+/** Memory used by the chess systems, per category of objects */
+typedef struct ChessMemoryStats_t
+{
+    ChessMemoryUsage map_nodes;
+    ChessMemoryUsage map_keys;
+    ChessMemoryUsage players;
+    ChessMemoryUsage games;
+    ChessMemoryUsage tournaments;
+    ChessMemoryUsage locations;
+    ChessMemoryUsage arenas; //Objects of chess systems created by chessCreateWithArena.
+    ChessMemoryUsage maps; //The maps themselves, apart from their nodes and keys.
+    ChessMemoryUsage systems; //The chess systems themselves.
+} ChessMemoryStats;
+
 /** Type for representing a chess system that organizes chess tournaments */
 typedef struct chess_system_t *ChessSystem;
 
@@ -44,6 +80,18 @@ typedef struct chess_system_t *ChessSystem;
  */
 ChessSystem chessCreate();
 
+/**
+ * chessCreateWithArena: create an empty chess system whose tournaments are
+ *                       allocated from a region allocator owned by the system. The system behaves
+ *                       exactly like one made by chessCreate: every tournament keeps its games in a
+ *                       region of its own, released at once when the tournament is removed, and
+ *                       chessDestroy releases the tournaments' regions without going over their games.
+ *
+ * @return A new chess system in case of success, and NULL otherwise (e.g.
+ *     in case of an allocation error)
+ */
+ChessSystem chessCreateWithArena(void);
+
 /**
  * chessDestroy: free a chess system, and all its contents, from
  * memory.
@@ -53,6 +101,21 @@ ChessSystem chessCreate();
  */
 void chessDestroy(ChessSystem chess);
 
+/**
+ * chessSetWorkerCount: set the number of threads used by the scans over all tournaments
+ *                      (player removal, average play time) and by the save functions.
+ *                      A new chess system uses 4 workers; 1 runs everything on the calling thread.
+ *
+ * @param chess - chess system to configure. Must be non-NULL.
+ * @param worker_count - number of worker threads, including the calling thread. Must be positive.
+ *
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess is NULL.
+ *     CHESS_INVALID_WORKER_COUNT - if worker_count is not positive.
+ *     CHESS_SUCCESS - if the worker count was set successfully.
+ */
+ChessResult chessSetWorkerCount(ChessSystem chess, int worker_count);
+
 /**
  * chessAddTournament: add a new tournament to a chess system.
  *
@@ -197,4 +260,89 @@ ChessResult chessSavePlayersLevels (ChessSystem chess, FILE* file);
  */
 ChessResult chessSaveTournamentStatistics (ChessSystem chess, char* path_file);
 
+/**
+ * chessGetLocationTournaments: lists the ids of the tournaments held in a location, in ascending order.
+ *                              Runs in time proportional to the number of tournaments in the location.
+ *
+ * @param chess - a chess system. Must be non-NULL.
+ * @param location - the location to look up. Must be non-NULL.
+ * @param ended_only - if true, only tournaments which ended are listed.
+ * @param tournament_ids - array receiving at most max_count ids. May be NULL if max_count is 0.
+ * @param max_count - the size of tournament_ids.
+ * @param chess_result - this variable will contain the returned error code.
+ * @return the number of matching tournaments, which may be larger than max_count.
+ *     CHESS_NULL_ARGUMENT - if chess or location is NULL, or tournament_ids is NULL while max_count is positive.
+ *     CHESS_SUCCESS - if the tournaments were listed successfully (a location without tournaments has none).
+ */
+int chessGetLocationTournaments(ChessSystem chess, const char* location, bool ended_only,
+                                int* tournament_ids, int max_count, ChessResult* chess_result);
+
+/**
+ * chessGetLocationStatistics: aggregates the statistics of the tournaments held in a location.
+ *                             Runs in time proportional to the number of tournaments in the location.
+ *
+ * @param chess - a chess system. Must be non-NULL.
+ * @param location - the location to look up. Must be non-NULL.
+ * @param statistics - receives the statistics. Must be non-NULL.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if any of the arguments is NULL.
+ *     CHESS_SUCCESS - if the statistics were calculated successfully.
+ */
+ChessResult chessGetLocationStatistics(ChessSystem chess, const char* location,
+                                       ChessLocationStatistics* statistics);
+
+/**
+ * chessGetCommonPlayers: lists the ids of the players who played in both of the given tournaments,
+ *                        in ascending order. A player removed from the system is not listed, and
+ *                        neither are the games it forfeited by the removal. Each tournament keeps
+ *                        its participants in a compressed bitmap, so the sets are intersected
+ *                        without going over the games.
+ *
+ * @param chess - a chess system. Must be non-NULL.
+ * @param first_tournament - id of the first tournament. Must be positive.
+ * @param second_tournament - id of the second tournament. Must be positive.
+ * @param player_ids - array receiving at most max_count ids. May be NULL if max_count is 0.
+ * @param max_count - the size of player_ids.
+ * @param chess_result - this variable will contain the returned error code.
+ * @return the number of common players, which may be larger than max_count.
+ *     CHESS_NULL_ARGUMENT - if chess is NULL, or player_ids is NULL while max_count is positive.
+ *     CHESS_INVALID_ID - if either tournament id is not positive.
+ *     CHESS_TOURNAMENT_NOT_EXIST - if either tournament does not exist in the system.
+ *     CHESS_SUCCESS - if the players were listed successfully.
+ */
+int chessGetCommonPlayers(ChessSystem chess, int first_tournament, int second_tournament,
+                          int* player_ids, int max_count, ChessResult* chess_result);
+
+/**
+ * chessGetMemoryStats: reports the allocations, live bytes and peak bytes of the objects making up
+ *                      the chess systems: map nodes, map keys, players, games, tournaments,
+ *                      locations, arenas, maps and the systems themselves. Like chessDumpMetrics,
+ *                      the counters cover every chess system in the process, and only exist in
+ *                      builds compiled with -DCHESS_MEMORY_STATS.
+ *
+ * @param statistics - receives the statistics. Must be non-NULL.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if statistics is NULL.
+ *     CHESS_MEMORY_STATS_DISABLED - if the build does not count allocations.
+ *     CHESS_SUCCESS - if the statistics were filled successfully.
+ */
+ChessResult chessGetMemoryStats(ChessMemoryStats* statistics);
+
+/**
+ * chessDumpMetrics: prints the number of calls, failed calls and latency percentiles of every function
+ *                   above, one line per function:
+ *                   api=<name> calls=<n> failures=<n> total_ns=<t> mean_ns=<t> p50_ns=<t> p90_ns=<t>
+ *                   p99_ns=<t> p999_ns=<t> max_ns=<t>
+ *                   The metrics cover every chess system in the process, and only exist in builds
+ *                   compiled with -DCHESS_METRICS. Percentiles are exact to within 25%.
+ *
+ * @param file - an open, writable output stream. Must be non-NULL.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if file is NULL.
+ *     CHESS_METRICS_DISABLED - if the build does not record metrics.
+ *     CHESS_SAVE_FAILURE - if an error occurred while printing.
+ *     CHESS_SUCCESS - if the metrics were printed successfully.
+ */
+ChessResult chessDumpMetrics(FILE* file);
+
 #endif //HW1_CHESSSYSTEM_H
@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200112L //For pthreads under -std=c99.
+
+#include "epoch.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+//The epoch a thread entered its critical section in, or NO_EPOCH outside of one.
+#define NO_EPOCH 0
+
+typedef struct EpochRecord_t
+{
+    unsigned long epoch;
+    int depth; //Nesting of the owner's critical sections; only the owner touches it.
+    bool in_use; //Whether a live thread owns the record.
+    struct EpochRecord_t* next;
+} *EpochRecord;
+
+static unsigned long global_epoch = NO_EPOCH + 1;
+
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t record_key;
+//Records are never freed; those of exited threads are handed to new ones.
+static pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+static EpochRecord records = NULL;
+
+//Declaring static auxiliary functions:
+static void createRecordKey(void);
+static void releaseRecord(void* record);
+static EpochRecord getRecord(void);
+//Advances the global epoch if every reader inside a critical section has seen the current one.
+static void tryAdvance(void);
+
+bool epochEnter(void)
+{
+    EpochRecord record = getRecord();
+    if (record == NULL)
+    {
+        return false;
+    }
+
+    if (record->depth++ == 0)
+    {
+        //Sequentially consistent, so a writer scanning the records after unlinking an object either
+        //sees this reader, or the reader starts after the unlinking and can't reach the object.
+        __atomic_store_n(&record->epoch, __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    }
+    return true;
+}
+
+void epochExit(void)
+{
+    EpochRecord record = pthread_getspecific(record_key);
+    if (--(record->depth) == 0)
+    {
+        __atomic_store_n(&record->epoch, NO_EPOCH, __ATOMIC_RELEASE);
+    }
+}
+
+unsigned long epochCurrent(void)
+{
+    return __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+}
+
+bool epochIsSafe(unsigned long tag)
+{
+    tryAdvance();
+    return epochCurrent() >= tag + 2;
+}
+
+
+//Static auxiliary functions:
+static void createRecordKey(void)
+{
+    if (pthread_key_create(&record_key, &releaseRecord) != 0)
+    {
+        abort(); //Only happens once the process ran out of thread-specific keys.
+    }
+}
+
+static void releaseRecord(void* record)
+{
+    __atomic_store_n(&((EpochRecord)record)->in_use, false, __ATOMIC_RELEASE);
+}
+
+static EpochRecord getRecord(void)
+{
+    pthread_once(&record_key_once, &createRecordKey);
+    EpochRecord record = pthread_getspecific(record_key);
+    if (record != NULL)
+    {
+        return record;
+    }
+
+    pthread_mutex_lock(&records_lock);
+    for (record = records; record != NULL; record = record->next)
+    {
+        if (!__atomic_load_n(&record->in_use, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+    }
+    if (record == NULL)
+    {
+        record = malloc(sizeof(*record));
+        if (record == NULL)
+        {
+            pthread_mutex_unlock(&records_lock);
+            return NULL;
+        }
+        record->epoch = NO_EPOCH;
+        record->next = records;
+        __atomic_store_n(&records, record, __ATOMIC_RELEASE);
+    }
+    record->depth = 0;
+    __atomic_store_n(&record->in_use, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&records_lock);
+
+    if (pthread_setspecific(record_key, record) != 0)
+    {
+        releaseRecord(record);
+        return NULL;
+    }
+    return record;
+}
+
+static void tryAdvance(void)
+{
+    //Pairs with the store in epochEnter: the writer's unlinking is ordered before reading the records.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    unsigned long current = epochCurrent();
+    for (EpochRecord record = __atomic_load_n(&records, __ATOMIC_ACQUIRE); record != NULL; record = record->next)
+    {
+        unsigned long epoch = __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != NO_EPOCH && epoch != current)
+        {
+            return;
+        }
+    }
+
+    __atomic_compare_exchange_n(&global_epoch, &current, current + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
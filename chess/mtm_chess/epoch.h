@@ -0,0 +1,27 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdbool.h>
+
+//Epoch-based reclamation, for structures read without locks (see mapSkipList.c).
+//
+//Readers wrap every access in epochEnter/epochExit. A writer which unlinks an object tags it with
+//epochCurrent() and keeps it until epochIsSafe says no reader can still be looking at it, then
+//frees it. The global epoch only advances once every reader inside a critical section has seen
+//the current one, so two advances past an object's tag mean all the readers which could have
+//reached it are gone.
+//
+//Each thread announces its epoch in a record of its own, which goes back to a shared pool when
+//the thread exits. Critical sections may nest.
+
+//Enters a critical section. Returns false if the thread's record could not be allocated; the
+//caller has to keep writers out some other way then, and must not call epochExit.
+bool epochEnter(void);
+void epochExit(void);
+
+//The tag of an object unlinked just now.
+unsigned long epochCurrent(void);
+//Tries to advance the global epoch, then returns whether objects with the given tag may be freed.
+bool epochIsSafe(unsigned long tag);
+
+#endif //EPOCH_H
@@ -0,0 +1,459 @@
+#define _POSIX_C_SOURCE 200112L //For pthreads under -std=c99.
+
+#include "executor.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define INITIAL_DEQUE_CAPACITY 64
+//The deque shared by all threads which are not workers of the executor.
+#define OUTSIDE_DEQUE 0
+
+//A circular buffer of tasks. The owner works at the bottom, thieves take from the top.
+typedef struct TaskDeque_t
+{
+    pthread_mutex_t lock;
+    ExecutorTask** tasks;
+    int top;
+    int count;
+    int capacity;
+} TaskDeque;
+
+//Identifies a pool thread, so spawns and waits find the thread's own deque.
+typedef struct WorkerIdentity_t
+{
+    Executor executor;
+    int deque_index;
+} WorkerIdentity;
+
+struct Executor_t
+{
+    int worker_count;
+
+    //Deque i belongs to worker thread i; deque 0 (OUTSIDE_DEQUE) to everyone else.
+    TaskDeque* deques;
+    pthread_t* threads;
+    WorkerIdentity* identities;
+
+    //Sleeping workers wait for pending to become positive. Waiters which found nothing to run
+    //sleep until a task finishes or one is spawned; waiting counts them, so that finishing a task
+    //only takes the lock when somebody sleeps.
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t work_available;
+    pthread_cond_t task_finished;
+    int pending;
+    int waiting;
+    bool shutting_down;
+};
+
+static pthread_key_t worker_identity_key;
+static bool worker_identity_key_created = false;
+static pthread_once_t worker_identity_once = PTHREAD_ONCE_INIT;
+
+//Declaring static auxiliary functions:
+static void createWorkerIdentityKey(void);
+static int currentDequeIndex(Executor executor);
+//Initializes the lock and condition variables. Returns false, with nothing left to destroy, if one failed.
+static bool initSynchronization(Executor executor);
+static bool dequeInit(TaskDeque* deque);
+static void dequeDestroy(TaskDeque* deque);
+static bool dequePushBottom(TaskDeque* deque, ExecutorTask* task);
+static ExecutorTask* dequePopBottom(TaskDeque* deque);
+static ExecutorTask* dequeStealTop(TaskDeque* deque);
+//Pops from the given deque, or steals from the others. Returns NULL if all are empty.
+static ExecutorTask* findTask(Executor executor, int deque_index);
+static void runTask(Executor executor, ExecutorTask* task);
+static void* workerMain(void* identity);
+//Stops and joins the first thread_count workers, then frees everything.
+static void shutDown(Executor executor, int thread_count);
+
+//Arguments of the half-range a parallel-for spawns.
+typedef struct RangeArguments_t
+{
+    Executor executor;
+    int begin;
+    int end;
+    int grain;
+    ExecutorRangeFunction function;
+    void* context;
+} RangeArguments;
+
+static void runRange(void* arguments);
+
+Executor executorCreate(int worker_count)
+{
+    if (worker_count <= 0 || pthread_once(&worker_identity_once, &createWorkerIdentityKey) != 0
+        || !worker_identity_key_created)
+    {
+        return NULL;
+    }
+
+    Executor executor = malloc(sizeof(*executor));
+    if (executor == NULL)
+    {
+        return NULL;
+    }
+
+    executor->worker_count = worker_count;
+    executor->pending = 0;
+    executor->waiting = 0;
+    executor->shutting_down = false;
+    executor->deques = malloc(sizeof(*(executor->deques)) * worker_count);
+    executor->threads = malloc(sizeof(*(executor->threads)) * worker_count);
+    executor->identities = malloc(sizeof(*(executor->identities)) * worker_count);
+    if (executor->deques == NULL || executor->threads == NULL || executor->identities == NULL)
+    {
+        free(executor->deques);
+        free(executor->threads);
+        free(executor->identities);
+        free(executor);
+        return NULL;
+    }
+
+    int initialized = 0;
+    while (initialized < worker_count && dequeInit(executor->deques + initialized))
+    {
+        ++initialized;
+    }
+    if (initialized < worker_count || !initSynchronization(executor))
+    {
+        for (int current = 0; current < initialized; ++current)
+        {
+            dequeDestroy(executor->deques + current);
+        }
+        free(executor->deques);
+        free(executor->threads);
+        free(executor->identities);
+        free(executor);
+        return NULL;
+    }
+
+    for (int current = 1; current < worker_count; ++current)
+    {
+        executor->identities[current].executor = executor;
+        executor->identities[current].deque_index = current;
+        if (pthread_create(executor->threads + current, NULL, &workerMain, executor->identities + current) != 0)
+        {
+            shutDown(executor, current);
+            return NULL;
+        }
+    }
+
+    return executor;
+}
+
+void executorDestroy(Executor executor)
+{
+    if (executor == NULL)
+    {
+        return;
+    }
+
+    shutDown(executor, executor->worker_count);
+}
+
+int executorGetWorkerCount(Executor executor)
+{
+    return executor == NULL ? 1 : executor->worker_count;
+}
+
+void executorSpawn(Executor executor, ExecutorTask* task, ExecutorFunction function, void* argument)
+{
+    assert(task != NULL && function != NULL);
+
+    task->function = function;
+    task->argument = argument;
+    task->done = 0;
+
+    if (executor == NULL || executor->worker_count == 1
+        || !dequePushBottom(executor->deques + currentDequeIndex(executor), task))
+    {
+        runTask(executor, task);
+        return;
+    }
+
+    pthread_mutex_lock(&executor->sleep_lock);
+    ++(executor->pending);
+    pthread_cond_signal(&executor->work_available);
+    if (executor->waiting > 0)
+    {
+        pthread_cond_broadcast(&executor->task_finished); //A waiter may run it.
+    }
+    pthread_mutex_unlock(&executor->sleep_lock);
+}
+
+void executorWait(Executor executor, ExecutorTask* task)
+{
+    assert(task != NULL);
+
+    int deque_index = executor == NULL ? OUTSIDE_DEQUE : currentDequeIndex(executor);
+
+    while (!__atomic_load_n(&task->done, __ATOMIC_ACQUIRE))
+    {
+        ExecutorTask* other = executor == NULL ? NULL : findTask(executor, deque_index);
+        if (other != NULL)
+        {
+            runTask(executor, other);
+            continue;
+        }
+
+        //The task is being run by another worker, and there's nothing to steal meanwhile.
+        pthread_mutex_lock(&executor->sleep_lock);
+        //Sequentially consistent with runTask: either it sees this waiter, or this sees the task done.
+        __atomic_add_fetch(&executor->waiting, 1, __ATOMIC_SEQ_CST);
+        while (!__atomic_load_n(&task->done, __ATOMIC_SEQ_CST) && executor->pending == 0)
+        {
+            pthread_cond_wait(&executor->task_finished, &executor->sleep_lock);
+        }
+        __atomic_sub_fetch(&executor->waiting, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&executor->sleep_lock);
+    }
+}
+
+void executorParallelFor(Executor executor, int begin, int end, int grain,
+                         ExecutorRangeFunction function, void* context)
+{
+    if (grain < 1)
+    {
+        grain = 1;
+    }
+
+    if (executor == NULL || executor->worker_count == 1 || end - begin <= grain)
+    {
+        //Splitting by grain even when serial, so a piece never exceeds grain indices.
+        for (int current = begin; current < end; current += grain)
+        {
+            function(context, current, end - current > grain ? current + grain : end);
+        }
+        return;
+    }
+
+    int middle = begin + (end - begin) / 2;
+    RangeArguments right_half = { executor, middle, end, grain, function, context };
+    ExecutorTask right_task;
+
+    executorSpawn(executor, &right_task, &runRange, &right_half);
+    executorParallelFor(executor, begin, middle, grain, function, context);
+    executorWait(executor, &right_task);
+}
+
+
+//Static auxiliary functions:
+static void createWorkerIdentityKey(void)
+{
+    worker_identity_key_created = pthread_key_create(&worker_identity_key, NULL) == 0;
+}
+
+static int currentDequeIndex(Executor executor)
+{
+    WorkerIdentity* identity = pthread_getspecific(worker_identity_key);
+    if (identity == NULL || identity->executor != executor)
+    {
+        return OUTSIDE_DEQUE;
+    }
+    return identity->deque_index;
+}
+
+static bool initSynchronization(Executor executor)
+{
+    if (pthread_mutex_init(&executor->sleep_lock, NULL) != 0)
+    {
+        return false;
+    }
+    if (pthread_cond_init(&executor->work_available, NULL) != 0)
+    {
+        pthread_mutex_destroy(&executor->sleep_lock);
+        return false;
+    }
+    if (pthread_cond_init(&executor->task_finished, NULL) != 0)
+    {
+        pthread_cond_destroy(&executor->work_available);
+        pthread_mutex_destroy(&executor->sleep_lock);
+        return false;
+    }
+    return true;
+}
+
+static bool dequeInit(TaskDeque* deque)
+{
+    deque->tasks = malloc(sizeof(*(deque->tasks)) * INITIAL_DEQUE_CAPACITY);
+    if (deque->tasks == NULL)
+    {
+        return false;
+    }
+    if (pthread_mutex_init(&deque->lock, NULL) != 0)
+    {
+        free(deque->tasks);
+        return false;
+    }
+
+    deque->top = 0;
+    deque->count = 0;
+    deque->capacity = INITIAL_DEQUE_CAPACITY;
+    return true;
+}
+
+static void dequeDestroy(TaskDeque* deque)
+{
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->tasks);
+}
+
+static bool dequePushBottom(TaskDeque* deque, ExecutorTask* task)
+{
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->count == deque->capacity)
+    {
+        ExecutorTask** grown = malloc(sizeof(*grown) * deque->capacity * 2);
+        if (grown == NULL)
+        {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
+        //Unwrapping the circular buffer so the oldest task is first.
+        for (int current = 0; current < deque->count; ++current)
+        {
+            grown[current] = deque->tasks[(deque->top + current) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = grown;
+        deque->top = 0;
+        deque->capacity *= 2;
+    }
+
+    deque->tasks[(deque->top + deque->count) % deque->capacity] = task;
+    ++(deque->count);
+
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+static ExecutorTask* dequePopBottom(TaskDeque* deque)
+{
+    ExecutorTask* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->count > 0)
+    {
+        --(deque->count);
+        task = deque->tasks[(deque->top + deque->count) % deque->capacity];
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+static ExecutorTask* dequeStealTop(TaskDeque* deque)
+{
+    ExecutorTask* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->count > 0)
+    {
+        task = deque->tasks[deque->top];
+        deque->top = (deque->top + 1) % deque->capacity;
+        --(deque->count);
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+static ExecutorTask* findTask(Executor executor, int deque_index)
+{
+    ExecutorTask* task = dequePopBottom(executor->deques + deque_index);
+
+    for (int offset = 1; task == NULL && offset < executor->worker_count; ++offset)
+    {
+        task = dequeStealTop(executor->deques + (deque_index + offset) % executor->worker_count);
+    }
+
+    if (task != NULL)
+    {
+        pthread_mutex_lock(&executor->sleep_lock);
+        --(executor->pending);
+        pthread_mutex_unlock(&executor->sleep_lock);
+    }
+
+    return task;
+}
+
+static void runTask(Executor executor, ExecutorTask* task)
+{
+    task->function(task->argument);
+    __atomic_store_n(&task->done, 1, __ATOMIC_SEQ_CST);
+
+    if (executor != NULL && __atomic_load_n(&executor->waiting, __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_mutex_lock(&executor->sleep_lock);
+        pthread_cond_broadcast(&executor->task_finished);
+        pthread_mutex_unlock(&executor->sleep_lock);
+    }
+}
+
+static void* workerMain(void* identity)
+{
+    WorkerIdentity* worker = identity;
+    Executor executor = worker->executor;
+
+    pthread_setspecific(worker_identity_key, worker);
+
+    while (true)
+    {
+        ExecutorTask* task = findTask(executor, worker->deque_index);
+        if (task != NULL)
+        {
+            runTask(executor, task);
+            continue;
+        }
+
+        pthread_mutex_lock(&executor->sleep_lock);
+        while (executor->pending == 0 && !executor->shutting_down)
+        {
+            pthread_cond_wait(&executor->work_available, &executor->sleep_lock);
+        }
+        bool done = executor->shutting_down && executor->pending == 0;
+        pthread_mutex_unlock(&executor->sleep_lock);
+
+        if (done)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void shutDown(Executor executor, int thread_count)
+{
+    pthread_mutex_lock(&executor->sleep_lock);
+    executor->shutting_down = true;
+    pthread_cond_broadcast(&executor->work_available);
+    pthread_mutex_unlock(&executor->sleep_lock);
+
+    for (int current = 1; current < thread_count; ++current)
+    {
+        pthread_join(executor->threads[current], NULL);
+    }
+
+    for (int current = 0; current < executor->worker_count; ++current)
+    {
+        dequeDestroy(executor->deques + current);
+    }
+    pthread_cond_destroy(&executor->work_available);
+    pthread_cond_destroy(&executor->task_finished);
+    pthread_mutex_destroy(&executor->sleep_lock);
+
+    free(executor->deques);
+    free(executor->threads);
+    free(executor->identities);
+    free(executor);
+}
+
+static void runRange(void* arguments)
+{
+    RangeArguments* range = arguments;
+    executorParallelFor(range->executor, range->begin, range->end, range->grain,
+                        range->function, range->context);
+}
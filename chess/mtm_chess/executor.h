@@ -0,0 +1,99 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <stdbool.h>
+
+/**
+* Work-stealing task executor
+*
+* Runs tasks on a fixed set of pthreads. Every worker owns a deque of tasks: it pushes and pops
+* its own tasks at the bottom, and idle workers steal from the top of the other deques.
+* Threads outside the pool share one extra deque.
+*
+* The following functions are available:
+*   executorCreate		- Creates an executor with a given number of workers
+*   executorDestroy		- Stops the workers and frees all resources
+*   executorGetWorkerCount	- Returns the number of workers
+*   executorSpawn		- Queues a task to be run by one of the workers
+*   executorWait		- Waits for a spawned task, running other tasks meanwhile
+*   executorParallelFor	- Runs a function over an index range, split into pieces
+*
+* A NULL executor is valid everywhere and simply runs everything on the calling thread.
+*/
+
+/** Type for defining the executor */
+typedef struct Executor_t *Executor;
+
+/** Type of a task's function */
+typedef void (*ExecutorFunction)(void* argument);
+
+/** Type of a parallel-for body; handles the indices [begin, end) */
+typedef void (*ExecutorRangeFunction)(void* context, int begin, int end);
+
+/**
+* A spawned task. The storage belongs to the caller of executorSpawn and must stay valid
+* until executorWait returns for it. The fields are private to the executor.
+*/
+typedef struct ExecutorTask_t
+{
+    ExecutorFunction function;
+    void* argument;
+    int done;
+} ExecutorTask;
+
+/**
+* executorCreate: Starts a new executor.
+*
+* @param worker_count - The number of threads running tasks, including the thread which waits for
+*       them; worker_count - 1 new threads are started. Must be positive.
+* @return
+*   NULL - if worker_count is not positive, or an allocation, a thread creation or the creation of
+*       a thread-specific key, mutex or condition variable failed.
+*   A new executor otherwise.
+*/
+Executor executorCreate(int worker_count);
+
+/**
+* executorDestroy: Stops the workers and frees the executor.
+* All spawned tasks must have been waited for.
+*
+* @param executor - Target executor. If NULL, nothing is done.
+*/
+void executorDestroy(Executor executor);
+
+/**
+* executorGetWorkerCount: Returns the number of workers of an executor.
+* @return
+*   1 if a NULL executor was sent (everything runs on the calling thread).
+*   The worker count given at creation otherwise.
+*/
+int executorGetWorkerCount(Executor executor);
+
+/**
+* executorSpawn: Queues function(argument) on the calling thread's deque.
+* If the task can't be queued it is run immediately instead, so spawning never fails.
+*
+* @param executor - The executor to run the task on.
+* @param task - Storage for the task, owned by the caller.
+* @param function - The function to run.
+* @param argument - The argument to pass to function.
+*/
+void executorSpawn(Executor executor, ExecutorTask* task, ExecutorFunction function, void* argument);
+
+/**
+* executorWait: Returns once the given task has finished. While waiting, the calling thread runs
+* queued tasks of its own or steals them from other workers, and sleeps while there are none.
+*/
+void executorWait(Executor executor, ExecutorTask* task);
+
+/**
+* executorParallelFor: Calls function over [begin, end) in pieces of at most grain indices.
+* The range is split in halves recursively, so idle workers steal large pieces first.
+* Returns once the whole range was handled.
+*
+* @param grain - The largest piece handled by a single call. Values below 1 are treated as 1.
+*/
+void executorParallelFor(Executor executor, int begin, int end, int grain,
+                         ExecutorRangeFunction function, void* context);
+
+#endif //EXECUTOR_H
@@ -1,206 +1,280 @@
 #include "game.h"
+#include "gameKernels.h"
+#include "memoryStats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 
-struct Game_t
-{
-    int id_player1;
-    int id_player2;
-    Winner winner;
-    int game_time;
-    bool auto_win;
-};
+#define INITIAL_CAPACITY 8
+
+//Declaring static auxiliary functions:
+//Grows all the columns to the given capacity. Returns false if an allocation failed.
+static bool growGameColumns(GameColumns* games, int capacity);
+//Frees the column arrays, leaving the other fields as they are.
+static void freeColumns(GameColumns* games);
+static void* allocateColumn(GameColumns* games, size_t size);
+static void freeColumn(GameColumns* games, void* column, size_t size);
 
 //Construction & destruction:
-Game createGame(int id_player1, int id_player2, Winner winner, int game_time, ChessResult* error)
+void initGameColumns(GameColumns* games, Arena arena)
 {
-   *error = CHESS_SUCCESS;
-
-   if(id_player1 == id_player2 || id_player1 <= 0 || id_player2 <= 0)
-   {
-       *error = CHESS_INVALID_ID;
-   }
-   else if(game_time < 0)
-   {
-       *error = CHESS_INVALID_PLAY_TIME;
-   }
+    games->player1 = NULL;
+    games->player2 = NULL;
+    games->time = NULL;
+    games->status = NULL;
+    games->forfeited_count = 0;
+    games->total_time = 0;
+    games->count = 0;
+    games->capacity = 0;
+    games->arena = arena;
+}
 
+void freeGameColumns(GameColumns* games)
+{
+    freeColumns(games);
+    initGameColumns(games, games->arena);
+}
 
-   if(*error != CHESS_SUCCESS)
-   {
-       return NULL;
-   }
+ChessResult appendGame(GameColumns* games, int id_player1, int id_player2, Winner winner, int game_time)
+{
+    if(id_player1 == id_player2 || id_player1 <= 0 || id_player2 <= 0)
+    {
+        return CHESS_INVALID_ID;
+    }
+    if(game_time < 0)
+    {
+        return CHESS_INVALID_PLAY_TIME;
+    }
 
-   Game game = malloc(sizeof(*game));
-   if (game == NULL)
-   {
-        *error = CHESS_OUT_OF_MEMORY;    
-        return NULL;
-   }
+    if (games->count == games->capacity
+        && !growGameColumns(games, games->capacity == 0 ? INITIAL_CAPACITY : 2 * games->capacity))
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
 
-    game->id_player1 = id_player1;
-    game->id_player2 = id_player2;
-    game->winner = winner;
-    game->game_time = game_time;
-    game->auto_win = false;
+    int game = games->count++;
+    games->player1[game] = id_player1;
+    games->player2[game] = id_player2;
+    games->time[game] = game_time;
+    games->status[game] = (unsigned char)winner;
+    games->total_time += game_time;
 
-    return game;
-}
-               
-void freeGame(Game game)
-{
-    free(game);
+    return CHESS_SUCCESS;
 }
 
 //Getters & Setters:
-int getPlayer1Id(Game game)
+int getPlayer1Id(const GameColumns* games, int game)
 {
-    return game->id_player1;
+    return games->player1[game];
 }
-int getPlayer2Id(Game game)
+int getPlayer2Id(const GameColumns* games, int game)
 {
-    return game->id_player2;
+    return games->player2[game];
 }
 
-bool didPlayerForfeit(Game game, int player_id)
+bool didPlayerForfeit(const GameColumns* games, int game, int player_id)
 {
-    if (!isPlayerForfeited(game) || !didPlayerPlay(game, player_id))
+    if (!isPlayerForfeited(games, game) || !didPlayerPlay(games, game, player_id))
     {
         return false;
     }
 
-    Winner winner = getWinner(game);
+    Winner winner = getWinner(games, game);
     return (winner == DRAW //Both players forfeited.
-        || getWinnerId(game) != player_id); //Player forfeited.
+        || getWinnerId(games, game) != player_id); //Player forfeited.
 }
 
-Winner getWinner(Game game)
+Winner getWinner(const GameColumns* games, int game)
 {
-    return game->winner;
+    return (Winner)(games->status[game] & GAME_WINNER_MASK);
 }
 
-int getWinnerId(Game game)
+int getWinnerId(const GameColumns* games, int game)
 {
-    if (game->winner == DRAW)
+    Winner winner = getWinner(games, game);
+    if (winner == DRAW)
     {
         return NO_WINNER;
     }
-    return game->winner == FIRST_PLAYER ? getPlayer1Id(game) : getPlayer2Id(game);
+    return winner == FIRST_PLAYER ? getPlayer1Id(games, game) : getPlayer2Id(games, game);
 }
 
-int getPlayerPlayTime(Game game, int player_id)
+int getPlayerPlayTime(const GameColumns* games, int game, int player_id)
 {
-    if (!didPlayerPlay(game, player_id))
+    if (!didPlayerPlay(games, game, player_id))
     {
         return 0;
     }
 
-    return getTime(game);
+    return getTime(games, game);
 }
 
-bool isPlayerForfeited(Game game)
+bool isPlayerForfeited(const GameColumns* games, int game)
 {
-    return game->auto_win;
+    return (games->status[game] & GAME_FORFEITED) != 0;
 }
 
-void setPlayerForfeited(Game game, int player_to_remove_id, Map players)
+int setPlayerForfeited(GameColumns* games, int game, int player_to_remove_id)
 {
-    assert(didPlayerPlay(game, player_to_remove_id));
+    assert(didPlayerPlay(games, game, player_to_remove_id));
+    int promoted_id = NO_WINNER;
+    Winner winner = getWinner(games, game);
 
-    if (isPlayerForfeited(game)) //Both players removed.
+    if (isPlayerForfeited(games, game)) //Both players removed.
     {
-        game->winner = DRAW;
+        winner = DRAW;
     }
-    else if (player_to_remove_id == getPlayer1Id(game))
+    else if (player_to_remove_id == getPlayer1Id(games, game))
     {
-        if (game->winner == FIRST_PLAYER)
+        if (winner == FIRST_PLAYER)
         {
-            int id2 = getPlayer2Id(game);
-            Player player2 = mapGet(players, &id2);
-            assert(player2 != NULL);
-            increaseWins(player2);
-            decreaseLosses(player2);
+            promoted_id = getPlayer2Id(games, game);
         }
-        game->winner = SECOND_PLAYER;
+        winner = SECOND_PLAYER;
     }
     else
     {
-        if (game->winner == SECOND_PLAYER)
+        if (winner == SECOND_PLAYER)
         {
-            int id1 = getPlayer1Id(game);
-            Player player1 = mapGet(players, &id1);
-            assert(player1 != NULL);
-            increaseWins(player1);
-            decreaseLosses(player1);
+            promoted_id = getPlayer1Id(games, game);
         }
-        game->winner = FIRST_PLAYER;        
+        winner = FIRST_PLAYER;
+    }
+
+    if (!isPlayerForfeited(games, game))
+    {
+        ++games->forfeited_count;
     }
+    games->status[game] = (unsigned char)winner | GAME_FORFEITED;
+    return promoted_id;
+}
 
-    game->auto_win = true;
+int getTime(const GameColumns* games, int game)
+{
+    return games->time[game];
 }
 
-int getTime(Game game)
+//Scans over all the games:
+int getPlayerTotalPlayTime(const GameColumns* games, int player_id, int* game_count)
 {
-    return game->game_time;
+    int total_time = scanPlayerGameTimes(games->player1, games->player2, games->time, games->count,
+                                         player_id, game_count);
+
+    //The kernel counts every game the player is listed in. Forfeited games are rare, so the
+    //status column is only walked when there are some, to take out the ones the player lost by
+    //being removed.
+    for (int game = 0; games->forfeited_count > 0 && game < games->count; ++game)
+    {
+        if (isPlayerForfeited(games, game)
+            && (games->player1[game] == player_id || games->player2[game] == player_id)
+            && getWinnerId(games, game) != player_id)
+        {
+            total_time = (int)((unsigned int)total_time - (unsigned int)games->time[game]);
+            --(*game_count);
+        }
+    }
+
+    return total_time;
 }
 
+void getGamesTimeStatistics(const GameColumns* games, int* longest_time, int* total_time)
+{
+    scanGameTimes(games->time, games->count, longest_time, total_time);
+}
 
 //additional functions:
-Game copyGame(Game src)
+bool copyGameColumns(GameColumns* destination, const GameColumns* source, Arena arena)
 {
-    if(!src)
+    initGameColumns(destination, arena);
+    if (source->count == 0)
     {
-        return NULL;
+        return true;
     }
 
-    Game copy = malloc(sizeof(*copy));
-    if(copy==NULL)
+    if (!growGameColumns(destination, source->count))
     {
-        return NULL;
+        freeGameColumns(destination);
+        return false;
     }
 
-    copy->game_time = src->game_time;
-    copy->id_player1 = src->id_player1;
-    copy->id_player2 = src->id_player2;
-    copy->winner = src->winner;
-    copy->auto_win = src->auto_win;
+    memcpy(destination->player1, source->player1, sizeof(*(source->player1)) * source->count);
+    memcpy(destination->player2, source->player2, sizeof(*(source->player2)) * source->count);
+    memcpy(destination->time, source->time, sizeof(*(source->time)) * source->count);
+    memcpy(destination->status, source->status, sizeof(*(source->status)) * source->count);
+    destination->forfeited_count = source->forfeited_count;
+    destination->total_time = source->total_time;
+    destination->count = source->count;
 
-    return copy;
+    return true;
 }
 
-bool didPlayerPlay(Game game, int player_id)
+bool didPlayerPlay(const GameColumns* games, int game, int player_id)
 {
     return
-        ((!isPlayerForfeited(game) && (getPlayer1Id(game) == player_id || getPlayer2Id(game) == player_id))
-        || (isPlayerForfeited(game) && getWinnerId(game) == player_id));
+        ((!isPlayerForfeited(games, game)
+            && (getPlayer1Id(games, game) == player_id || getPlayer2Id(games, game) == player_id))
+        || (isPlayerForfeited(games, game) && getWinnerId(games, game) == player_id));
 }
 
-//Map-related functions:
-MapDataElement mapGameCopy(MapDataElement game)
+//Static auxiliary functions:
+static bool growGameColumns(GameColumns* games, int capacity)
 {
-    return copyGame((Game)game);
-}
+    //All the columns are allocated before any is replaced, so a failure leaves the table untouched.
+    int* player1 = allocateColumn(games, sizeof(*player1) * capacity);
+    int* player2 = allocateColumn(games, sizeof(*player2) * capacity);
+    int* time = allocateColumn(games, sizeof(*time) * capacity);
+    unsigned char* status = allocateColumn(games, sizeof(*status) * capacity);
+    if (player1 == NULL || player2 == NULL || time == NULL || status == NULL)
+    {
+        freeColumn(games, player1, sizeof(*player1) * capacity);
+        freeColumn(games, player2, sizeof(*player2) * capacity);
+        freeColumn(games, time, sizeof(*time) * capacity);
+        freeColumn(games, status, sizeof(*status) * capacity);
+        return false;
+    }
 
-MapKeyElement mapGameIdCopy(MapKeyElement id)
-{
-    int *new = malloc(sizeof(int));
-    if (new == NULL)
+    if (games->count > 0)
     {
-        return NULL;
+        memcpy(player1, games->player1, sizeof(*player1) * games->count);
+        memcpy(player2, games->player2, sizeof(*player2) * games->count);
+        memcpy(time, games->time, sizeof(*time) * games->count);
+        memcpy(status, games->status, sizeof(*status) * games->count);
     }
-    *new = *((int*)id);
-    return new;
+    freeColumns(games);
+
+    games->player1 = player1;
+    games->player2 = player2;
+    games->time = time;
+    games->status = status;
+    games->capacity = capacity;
+    return true;
 }
 
-void mapGameDataFree(MapDataElement game)
+static void freeColumns(GameColumns* games)
 {
-    freeGame((Game)game);
+    freeColumn(games, games->player1, sizeof(*(games->player1)) * games->capacity);
+    freeColumn(games, games->player2, sizeof(*(games->player2)) * games->capacity);
+    freeColumn(games, games->time, sizeof(*(games->time)) * games->capacity);
+    freeColumn(games, games->status, sizeof(*(games->status)) * games->capacity);
 }
 
-void mapGameIdFree(MapKeyElement gameId)
+static void* allocateColumn(GameColumns* games, size_t size)
 {
-    free((int*)gameId);
+    if (games->arena == NULL)
+    {
+        return trackedMalloc(MEMORY_GAMES, size);
+    }
+    return arenaAllocate(games->arena, size);
 }
 
-int mapGameKeyCompare(MapKeyElement id1, MapKeyElement id2)
+static void freeColumn(GameColumns* games, void* column, size_t size)
 {
-    return (*((int*)id1) - *((int*)id2));
+    if (games->arena == NULL)
+    {
+        trackedFree(MEMORY_GAMES, column, size);
+    }
+    else
+    {
+        arenaRelease(games->arena, column, size);
+    }
 }
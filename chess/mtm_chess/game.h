@@ -1,51 +1,76 @@
 #ifndef GAME_H
 #define GAME_H
 
-typedef struct Game_t *Game;
-
 #include <stdbool.h>
 #include <stdio.h>
-#include "tournament.h"
 #include "chessSystem.h"
-#include "map.h"
+#include "arena.h"
 
 #define NO_WINNER -1
 
+//A tournament's games, stored column by column so that scans over one attribute read contiguous memory.
+//Game i is (player1[i], player2[i], status[i], time[i]): 13 bytes per game, with no per-game allocation.
+//A status byte packs the Winner (GAME_WINNER_MASK) and a flag (GAME_FORFEITED) set once one of the
+//players was removed from the system (the game was then won automatically).
+//Games are numbered by insertion order and never removed, so the index is the game's id.
+//The players are stored as the internal indices the system's player table gave their ids (see
+//player.h); like ids, these are positive and never change, so the "ids" below are those indices.
+#define GAME_WINNER_MASK 0x3
+#define GAME_FORFEITED 0x4
 
+typedef struct GameColumns_t
+{
+    int* player1;
+    int* player2;
+    int* time;
+    unsigned char* status;
+    int forfeited_count;
+    long long total_time; //Sum of time[], kept up to date by appendGame.
+    int count;
+    int capacity;
+    Arena arena; //Where the columns are allocated; NULL for the heap.
+} GameColumns;
 
 //Construction & destruction:
-Game createGame(int id_player1, int id_player2, Winner winner, int game_time, ChessResult* error);
+//The columns will be allocated from the given arena, or from the heap if it is NULL.
+void initGameColumns(GameColumns* games, Arena arena);
+//Frees the columns; the table is left empty, with the same arena.
+void freeGameColumns(GameColumns* games);
 
-void freeGame(Game game);
+//Appends a game after validating it. Returns CHESS_INVALID_ID, CHESS_INVALID_PLAY_TIME,
+//CHESS_OUT_OF_MEMORY or CHESS_SUCCESS.
+ChessResult appendGame(GameColumns* games, int id_player1, int id_player2, Winner winner, int game_time);
 
 //Getters & setters:
-int getPlayer1Id(Game game);
-int getPlayer2Id(Game game);
-Winner getWinner(Game game);
-int getWinnerId(Game game);
-bool isPlayerForfeited(Game game);
-bool didPlayerForfeit(Game game, int player_id);
-void setPlayerForfeited(Game game, int player_to_remove_id, Map players);
-int getTime(Game game);
+int getPlayer1Id(const GameColumns* games, int game);
+int getPlayer2Id(const GameColumns* games, int game);
+Winner getWinner(const GameColumns* games, int game);
+int getWinnerId(const GameColumns* games, int game);
+bool isPlayerForfeited(const GameColumns* games, int game);
+bool didPlayerForfeit(const GameColumns* games, int game, int player_id);
+//Marks the game as won by the other player. If the other player had lost the game, their id is
+//returned so their statistics can be updated; otherwise NO_WINNER is returned.
+int setPlayerForfeited(GameColumns* games, int game, int player_to_remove_id);
+int getTime(const GameColumns* games, int game);
 
 //Returns the length of the game if given player participated in it; else returns 0.
-int getPlayerPlayTime(Game game, int player_id);
+int getPlayerPlayTime(const GameColumns* games, int game, int player_id);
+
+//Scans over all the games (vectorized, see gameKernels.h):
+//Returns the total length of the games the player participated in (as defined by didPlayerPlay),
+//and puts their number in game_count.
+int getPlayerTotalPlayTime(const GameColumns* games, int player_id, int* game_count);
+//Puts the length of the longest game (0 if there are none) in longest_time and the sum in total_time.
+void getGamesTimeStatistics(const GameColumns* games, int* longest_time, int* total_time);
 
 //additional functions:
-Game copyGame(Game src);
+//The copy's columns are allocated from the given arena (the heap if it is NULL).
+//Returns false if an allocation failed; destination is then left empty.
+bool copyGameColumns(GameColumns* destination, const GameColumns* source, Arena arena);
 
 //This returns true if the player was one of the players, else false.
 //! NOTE: If player played but was removed (i.e player lost in auto-win), the value will be false.
 //(As per our instructions.)
-bool didPlayerPlay(Game game, int player_id);
-
-
-
-//Map-related functions:
-MapDataElement mapGameCopy(MapDataElement game);
-MapKeyElement mapGameIdCopy(MapKeyElement id);
-void mapGameDataFree(MapDataElement game);
-void mapGameIdFree(MapKeyElement gameId);
-int mapGameKeyCompare(MapKeyElement id1, MapKeyElement id2);
+bool didPlayerPlay(const GameColumns* games, int game, int player_id);
 
 #endif
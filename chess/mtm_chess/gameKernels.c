@@ -0,0 +1,295 @@
+#define _POSIX_C_SOURCE 200112L //For pthreads under -std=c99.
+
+#include "gameKernels.h"
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GAME_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*TimesKernel)(const int* times, int count, int* longest_time, int* total_time);
+typedef int (*PlayerTimesKernel)(const int* player1, const int* player2, const int* times, int count,
+                                 int player_id, int* game_count);
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static GameKernelsLevel kernels_level;
+static TimesKernel times_kernel;
+static PlayerTimesKernel player_times_kernel;
+
+//Declaring static auxiliary functions:
+static void selectBestKernels(void);
+static bool isLevelSupported(GameKernelsLevel level);
+static void useKernels(GameKernelsLevel level);
+
+static void scanGameTimesScalar(const int* times, int count, int* longest_time, int* total_time);
+static int scanPlayerGameTimesScalar(const int* player1, const int* player2, const int* times, int count,
+                                     int player_id, int* game_count);
+#ifdef GAME_KERNELS_X86
+static void scanGameTimesSse2(const int* times, int count, int* longest_time, int* total_time);
+static int scanPlayerGameTimesSse2(const int* player1, const int* player2, const int* times, int count,
+                                   int player_id, int* game_count);
+static void scanGameTimesAvx2(const int* times, int count, int* longest_time, int* total_time);
+static int scanPlayerGameTimesAvx2(const int* player1, const int* player2, const int* times, int count,
+                                   int player_id, int* game_count);
+#endif
+
+GameKernelsLevel getGameKernelsLevel(void)
+{
+    pthread_once(&kernels_once, &selectBestKernels);
+    return kernels_level;
+}
+
+bool setGameKernelsLevel(GameKernelsLevel level)
+{
+    pthread_once(&kernels_once, &selectBestKernels);
+    if (!isLevelSupported(level))
+    {
+        return false;
+    }
+
+    useKernels(level);
+    return true;
+}
+
+void scanGameTimes(const int* times, int count, int* longest_time, int* total_time)
+{
+    pthread_once(&kernels_once, &selectBestKernels);
+    times_kernel(times, count, longest_time, total_time);
+}
+
+int scanPlayerGameTimes(const int* player1, const int* player2, const int* times, int count,
+                        int player_id, int* game_count)
+{
+    pthread_once(&kernels_once, &selectBestKernels);
+    return player_times_kernel(player1, player2, times, count, player_id, game_count);
+}
+
+
+//Static auxiliary functions:
+static void selectBestKernels(void)
+{
+    if (isLevelSupported(GAME_KERNELS_AVX2))
+    {
+        useKernels(GAME_KERNELS_AVX2);
+    }
+    else if (isLevelSupported(GAME_KERNELS_SSE2))
+    {
+        useKernels(GAME_KERNELS_SSE2);
+    }
+    else
+    {
+        useKernels(GAME_KERNELS_SCALAR);
+    }
+}
+
+static bool isLevelSupported(GameKernelsLevel level)
+{
+    if (level == GAME_KERNELS_SCALAR)
+    {
+        return true;
+    }
+#ifdef GAME_KERNELS_X86
+    __builtin_cpu_init();
+    if (level == GAME_KERNELS_SSE2)
+    {
+        return __builtin_cpu_supports("sse2");
+    }
+    if (level == GAME_KERNELS_AVX2)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return false;
+}
+
+static void useKernels(GameKernelsLevel level)
+{
+    kernels_level = level;
+    times_kernel = &scanGameTimesScalar;
+    player_times_kernel = &scanPlayerGameTimesScalar;
+
+#ifdef GAME_KERNELS_X86
+    if (level == GAME_KERNELS_SSE2)
+    {
+        times_kernel = &scanGameTimesSse2;
+        player_times_kernel = &scanPlayerGameTimesSse2;
+    }
+    else if (level == GAME_KERNELS_AVX2)
+    {
+        times_kernel = &scanGameTimesAvx2;
+        player_times_kernel = &scanPlayerGameTimesAvx2;
+    }
+#endif
+}
+
+//Scalar kernels. Sums are unsigned so that wrapping around is defined.
+static void scanGameTimesScalar(const int* times, int count, int* longest_time, int* total_time)
+{
+    int longest = 0;
+    unsigned int total = 0;
+
+    for (int game = 0; game < count; ++game)
+    {
+        longest = times[game] > longest ? times[game] : longest;
+        total += (unsigned int)times[game];
+    }
+
+    *longest_time = longest;
+    *total_time = (int)total;
+}
+
+static int scanPlayerGameTimesScalar(const int* player1, const int* player2, const int* times, int count,
+                                     int player_id, int* game_count)
+{
+    unsigned int total = 0;
+    int games = 0;
+
+    for (int game = 0; game < count; ++game)
+    {
+        if (player1[game] == player_id || player2[game] == player_id)
+        {
+            total += (unsigned int)times[game];
+            ++games;
+        }
+    }
+
+    *game_count = games;
+    return (int)total;
+}
+
+#ifdef GAME_KERNELS_X86
+//SSE2 kernels: 4 games per step. SSE2 has no 32-bit max, so it's built from a compare and a select.
+__attribute__((target("sse2")))
+static void scanGameTimesSse2(const int* times, int count, int* longest_time, int* total_time)
+{
+    __m128i longest = _mm_setzero_si128(), total = _mm_setzero_si128();
+    int game = 0;
+
+    for (; game + 4 <= count; game += 4)
+    {
+        __m128i current = _mm_loadu_si128((const __m128i*)(times + game));
+        __m128i greater = _mm_cmpgt_epi32(current, longest);
+        longest = _mm_or_si128(_mm_and_si128(greater, current), _mm_andnot_si128(greater, longest));
+        total = _mm_add_epi32(total, current);
+    }
+
+    int lanes_longest[4], lanes_total[4];
+    _mm_storeu_si128((__m128i*)lanes_longest, longest);
+    _mm_storeu_si128((__m128i*)lanes_total, total);
+
+    int tail_longest, tail_total;
+    scanGameTimesScalar(times + game, count - game, &tail_longest, &tail_total);
+
+    unsigned int sum = (unsigned int)tail_total;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        tail_longest = lanes_longest[lane] > tail_longest ? lanes_longest[lane] : tail_longest;
+        sum += (unsigned int)lanes_total[lane];
+    }
+
+    *longest_time = tail_longest;
+    *total_time = (int)sum;
+}
+
+__attribute__((target("sse2")))
+static int scanPlayerGameTimesSse2(const int* player1, const int* player2, const int* times, int count,
+                                   int player_id, int* game_count)
+{
+    __m128i id = _mm_set1_epi32(player_id);
+    __m128i total = _mm_setzero_si128(), games = _mm_setzero_si128();
+    int game = 0;
+
+    for (; game + 4 <= count; game += 4)
+    {
+        __m128i played = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(player1 + game)), id),
+            _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(player2 + game)), id));
+        total = _mm_add_epi32(total, _mm_and_si128(played, _mm_loadu_si128((const __m128i*)(times + game))));
+        games = _mm_sub_epi32(games, played); //Matching lanes are -1.
+    }
+
+    int lanes_total[4], lanes_games[4];
+    _mm_storeu_si128((__m128i*)lanes_total, total);
+    _mm_storeu_si128((__m128i*)lanes_games, games);
+
+    int tail_games;
+    unsigned int sum = (unsigned int)scanPlayerGameTimesScalar(player1 + game, player2 + game, times + game,
+                                                               count - game, player_id, &tail_games);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        sum += (unsigned int)lanes_total[lane];
+        tail_games += lanes_games[lane];
+    }
+
+    *game_count = tail_games;
+    return (int)sum;
+}
+
+//AVX2 kernels: 8 games per step.
+__attribute__((target("avx2")))
+static void scanGameTimesAvx2(const int* times, int count, int* longest_time, int* total_time)
+{
+    __m256i longest = _mm256_setzero_si256(), total = _mm256_setzero_si256();
+    int game = 0;
+
+    for (; game + 8 <= count; game += 8)
+    {
+        __m256i current = _mm256_loadu_si256((const __m256i*)(times + game));
+        longest = _mm256_max_epi32(longest, current);
+        total = _mm256_add_epi32(total, current);
+    }
+
+    int lanes_longest[8], lanes_total[8];
+    _mm256_storeu_si256((__m256i*)lanes_longest, longest);
+    _mm256_storeu_si256((__m256i*)lanes_total, total);
+
+    int tail_longest, tail_total;
+    scanGameTimesScalar(times + game, count - game, &tail_longest, &tail_total);
+
+    unsigned int sum = (unsigned int)tail_total;
+    for (int lane = 0; lane < 8; ++lane)
+    {
+        tail_longest = lanes_longest[lane] > tail_longest ? lanes_longest[lane] : tail_longest;
+        sum += (unsigned int)lanes_total[lane];
+    }
+
+    *longest_time = tail_longest;
+    *total_time = (int)sum;
+}
+
+__attribute__((target("avx2")))
+static int scanPlayerGameTimesAvx2(const int* player1, const int* player2, const int* times, int count,
+                                   int player_id, int* game_count)
+{
+    __m256i id = _mm256_set1_epi32(player_id);
+    __m256i total = _mm256_setzero_si256(), games = _mm256_setzero_si256();
+    int game = 0;
+
+    for (; game + 8 <= count; game += 8)
+    {
+        __m256i played = _mm256_or_si256(
+            _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(player1 + game)), id),
+            _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(player2 + game)), id));
+        total = _mm256_add_epi32(total,
+                                 _mm256_and_si256(played, _mm256_loadu_si256((const __m256i*)(times + game))));
+        games = _mm256_sub_epi32(games, played); //Matching lanes are -1.
+    }
+
+    int lanes_total[8], lanes_games[8];
+    _mm256_storeu_si256((__m256i*)lanes_total, total);
+    _mm256_storeu_si256((__m256i*)lanes_games, games);
+
+    int tail_games;
+    unsigned int sum = (unsigned int)scanPlayerGameTimesScalar(player1 + game, player2 + game, times + game,
+                                                               count - game, player_id, &tail_games);
+    for (int lane = 0; lane < 8; ++lane)
+    {
+        sum += (unsigned int)lanes_total[lane];
+        tail_games += lanes_games[lane];
+    }
+
+    *game_count = tail_games;
+    return (int)sum;
+}
+#endif
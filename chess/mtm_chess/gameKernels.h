@@ -0,0 +1,36 @@
+#ifndef GAME_KERNELS_H
+#define GAME_KERNELS_H
+
+#include <stdbool.h>
+
+/**
+* Vectorized scans over the game columns (see GameColumns in game.h).
+*
+* Each scan has a portable scalar version, and SSE2 and AVX2 versions on x86 compilers.
+* The best version the CPU supports is picked on first use.
+*
+* Sums wrap around like the int accumulators they replace.
+*/
+
+typedef enum {
+    GAME_KERNELS_SCALAR,
+    GAME_KERNELS_SSE2,
+    GAME_KERNELS_AVX2
+} GameKernelsLevel;
+
+//Returns the level used by the scans.
+GameKernelsLevel getGameKernelsLevel(void);
+
+//Forces a level, for benchmarks and tests. Must not be called while scans are running.
+//Returns false (keeping the current level) if the CPU or the compiler doesn't support the level.
+bool setGameKernelsLevel(GameKernelsLevel level);
+
+//Puts the longest of times[0..count) (0 if there are none) in longest_time and their sum in total_time.
+void scanGameTimes(const int* times, int count, int* longest_time, int* total_time);
+
+//Returns the sum of times[i] over the games where player1[i] or player2[i] is player_id,
+//and puts the number of those games in game_count.
+int scanPlayerGameTimes(const int* player1, const int* player2, const int* times, int count,
+                        int player_id, int* game_count);
+
+#endif //GAME_KERNELS_H
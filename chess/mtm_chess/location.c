@@ -0,0 +1,254 @@
+#include "location.h"
+#include "memoryStats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define INITIAL_TOURNAMENTS_CAPACITY 4
+
+struct LocationTable_t
+{
+    //Maps each string to its Location. The map owns the Locations but never copies them, so
+    //handles stay valid until their last reference is dropped.
+    Map locations;
+};
+
+//One tournament held at a location. The id is kept next to the handle so the index can be
+//searched without touching the tournaments.
+typedef struct LocationTournament_t
+{
+    int tournament_id;
+    struct Tournament_t* tournament;
+} LocationTournament;
+
+struct Location_t
+{
+    LocationTable table;
+    int references;
+    LocationTournament* tournaments;
+    int tournament_count;
+    int tournament_capacity;
+    char name[];
+};
+
+//Declaring static auxiliary functions:
+static MapDataElement mapLocationShare(MapDataElement location);
+static MapKeyElement mapLocationNameCopy(MapKeyElement name);
+static void mapLocationFree(MapDataElement location);
+static void mapLocationNameFree(MapKeyElement name);
+static int mapLocationNameCompare(MapKeyElement name1, MapKeyElement name2);
+//Returns the index of the first tournament whose id is not smaller than the given one.
+static int findTournamentPosition(Location location, int tournament_id);
+
+//Construction & destruction:
+LocationTable createLocationTable(void)
+{
+    LocationTable table = trackedMalloc(MEMORY_LOCATIONS, sizeof(*table));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    table->locations = mapCreate(&mapLocationShare,
+                                 &mapLocationNameCopy,
+                                 &mapLocationFree,
+                                 &mapLocationNameFree,
+                                 &mapLocationNameCompare);
+    if (table->locations == NULL)
+    {
+        trackedFree(MEMORY_LOCATIONS, table, sizeof(*table));
+        return NULL;
+    }
+
+    return table;
+}
+
+void destroyLocationTable(LocationTable table)
+{
+    if (table == NULL)
+    {
+        return;
+    }
+
+    assert(mapGetSize(table->locations) == 0);
+    mapDestroy(table->locations);
+    trackedFree(MEMORY_LOCATIONS, table, sizeof(*table));
+}
+
+Location internLocation(LocationTable table, const char* name)
+{
+    Location location = mapGet(table->locations, (MapKeyElement)name);
+    if (location != NULL)
+    {
+        return retainLocation(location);
+    }
+
+    location = trackedMalloc(MEMORY_LOCATIONS, sizeof(*location) + strlen(name) + 1);
+    if (location == NULL)
+    {
+        return NULL;
+    }
+    location->table = table;
+    location->references = 1;
+    location->tournaments = NULL;
+    location->tournament_count = 0;
+    location->tournament_capacity = 0;
+    strcpy(location->name, name);
+
+    //On failure the map already freed the location (its copy is the location itself).
+    if (mapPut(table->locations, location->name, location) != MAP_SUCCESS)
+    {
+        return NULL;
+    }
+
+    return location;
+}
+
+Location retainLocation(Location location)
+{
+    ++location->references;
+    return location;
+}
+
+void releaseLocation(Location location)
+{
+    if (location == NULL)
+    {
+        return;
+    }
+
+    assert(location->references > 0);
+    if (--location->references == 0)
+    {
+        mapRemove(location->table->locations, location->name);
+    }
+}
+
+Location findLocation(LocationTable table, const char* name)
+{
+    return mapGet(table->locations, (MapKeyElement)name);
+}
+
+//Getters:
+const char* getLocationName(Location location)
+{
+    return location->name;
+}
+
+int getLocationCount(LocationTable table)
+{
+    return mapGetSize(table->locations);
+}
+
+//Tournaments index:
+bool addLocationTournament(Location location, int tournament_id, struct Tournament_t* tournament)
+{
+    if (location->tournament_count == location->tournament_capacity)
+    {
+        int capacity = location->tournament_capacity == 0 ? INITIAL_TOURNAMENTS_CAPACITY
+                                                          : 2 * location->tournament_capacity;
+        LocationTournament* tournaments = trackedRealloc(MEMORY_LOCATIONS, location->tournaments,
+                                                         sizeof(*tournaments) * location->tournament_capacity,
+                                                         sizeof(*tournaments) * capacity);
+        if (tournaments == NULL)
+        {
+            return false;
+        }
+        location->tournaments = tournaments;
+        location->tournament_capacity = capacity;
+    }
+
+    int position = findTournamentPosition(location, tournament_id);
+    assert(position == location->tournament_count
+           || location->tournaments[position].tournament_id != tournament_id);
+    memmove(location->tournaments + position + 1, location->tournaments + position,
+            sizeof(*(location->tournaments)) * (location->tournament_count - position));
+    location->tournaments[position].tournament_id = tournament_id;
+    location->tournaments[position].tournament = tournament;
+    ++location->tournament_count;
+
+    return true;
+}
+
+void removeLocationTournament(Location location, int tournament_id)
+{
+    int position = findTournamentPosition(location, tournament_id);
+    if (position == location->tournament_count || location->tournaments[position].tournament_id != tournament_id)
+    {
+        return;
+    }
+
+    --location->tournament_count;
+    memmove(location->tournaments + position, location->tournaments + position + 1,
+            sizeof(*(location->tournaments)) * (location->tournament_count - position));
+}
+
+int getLocationTournamentCount(Location location)
+{
+    return location->tournament_count;
+}
+
+int getLocationTournamentId(Location location, int index)
+{
+    assert(index >= 0 && index < location->tournament_count);
+    return location->tournaments[index].tournament_id;
+}
+
+struct Tournament_t* getLocationTournament(Location location, int index)
+{
+    assert(index >= 0 && index < location->tournament_count);
+    return location->tournaments[index].tournament;
+}
+
+
+//Static auxiliary functions:
+static MapDataElement mapLocationShare(MapDataElement location)
+{
+    return location;
+}
+
+static MapKeyElement mapLocationNameCopy(MapKeyElement name)
+{
+    char* copy = trackedMalloc(MEMORY_MAP_KEYS, strlen((char*)name) + 1);
+    if (copy != NULL)
+    {
+        strcpy(copy, (char*)name);
+    }
+    return copy;
+}
+
+static void mapLocationFree(MapDataElement data)
+{
+    Location location = data;
+    trackedFree(MEMORY_LOCATIONS, location->tournaments,
+                sizeof(*(location->tournaments)) * location->tournament_capacity);
+    trackedFree(MEMORY_LOCATIONS, location, sizeof(*location) + strlen(location->name) + 1);
+}
+
+static void mapLocationNameFree(MapKeyElement name)
+{
+    trackedFree(MEMORY_MAP_KEYS, name, strlen((char*)name) + 1);
+}
+
+static int mapLocationNameCompare(MapKeyElement name1, MapKeyElement name2)
+{
+    return strcmp((char*)name1, (char*)name2);
+}
+
+static int findTournamentPosition(Location location, int tournament_id)
+{
+    int low = 0, high = location->tournament_count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (location->tournaments[middle].tournament_id < tournament_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
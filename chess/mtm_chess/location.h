@@ -0,0 +1,46 @@
+#ifndef LOCATION_H
+#define LOCATION_H
+
+#include <stdbool.h>
+#include "map.h"
+
+//Interned tournament locations: every distinct location string is stored once per chess system,
+//and tournaments hold a reference-counted handle to it. Two handles from the same table are equal
+//exactly when their strings are, so locations can be compared by pointer.
+
+//Types to expose:
+typedef struct LocationTable_t *LocationTable;
+typedef struct Location_t *Location;
+
+struct Tournament_t; //See tournament.h.
+
+//Construction & destruction:
+LocationTable createLocationTable(void);
+//Every location taken from the table must have been released before.
+void destroyLocationTable(LocationTable table);
+
+//Returns a new reference to the handle of the given string, adding it to the table if needed.
+//Returns NULL if an allocation failed.
+Location internLocation(LocationTable table, const char* name);
+//Returns a new reference to the same handle.
+Location retainLocation(Location location);
+//Drops a reference; the string is removed from the table with its last reference.
+void releaseLocation(Location location);
+
+//Returns the handle of the given string without taking a reference, or NULL if it isn't in the table.
+Location findLocation(LocationTable table, const char* name);
+
+//Getters:
+const char* getLocationName(Location location);
+int getLocationCount(LocationTable table);
+
+//Index of the tournaments held at a location, by ascending id. The chess system adds the tournaments
+//it stores and removes them with the tournament, so the index never outlives its entries.
+//Returns false if an allocation failed; the index is then unchanged.
+bool addLocationTournament(Location location, int tournament_id, struct Tournament_t* tournament);
+void removeLocationTournament(Location location, int tournament_id);
+int getLocationTournamentCount(Location location);
+int getLocationTournamentId(Location location, int index);
+struct Tournament_t* getLocationTournament(Location location, int index);
+
+#endif
@@ -1,5 +1,18 @@
+#define _POSIX_C_SOURCE 200112L //For pthreads under -std=c99.
+
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
 #include "chessSystem.h"
+#include "map.h"
+#include "player.h"
+#include "game.h"
+#include "gameKernels.h"
+#include "location.h"
+#include "tournament.h"
+#include "typedMap.h"
+#include "roaringBitmap.h"
 #include "test_utilities.h"
 
 
@@ -456,8 +469,1188 @@ bool testSavePlayerLevelsAndTournamentStatistics_maaroof()
     return true;
 }
 
-
 /*The functions for the tests should be added here*/
+//Checks that both systems save the same players levels.
+static bool assertSameLevels(ChessSystem first, ChessSystem second)
+{
+    FILE* first_levels = tmpfile();
+    FILE* second_levels = tmpfile();
+    bool same = first_levels != NULL && second_levels != NULL
+        && chessSavePlayersLevels(first, first_levels) == CHESS_SUCCESS
+        && chessSavePlayersLevels(second, second_levels) == CHESS_SUCCESS;
+    if (same)
+    {
+        rewind(first_levels);
+        rewind(second_levels);
+        same = compareFile(first_levels, second_levels) == 0;
+    }
+    if (first_levels != NULL)
+    {
+        fclose(first_levels);
+    }
+    if (second_levels != NULL)
+    {
+        fclose(second_levels);
+    }
+    return same;
+}
+
+//Checks that both systems save the same tournament statistics.
+static bool assertSameStatistics(ChessSystem first, ChessSystem second)
+{
+    bool same = chessSaveTournamentStatistics(first, "first_statistics.txt") == CHESS_SUCCESS
+        && chessSaveTournamentStatistics(second, "second_statistics.txt") == CHESS_SUCCESS;
+    FILE* first_statistics = fopen("first_statistics.txt", "r");
+    FILE* second_statistics = fopen("second_statistics.txt", "r");
+    same = same && first_statistics != NULL && second_statistics != NULL
+        && compareFile(first_statistics, second_statistics) == 0;
+    if (first_statistics != NULL)
+    {
+        fclose(first_statistics);
+    }
+    if (second_statistics != NULL)
+    {
+        fclose(second_statistics);
+    }
+    remove("first_statistics.txt");
+    remove("second_statistics.txt");
+    return same;
+}
+
+static void fillLargeSystem(ChessSystem chess)
+{
+    unsigned int seed = 7;
+    for (int tournament = 1; tournament <= 200; ++tournament)
+    {
+        chessAddTournament(chess, tournament, 1000, "London");
+    }
+    for (int game = 0; game < 20000; ++game)
+    {
+        seed = seed * 1103515245 + 12345;
+        int player1 = 1 + (seed >> 8) % 10000;
+        seed = seed * 1103515245 + 12345;
+        int player2 = 1 + (seed >> 8) % 10000;
+        chessAddGame(chess, 1 + game % 200, player1, player2, game % 3, game % 97);
+    }
+    chessRemovePlayer(chess, 5);
+    for (int tournament = 1; tournament <= 200; tournament += 2)
+    {
+        chessEndTournament(chess, tournament);
+    }
+}
+
+bool testChessSetWorkerCount() {
+    ChessSystem serial = chessCreate(), parallel = chessCreate();
+    ASSERT_TEST(chessSetWorkerCount(NULL, 2) == CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(chessSetWorkerCount(serial, 0) == CHESS_INVALID_WORKER_COUNT);
+    ASSERT_TEST(chessSetWorkerCount(serial, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSetWorkerCount(parallel, 8) == CHESS_SUCCESS);
+    fillLargeSystem(serial);
+    fillLargeSystem(parallel);
+
+    ChessResult serial_result, parallel_result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(serial, 17, &serial_result)
+                == chessCalculateAveragePlayTime(parallel, 17, &parallel_result));
+    ASSERT_TEST(serial_result == parallel_result);
+
+    ASSERT_TEST(assertSameLevels(serial, parallel));
+    ASSERT_TEST(assertSameStatistics(serial, parallel));
+
+    chessDestroy(serial);
+    chessDestroy(parallel);
+    return true;
+}
+
+bool testChessSavePlayersLevelsOrder() {
+    //Each worker sorts its own chunk, and the merged file must still be in one global order.
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessSetWorkerCount(chess, 8) == CHESS_SUCCESS);
+    fillLargeSystem(chess);
+    FILE* levels = tmpfile();
+    ASSERT_TEST(chessSavePlayersLevels(chess, levels) == CHESS_SUCCESS);
+    rewind(levels);
+
+    int id, previous_id = 0, line_count = 0;
+    double level, previous_level = 0;
+    while (fscanf(levels, "%d %lf", &id, &level) == 2) {
+        //Higher levels first, equal levels by ascending id.
+        ASSERT_TEST(line_count == 0 || level < previous_level
+                    || (level == previous_level && id > previous_id));
+        previous_id = id;
+        previous_level = level;
+        ++line_count;
+    }
+    ASSERT_TEST(feof(levels) && line_count > 9000);
+    fclose(levels);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessLocationQueries() {
+    ChessSystem sys1 = chessCreate();
+    ASSERT_TEST(chessAddTournament(sys1, 3, 4, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(sys1, 1, 4, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(sys1, 2, 4, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(sys1, 4, 4, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 1, 1, 2, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 1, 1, 3, DRAW, 20) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 3, 1, 2, SECOND_PLAYER, 60) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 2, 1, 2, SECOND_PLAYER, 1000) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(sys1, 3) == CHESS_SUCCESS);
+
+    ChessResult result;
+    int ids[3];
+    ASSERT_TEST(chessGetLocationTournaments(sys1, "Paris", false, ids, 3, &result) == 3);
+    ASSERT_TEST(result == CHESS_SUCCESS);
+    ASSERT_TEST(ids[0] == 1 && ids[1] == 3 && ids[2] == 4);
+    ASSERT_TEST(chessGetLocationTournaments(sys1, "Paris", true, ids, 3, &result) == 1);
+    ASSERT_TEST(ids[0] == 3);
+    ASSERT_TEST(chessGetLocationTournaments(sys1, "Paris", false, NULL, 0, &result) == 3);
+    ASSERT_TEST(chessGetLocationTournaments(sys1, "Rome", false, ids, 3, &result) == 0);
+    ASSERT_TEST(result == CHESS_SUCCESS);
+    chessGetLocationTournaments(NULL, "Paris", false, ids, 3, &result);
+    ASSERT_TEST(result == CHESS_NULL_ARGUMENT);
+
+    ChessLocationStatistics statistics;
+    ASSERT_TEST(chessGetLocationStatistics(sys1, "Paris", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.tournament_count == 3);
+    ASSERT_TEST(statistics.ended_tournament_count == 1);
+    ASSERT_TEST(statistics.game_count == 3);
+    ASSERT_TEST(statistics.average_game_time == 30);
+
+    ASSERT_TEST(chessRemoveTournament(sys1, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetLocationTournaments(sys1, "Paris", false, ids, 3, &result) == 2);
+    ASSERT_TEST(ids[0] == 3 && ids[1] == 4);
+    ASSERT_TEST(chessGetLocationStatistics(sys1, "Paris", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.game_count == 1 && statistics.average_game_time == 60);
+    ASSERT_TEST(chessRemoveTournament(sys1, 2) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetLocationStatistics(sys1, "London", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.tournament_count == 0 && statistics.average_game_time == 0);
+
+    chessDestroy(sys1);
+    return true;
+}
+
+static long long liveBytes(const ChessMemoryStats* statistics) {
+    return statistics->map_nodes.live_bytes + statistics->map_keys.live_bytes + statistics->players.live_bytes
+        + statistics->games.live_bytes + statistics->tournaments.live_bytes + statistics->locations.live_bytes
+        + statistics->arenas.live_bytes + statistics->maps.live_bytes + statistics->systems.live_bytes;
+}
+
+bool testChessGetMemoryStats() {
+    ChessMemoryStats before, during, after;
+    ASSERT_TEST(chessGetMemoryStats(NULL) == CHESS_NULL_ARGUMENT);
+    ChessResult result = chessGetMemoryStats(&before);
+    if (result == CHESS_MEMORY_STATS_DISABLED) {
+        return true;
+    }
+    ASSERT_TEST(result == CHESS_SUCCESS);
+
+    ChessSystem sys1 = chessCreate();
+    fillLargeSystem(sys1);
+    //The export keeps the players' order for the next one.
+    FILE* levels = tmpfile();
+    ASSERT_TEST(levels != NULL && chessSavePlayersLevels(sys1, levels) == CHESS_SUCCESS);
+    fclose(levels);
+    ASSERT_TEST(chessGetMemoryStats(&during) == CHESS_SUCCESS);
+    ASSERT_TEST(during.map_nodes.live_bytes > before.map_nodes.live_bytes);
+    ASSERT_TEST(during.map_keys.live_bytes > before.map_keys.live_bytes);
+    ASSERT_TEST(during.players.live_bytes > before.players.live_bytes);
+    ASSERT_TEST(during.games.live_bytes >= 20000 * 13);
+    ASSERT_TEST(during.tournaments.live_bytes > before.tournaments.live_bytes);
+    ASSERT_TEST(during.locations.live_bytes > before.locations.live_bytes);
+    ASSERT_TEST(during.systems.live_bytes > before.systems.live_bytes);
+    ASSERT_TEST(during.games.peak_bytes >= during.games.live_bytes);
+
+    //Everything a system allocates for good is counted, so destroying it gives all of it back.
+    chessDestroy(sys1);
+    ASSERT_TEST(chessGetMemoryStats(&after) == CHESS_SUCCESS);
+    ASSERT_TEST(liveBytes(&after) == liveBytes(&before));
+    ASSERT_TEST(after.games.allocations > before.games.allocations);
+    return true;
+}
+
+bool testChessDumpMetrics() {
+    ASSERT_TEST(chessDumpMetrics(NULL) == CHESS_NULL_ARGUMENT);
+    ChessSystem sys1 = chessCreate();
+    ASSERT_TEST(chessAddTournament(sys1, 1, 2, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 1, 1, 2, FIRST_PLAYER, 5) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(sys1, 1, 1, 2, FIRST_PLAYER, 5) == CHESS_GAME_ALREADY_EXISTS);
+    chessDestroy(sys1);
+
+    FILE* file = tmpfile();
+    ASSERT_TEST(file != NULL);
+    ChessResult result = chessDumpMetrics(file);
+    if (result == CHESS_METRICS_DISABLED) {
+        fclose(file);
+        return true;
+    }
+    ASSERT_TEST(result == CHESS_SUCCESS);
+
+    //Earlier tests also count, so only lower bounds can be checked.
+    char line[512];
+    bool found = false;
+    long long calls = 0, failures = 0;
+    rewind(file);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "api=chessAddGame ", strlen("api=chessAddGame ")) == 0) {
+            found = sscanf(line, "api=chessAddGame calls=%lld failures=%lld", &calls, &failures) == 2;
+        }
+    }
+    fclose(file);
+    ASSERT_TEST(found);
+    ASSERT_TEST(calls >= 2 && failures >= 1);
+    return true;
+}
+
+bool testChessCreateWithArena() {
+    ChessSystem heap = chessCreate(), arena = chessCreateWithArena();
+    ASSERT_TEST(arena != NULL);
+    fillLargeSystem(heap);
+    fillLargeSystem(arena);
+    //Only unfinished tournaments: the games of removed players in finished ones are not forfeited.
+    for (int tournament = 2; tournament <= 40; tournament += 2) {
+        ASSERT_TEST(chessRemoveTournament(heap, tournament) == CHESS_SUCCESS);
+        ASSERT_TEST(chessRemoveTournament(arena, tournament) == CHESS_SUCCESS);
+    }
+    ASSERT_TEST(chessRemovePlayer(heap, 17) == chessRemovePlayer(arena, 17));
+    ASSERT_TEST(chessAddGame(heap, 42, 17, 18, DRAW, 30) == chessAddGame(arena, 42, 17, 18, DRAW, 30));
+
+    ChessResult heap_result, arena_result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(heap, 18, &heap_result)
+                == chessCalculateAveragePlayTime(arena, 18, &arena_result));
+    ASSERT_TEST(heap_result == arena_result);
+
+    ASSERT_TEST(assertSameLevels(heap, arena));
+
+    ChessMemoryStats during, after;
+    ChessResult result = chessGetMemoryStats(&during);
+    chessDestroy(heap);
+    chessDestroy(arena);
+    if (result == CHESS_SUCCESS) {
+        ASSERT_TEST(chessGetMemoryStats(&after) == CHESS_SUCCESS);
+        ASSERT_TEST(during.arenas.live_bytes > 0 && after.arenas.live_bytes == 0);
+    }
+    return true;
+}
+
+bool testChessArenaTournamentChurn() {
+    //Removing a tournament gives all of its memory back, large game columns included.
+    ChessSystem chess = chessCreateWithArena();
+    ASSERT_TEST(chess != NULL);
+    ChessMemoryStats first, last;
+    ChessResult result = CHESS_SUCCESS;
+    for (int round = 0; round < 20; ++round) {
+        ASSERT_TEST(chessAddTournament(chess, 1, 5, "London") == CHESS_SUCCESS);
+        for (int player = 1; player <= 2000; ++player) {
+            ASSERT_TEST(chessAddGame(chess, 1, player, player + 1, DRAW, 10) == CHESS_SUCCESS);
+        }
+        ASSERT_TEST(chessRemoveTournament(chess, 1) == CHESS_SUCCESS);
+        result = chessGetMemoryStats(round == 0 ? &first : &last);
+    }
+    chessDestroy(chess);
+    if (result == CHESS_SUCCESS) {
+        ASSERT_TEST(last.games.live_bytes == first.games.live_bytes);
+        ASSERT_TEST(last.arenas.live_bytes == first.arenas.live_bytes);
+    }
+    return true;
+}
+
+static void addRemovalGames(ChessSystem chess, int tournament_id) {
+    chessAddGame(chess, tournament_id, 1, 2, DRAW, 10);
+    chessAddGame(chess, tournament_id, 2, 4, FIRST_PLAYER, 20);
+    chessAddGame(chess, tournament_id, 1, 4, FIRST_PLAYER, 30);
+    chessAddGame(chess, tournament_id, 3, 2, SECOND_PLAYER, 40);
+}
+
+bool testChessRemoveTournamentAfterPlayerRemoval() {
+    ChessSystem removed = chessCreate(), expected = chessCreate();
+    ASSERT_TEST(chessAddTournament(removed, 1, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(removed, 2, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(expected, 2, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(removed, 1, 1, 2, FIRST_PLAYER, 5) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(removed, 1, 2, 4, DRAW, 5) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(removed, 1, 1, 4, SECOND_PLAYER, 5) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(removed, 1, 3, 1, FIRST_PLAYER, 5) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(removed, 1) == CHESS_SUCCESS);
+    addRemovalGames(removed, 2);
+    addRemovalGames(expected, 2);
+
+    //Player 3's games in the ended tournament are kept as they were, so its removal must cope
+    //with a participant which is no longer in the system.
+    ASSERT_TEST(chessRemovePlayer(removed, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(expected, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemoveTournament(removed, 1) == CHESS_SUCCESS);
+
+    ASSERT_TEST(assertSameLevels(removed, expected));
+    chessDestroy(removed);
+    chessDestroy(expected);
+    return true;
+}
+
+
+bool testChessSavePlayersLevelsAfterChanges() {
+    ChessSystem repeated = chessCreate(), fresh = chessCreate();
+    FILE* earlier_levels = tmpfile();
+    ASSERT_TEST(chessAddTournament(repeated, 1, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(repeated, 2, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(fresh, 2, 5, "London") == CHESS_SUCCESS);
+    addRemovalGames(repeated, 1);
+    ASSERT_TEST(chessSavePlayersLevels(repeated, earlier_levels) == CHESS_SUCCESS);
+
+    //Each export after a change only re-sorts the changed players into the previous order.
+    addRemovalGames(repeated, 2);
+    ASSERT_TEST(chessSavePlayersLevels(repeated, earlier_levels) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(repeated, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSavePlayersLevels(repeated, earlier_levels) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemoveTournament(repeated, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(repeated, 2, 3, 5, DRAW, 50) == CHESS_SUCCESS);
+
+    addRemovalGames(fresh, 2);
+    ASSERT_TEST(chessRemovePlayer(fresh, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(fresh, 2, 3, 5, DRAW, 50) == CHESS_SUCCESS);
+
+    fclose(earlier_levels);
+    ASSERT_TEST(assertSameLevels(repeated, fresh));
+    chessDestroy(repeated);
+    chessDestroy(fresh);
+    return true;
+}
+
+static ChessResult addSparseGame(ChessSystem chess, int game) {
+    int first = 1 + game * 21474836, second = INT_MAX - game;
+    return chessAddGame(chess, 1, first, second, (Winner)(game % 3), game);
+}
+
+bool testChessSparsePlayerIds() {
+    //The ids meet the systems in opposite orders, so they are given different internal indices.
+    ChessSystem ascending = chessCreate(), descending = chessCreate();
+    ASSERT_TEST(chessAddTournament(ascending, 1, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(descending, 1, 5, "London") == CHESS_SUCCESS);
+    for (int game = 0; game < 100; ++game) {
+        ASSERT_TEST(addSparseGame(ascending, game) == CHESS_SUCCESS);
+        ASSERT_TEST(addSparseGame(descending, 99 - game) == CHESS_SUCCESS);
+    }
+
+    //A removed player keeps its id's index, so it comes back with only its new games.
+    ASSERT_TEST(chessRemovePlayer(ascending, INT_MAX) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(descending, INT_MAX) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(ascending, INT_MAX) == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessAddGame(ascending, 1, 1, INT_MAX, SECOND_PLAYER, 30) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(descending, 1, 1, INT_MAX, SECOND_PLAYER, 30) == CHESS_SUCCESS);
+
+    ChessResult result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(ascending, INT_MAX, &result) == 30 && result == CHESS_SUCCESS);
+    ASSERT_TEST(chessCalculateAveragePlayTime(ascending, 2, &result) == -1 && result == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessEndTournament(ascending, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(descending, 1) == CHESS_SUCCESS);
+
+    ASSERT_TEST(assertSameLevels(ascending, descending));
+    ASSERT_TEST(assertSameStatistics(ascending, descending));
+    chessDestroy(ascending);
+    chessDestroy(descending);
+    return true;
+}
+
+bool testChessGetCommonPlayers() {
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessAddTournament(chess, 1, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 5, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 4, 1, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 2, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 2, 5, SECOND_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 3, 4, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+
+    int player_ids[4];
+    ChessResult result;
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, player_ids, 4, &result) == 3 && result == CHESS_SUCCESS);
+    ASSERT_TEST(player_ids[0] == 2 && player_ids[1] == 3 && player_ids[2] == 4);
+    //The count doesn't depend on the room given for the ids.
+    ASSERT_TEST(chessGetCommonPlayers(chess, 2, 1, NULL, 0, &result) == 3 && result == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 2, 1, player_ids, 1, &result) == 3 && player_ids[0] == 2);
+
+    //A removed player forfeited its games, so it's no longer common, until it plays in both again.
+    ASSERT_TEST(chessRemovePlayer(chess, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, player_ids, 4, &result) == 2 && result == CHESS_SUCCESS);
+    ASSERT_TEST(player_ids[0] == 2 && player_ids[1] == 4);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 1, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, player_ids, 4, &result) == 2);
+    ASSERT_TEST(chessAddGame(chess, 2, 3, 5, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, player_ids, 4, &result) == 3 && player_ids[1] == 3);
+    //A game rejected by the tournament leaves its participants as they were.
+    ASSERT_TEST(chessAddGame(chess, 1, 6, 6, DRAW, 10) == CHESS_INVALID_ID);
+    ASSERT_TEST(chessAddGame(chess, 2, 6, 6, DRAW, 10) == CHESS_INVALID_ID);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, player_ids, 4, &result) == 3);
+
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 1, player_ids, 4, &result) == 4 && player_ids[3] == 4);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 3, player_ids, 4, &result) == 0
+                && result == CHESS_TOURNAMENT_NOT_EXIST);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 0, 1, player_ids, 4, &result) == 0 && result == CHESS_INVALID_ID);
+    ASSERT_TEST(chessGetCommonPlayers(chess, 1, 2, NULL, 4, &result) == 0 && result == CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(chessGetCommonPlayers(NULL, 1, 2, player_ids, 4, &result) == 0 && result == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessWithoutTournaments() {
+    //The player outlives its only tournament, so the scans go over no tournaments at all.
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessAddTournament(chess, 1, 5, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemoveTournament(chess, 1) == CHESS_SUCCESS);
+
+    ChessResult result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 1, &result) == -1 && result == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessRemovePlayer(chess, 1) == CHESS_SUCCESS);
+    FILE* levels = tmpfile();
+    ASSERT_TEST(chessSavePlayersLevels(chess, levels) == CHESS_SUCCESS);
+    fclose(levels);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessRejectedGamesNewPlayers() {
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessAddTournament(chess, 1, 1, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 1, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 2, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(chess, 2) == CHESS_SUCCESS);
+
+    //Enough new ids for the player table to grow several times, were they given indices.
+    ChessMemoryStats before, after;
+    ChessResult result = chessGetMemoryStats(&before);
+    for (int id = 100; id < 200; ++id) {
+        ASSERT_TEST(chessAddGame(chess, 1, id, id + 100, DRAW, -1) == CHESS_INVALID_PLAY_TIME);
+        ASSERT_TEST(chessAddGame(chess, 1, 1, id, DRAW, 10) == CHESS_EXCEEDED_GAMES);
+        ASSERT_TEST(chessAddGame(chess, 1, id, id, DRAW, 10) == CHESS_INVALID_ID);
+        ASSERT_TEST(chessAddGame(chess, 2, id, id + 100, DRAW, 10) == CHESS_TOURNAMENT_ENDED);
+    }
+    if (result == CHESS_SUCCESS) {
+        ASSERT_TEST(chessGetMemoryStats(&after) == CHESS_SUCCESS);
+        ASSERT_TEST(after.players.allocations == before.players.allocations);
+        ASSERT_TEST(after.players.live_bytes == before.players.live_bytes);
+    }
+
+    //The rejected ids are still new to the system.
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 100, &result) == -1 && result == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessAddGame(chess, 1, 100, 300, SECOND_PLAYER, 20) == CHESS_SUCCESS);
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 300, &result) == 20 && result == CHESS_SUCCESS);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testGameColumns() {
+    for (int use_arena = 0; use_arena <= 1; ++use_arena) {
+        Arena arena = use_arena ? arenaCreate(MEMORY_GAMES) : NULL;
+        GameColumns games;
+        initGameColumns(&games, arena);
+        //Enough games for the columns to grow several times.
+        long long total_time = 0;
+        for (int game = 0; game < 100; ++game) {
+            ASSERT_TEST(appendGame(&games, game + 1, game + 2, (Winner)(game % 3), game * 10) == CHESS_SUCCESS);
+            total_time += game * 10;
+        }
+        //Rejected games leave the columns as they were.
+        ASSERT_TEST(appendGame(&games, 3, 3, DRAW, 5) == CHESS_INVALID_ID);
+        ASSERT_TEST(appendGame(&games, 0, 3, DRAW, 5) == CHESS_INVALID_ID);
+        ASSERT_TEST(appendGame(&games, 3, 4, DRAW, -1) == CHESS_INVALID_PLAY_TIME);
+        ASSERT_TEST(games.count == 100 && games.capacity >= 100 && games.total_time == total_time);
+
+        for (int game = 0; game < 100; ++game) {
+            ASSERT_TEST(getPlayer1Id(&games, game) == game + 1 && getPlayer2Id(&games, game) == game + 2);
+            ASSERT_TEST(getWinner(&games, game) == (Winner)(game % 3) && getTime(&games, game) == game * 10);
+        }
+
+        //Player 50 played games 48 and 49.
+        int game_count = 0, longest_time = 0, sum = 0;
+        ASSERT_TEST(getPlayerTotalPlayTime(&games, 50, &game_count) == 970 && game_count == 2);
+        getGamesTimeStatistics(&games, &longest_time, &sum);
+        ASSERT_TEST(longest_time == 990 && sum == total_time);
+
+        GameColumns copy;
+        ASSERT_TEST(copyGameColumns(&copy, &games, NULL));
+        freeGameColumns(&games);
+        ASSERT_TEST(games.count == 0 && games.player1 == NULL && games.arena == arena);
+        ASSERT_TEST(copy.count == 100 && copy.total_time == total_time && getPlayer2Id(&copy, 99) == 101);
+        freeGameColumns(&copy);
+        arenaDestroy(arena);
+    }
+    return true;
+}
+
+bool testGameStatus() {
+    GameColumns games;
+    initGameColumns(&games, NULL);
+    for (Winner winner = FIRST_PLAYER; winner <= DRAW; ++winner) {
+        ASSERT_TEST(appendGame(&games, 1, 2, winner, 10) == CHESS_SUCCESS);
+        ASSERT_TEST(appendGame(&games, 1, 2, winner, 10) == CHESS_SUCCESS);
+    }
+
+    //Games 2k and 2k+1 are won by Winner k; player 1 forfeits the former and player 2 the latter.
+    //Only a player who had lost is promoted.
+    ASSERT_TEST(setPlayerForfeited(&games, 0, 1) == 2 && setPlayerForfeited(&games, 1, 2) == NO_WINNER);
+    ASSERT_TEST(setPlayerForfeited(&games, 2, 1) == NO_WINNER && setPlayerForfeited(&games, 3, 2) == 1);
+    ASSERT_TEST(setPlayerForfeited(&games, 4, 1) == NO_WINNER && setPlayerForfeited(&games, 5, 2) == NO_WINNER);
+    ASSERT_TEST(games.forfeited_count == 6);
+    for (int game = 0; game < 6; ++game) {
+        Winner expected = game % 2 == 0 ? SECOND_PLAYER : FIRST_PLAYER;
+        ASSERT_TEST(isPlayerForfeited(&games, game) && getWinner(&games, game) == expected);
+        ASSERT_TEST(games.status[game] == (expected | GAME_FORFEITED));
+        ASSERT_TEST(getWinnerId(&games, game) == (game % 2 == 0 ? 2 : 1));
+        ASSERT_TEST(didPlayerPlay(&games, game, getWinnerId(&games, game)));
+        ASSERT_TEST(!didPlayerPlay(&games, game, 3 - getWinnerId(&games, game)));
+    }
+
+    //Once the other player is removed too, the game is a forfeited draw, counted once.
+    ASSERT_TEST(setPlayerForfeited(&games, 0, 2) == NO_WINNER);
+    ASSERT_TEST(getWinner(&games, 0) == DRAW && isPlayerForfeited(&games, 0) && games.forfeited_count == 6);
+    ASSERT_TEST(getWinnerId(&games, 0) == NO_WINNER && !didPlayerPlay(&games, 0, 1) && !didPlayerPlay(&games, 0, 2));
+    ASSERT_TEST(getTime(&games, 0) == 10 && getPlayer1Id(&games, 0) == 1 && getPlayer2Id(&games, 0) == 2);
+    freeGameColumns(&games);
+    return true;
+}
+
+#define KERNEL_TEST_MAX_LENGTH 70
+
+bool testGameKernels() {
+    //One extra element, so the scans also start off the arrays' alignment.
+    int player1[KERNEL_TEST_MAX_LENGTH + 1], player2[KERNEL_TEST_MAX_LENGTH + 1], times[KERNEL_TEST_MAX_LENGTH + 1];
+    unsigned int seed = 11;
+    for (int game = 0; game <= KERNEL_TEST_MAX_LENGTH; ++game) {
+        seed = seed * 1103515245 + 12345;
+        player1[game] = 1 + (seed >> 8) % 4;
+        player2[game] = 1 + (seed >> 12) % 4;
+        //Some times are large enough for the sums to wrap around.
+        times[game] = game % 5 == 0 ? INT_MAX - (int)(seed >> 20) : (int)((seed >> 16) % 1000);
+    }
+
+    GameKernelsLevel best_level = getGameKernelsLevel();
+    for (int offset = 0; offset <= 1; ++offset) {
+        //Every length up to a few vectors, most of them not a multiple of the vector width.
+        for (int length = 0; length + offset <= KERNEL_TEST_MAX_LENGTH; ++length) {
+            ASSERT_TEST(setGameKernelsLevel(GAME_KERNELS_SCALAR));
+            int longest_time, total_time, game_count[4], player_time[4];
+            scanGameTimes(times + offset, length, &longest_time, &total_time);
+            for (int player = 1; player <= 4; ++player) {
+                player_time[player - 1] = scanPlayerGameTimes(player1 + offset, player2 + offset, times + offset,
+                                                              length, player, &game_count[player - 1]);
+            }
+
+            for (GameKernelsLevel level = GAME_KERNELS_SSE2; level <= GAME_KERNELS_AVX2; ++level) {
+                if (!setGameKernelsLevel(level)) {
+                    continue;
+                }
+                int level_longest_time, level_total_time, level_game_count;
+                scanGameTimes(times + offset, length, &level_longest_time, &level_total_time);
+                ASSERT_TEST(level_longest_time == longest_time && level_total_time == total_time);
+                for (int player = 1; player <= 4; ++player) {
+                    ASSERT_TEST(scanPlayerGameTimes(player1 + offset, player2 + offset, times + offset, length,
+                                                    player, &level_game_count) == player_time[player - 1]);
+                    ASSERT_TEST(level_game_count == game_count[player - 1]);
+                }
+            }
+        }
+    }
+    ASSERT_TEST(setGameKernelsLevel(best_level) && getGameKernelsLevel() == best_level);
+    return true;
+}
+
+bool testInternedLocations() {
+    LocationTable locations = createLocationTable();
+    ASSERT_TEST(locations != NULL);
+    ChessResult error;
+    Tournament first = createTournament(1, locations, "London", 5, NULL, &error);
+    Tournament second = createTournament(2, locations, "London", 5, NULL, &error);
+    Tournament third = createTournament(3, locations, "Paris", 5, NULL, &error);
+    ASSERT_TEST(first != NULL && second != NULL && third != NULL);
+
+    //Tournaments held at the same location share its handle.
+    Location london = findLocation(locations, "London");
+    ASSERT_TEST(london != NULL && getLocationHandle(first) == london && getLocationHandle(second) == london);
+    ASSERT_TEST(getLocationHandle(third) != london && getLocationCount(locations) == 2);
+    ASSERT_TEST(strcmp(getLocationName(london), "London") == 0 && getLocation(second) == getLocation(first));
+
+    //The string stays as long as a tournament holds it.
+    freeTournament(first, NULL);
+    ASSERT_TEST(findLocation(locations, "London") == london && getLocationCount(locations) == 2);
+    freeTournament(second, NULL);
+    ASSERT_TEST(findLocation(locations, "London") == NULL && getLocationCount(locations) == 1);
+    Location paris = internLocation(locations, "Paris");
+    ASSERT_TEST(paris == getLocationHandle(third));
+    freeTournament(third, NULL);
+    ASSERT_TEST(findLocation(locations, "Paris") == paris);
+    releaseLocation(paris);
+    ASSERT_TEST(getLocationCount(locations) == 0);
+    destroyLocationTable(locations);
+    return true;
+}
+
+bool testPlayerTableSpreadIds() {
+    //Ids differing only in their high bits, which once all started probing from the same slot.
+    PlayerTable players;
+    initPlayerTable(&players);
+    for (int id = 1; id <= 4000; ++id) {
+        ASSERT_TEST(addPlayerIndex(&players, id * 16384) == id);
+    }
+    for (int id = 1; id <= 4000; ++id) {
+        ASSERT_TEST(findPlayerIndex(&players, id * 16384) == id && getIndexedPlayerId(&players, id) == id * 16384);
+        ASSERT_TEST(findPlayerIndex(&players, id * 16384 + 1) == NO_PLAYER_INDEX);
+    }
+    freePlayerTable(&players);
+    return true;
+}
+
+//Checks a player's results, as kept by the system.
+static bool hasResults(PlayerTable* players, int player_index, int wins, int losses, int draws) {
+    Player player = getPlayerAt(players, player_index);
+    return player != NULL && getWins(player) == wins && getLosses(player) == losses && getDraws(player) == draws;
+}
+
+bool testTournamentContributions() {
+    PlayerTable players;
+    initPlayerTable(&players);
+    LocationTable locations = createLocationTable();
+    ChessResult error;
+    Tournament removed = createTournament(1, locations, "London", 5, NULL, &error);
+    Tournament kept = createTournament(2, locations, "London", 5, NULL, &error);
+    ASSERT_TEST(locations != NULL && removed != NULL && kept != NULL);
+    int index[5];
+    for (int id = 1; id <= 4; ++id) {
+        index[id] = addPlayerIndex(&players, id);
+        ASSERT_TEST(index[id] != NO_PLAYER_INDEX);
+    }
+
+    ASSERT_TEST(addGameToTournament(kept, index[1], index[2], DRAW, 10, &players) == CHESS_SUCCESS);
+    ASSERT_TEST(addGameToTournament(removed, index[1], index[2], FIRST_PLAYER, 10, &players) == CHESS_SUCCESS);
+    ASSERT_TEST(addGameToTournament(removed, index[2], index[3], FIRST_PLAYER, 10, &players) == CHESS_SUCCESS);
+    ASSERT_TEST(addGameToTournament(removed, index[3], index[1], FIRST_PLAYER, 10, &players) == CHESS_SUCCESS);
+    ASSERT_TEST(addGameToTournament(removed, index[2], index[4], SECOND_PLAYER, 10, &players) == CHESS_SUCCESS);
+
+    //Player 3 is removed the way chessRemovePlayer does it: player 1 is promoted from its loss.
+    int promoted[4];
+    ASSERT_TEST(forfeitPlayerGames(kept, index[3], promoted) == 0);
+    ASSERT_TEST(forfeitPlayerGames(removed, index[3], promoted) == 1 && promoted[0] == index[1]);
+    increaseWins(getPlayerAt(&players, index[1]));
+    decreaseLosses(getPlayerAt(&players, index[1]));
+    removePlayer(&players, index[3]);
+    ASSERT_TEST(hasResults(&players, index[1], 2, 0, 1) && getPlayerCount(removed) == 4);
+
+    //The table took the forfeits in, so removing the tournament leaves only the other one's results.
+    ASSERT_TEST(removeTournamentFromStatistics(removed, &players) == CHESS_SUCCESS);
+    ASSERT_TEST(hasResults(&players, index[1], 0, 0, 1) && hasResults(&players, index[2], 0, 0, 1));
+    ASSERT_TEST(hasResults(&players, index[4], 0, 0, 0) && getPlayerAt(&players, index[3]) == NULL);
+
+    freeTournament(removed, NULL);
+    freeTournament(kept, NULL);
+    destroyLocationTable(locations);
+    freePlayerTable(&players);
+    return true;
+}
+
+//Callbacks of the int-keyed maps of the tests below.
+static MapKeyElement copyIntKey(MapKeyElement key) {
+    int* copy = malloc(sizeof(*copy));
+    if (copy != NULL) {
+        *copy = *(int*)key;
+    }
+    return copy;
+}
+
+static void freeIntKey(MapKeyElement key) {
+    free(key);
+}
+
+static int compareIntKeys(MapKeyElement key1, MapKeyElement key2) {
+    return *(int*)key1 - *(int*)key2;
+}
+
+#define FINGER_TEST_MAX_KEY 300
+#define FINGER_TEST_READERS 4
+
+//Looks every key up; lookups only read the map, so several threads may do it at once.
+static void* readListMap(void* argument) {
+    Map ids = argument;
+    int ids_found = 0;
+    for (int id = 1; id <= FINGER_TEST_MAX_KEY; ++id) {
+        ids_found += mapContains(ids, &id) && *(int*)mapGet(ids, &id) == id;
+    }
+    return ids_found == mapGetSize(ids) ? argument : NULL;
+}
+
+bool testMapFinger() {
+    for (int use_arena = 0; use_arena <= 1; ++use_arena) {
+        Arena arena = use_arena ? arenaCreate(MEMORY_ARENAS) : NULL;
+        Map ids = use_arena
+            ? mapCreateInArena(arena, sizeof(int), sizeof(int), &copyIntKey, &copyIntKey, &freeIntKey,
+                               &freeIntKey, &compareIntKeys)
+            : mapCreateWithBackend(MAP_BACKEND_LIST, &copyIntKey, &copyIntKey, &freeIntKey,
+                                   &freeIntKey, &compareIntKeys);
+        ASSERT_TEST(ids != NULL);
+        bool present[FINGER_TEST_MAX_KEY + 1] = { false };
+
+        //Ascending puts go through the tail, then neighbouring lookups start at the finger.
+        for (int id = 2; id <= 200; id += 2) {
+            ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS);
+            present[id] = true;
+        }
+        int id = 101;
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS);
+        present[id] = true;
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            for (int neighbour = 99; neighbour <= 104; ++neighbour) {
+                ASSERT_TEST(mapContains(ids, &neighbour) == present[neighbour]);
+                ASSERT_TEST(present[neighbour] ? *(int*)mapGet(ids, &neighbour) == neighbour
+                                               : mapGet(ids, &neighbour) == NULL);
+            }
+        }
+
+        //100 is the finger now; removing it, then the key after it, moves the finger back.
+        id = 100;
+        ASSERT_TEST(mapRemove(ids, &id) == MAP_SUCCESS);
+        present[id] = false;
+        ASSERT_TEST(mapGet(ids, &id) == NULL);
+        id = 101;
+        ASSERT_TEST(*(int*)mapGet(ids, &id) == 101);
+        ASSERT_TEST(mapRemove(ids, &id) == MAP_SUCCESS && !mapContains(ids, &id));
+        present[id] = false;
+        id = 99;
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS && *(int*)mapGet(ids, &id) == 99);
+        present[id] = true;
+        //Replacing a key moves the finger too, and so does removing the head or the tail.
+        id = 50;
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS && *(int*)mapGet(ids, &id) == 50);
+        for (int removed = 2; removed <= 200; removed += 198) {
+            ASSERT_TEST(mapRemove(ids, &removed) == MAP_SUCCESS);
+            present[removed] = false;
+        }
+        id = FINGER_TEST_MAX_KEY;
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS && *(int*)mapGet(ids, &id) == id);
+        present[id] = true;
+
+        pthread_t readers[FINGER_TEST_READERS];
+        for (int reader = 0; reader < FINGER_TEST_READERS; ++reader) {
+            ASSERT_TEST(pthread_create(&readers[reader], NULL, &readListMap, ids) == 0);
+        }
+        for (int reader = 0; reader < FINGER_TEST_READERS; ++reader) {
+            void* reader_result;
+            ASSERT_TEST(pthread_join(readers[reader], &reader_result) == 0 && reader_result == ids);
+        }
+
+        int expected = 0;
+        MAP_FOREACH(int*, key, ids) {
+            while (!present[expected]) {
+                ++expected;
+            }
+            ASSERT_TEST(*key == expected);
+            ++expected;
+            freeIntKey(key);
+        }
+        ASSERT_TEST(expected == FINGER_TEST_MAX_KEY + 1);
+        mapDestroy(ids);
+        arenaDestroy(arena);
+    }
+    return true;
+}
+
+bool testMapRangeQueries() {
+    Map ids = mapCreate(&copyIntKey, &copyIntKey, &freeIntKey, &freeIntKey,
+                        &compareIntKeys);
+    for (int id = 10; id <= 100; id += 10) {
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS);
+    }
+
+    int bound = 30, missing = 35, low = 5, high = 100;
+    int* key = mapLowerBound(ids, &bound);
+    ASSERT_TEST(key != NULL && *key == 30);
+    freeIntKey(key);
+    key = mapGetNext(ids);
+    ASSERT_TEST(key != NULL && *key == 40);
+    freeIntKey(key);
+    key = mapUpperBound(ids, &bound);
+    ASSERT_TEST(key != NULL && *key == 40);
+    freeIntKey(key);
+    key = mapLowerBound(ids, &missing);
+    ASSERT_TEST(key != NULL && *key == 40);
+    freeIntKey(key);
+    ASSERT_TEST(mapUpperBound(ids, &high) == NULL);
+
+    //Paging through [5, 100) three keys at a time.
+    int expected = 10, page_count = 0, count = 3;
+    while (count == 3) {
+        count = 0;
+        MAP_FOREACH_RANGE(int*, id, ids, &low, &high) {
+            ASSERT_TEST(*id == expected);
+            expected += 10;
+            low = *id + 1;
+            freeIntKey(id);
+            if (++count == 3) {
+                break;
+            }
+        }
+        page_count += count > 0 ? 1 : 0;
+    }
+    ASSERT_TEST(expected == 100 && page_count == 3);
+    ASSERT_TEST(mapGetFirstInRange(ids, &high, &low) == NULL);
+
+    mapDestroy(ids);
+    return true;
+}
+
+bool testMapBTree() {
+    Map ids = mapCreateBTree(&copyIntKey, &copyIntKey, &freeIntKey, &freeIntKey,
+                             &compareIntKeys);
+    //Enough keys for a few levels of nodes, put in an order which is neither ascending nor descending.
+    for (int current = 0; current < 1000; ++current) {
+        int id = (current * 379) % 1000 + 1;
+        ASSERT_TEST(mapPut(ids, &id, &current) == MAP_SUCCESS);
+    }
+    for (int id = 2; id <= 1000; id += 2) {
+        ASSERT_TEST(mapRemove(ids, &id) == MAP_SUCCESS);
+    }
+    ASSERT_TEST(mapGetSize(ids) == 500);
+
+    int id = 1, missing = 2, value = 7;
+    ASSERT_TEST(mapGet(ids, &missing) == NULL);
+    ASSERT_TEST(mapRemove(ids, &missing) == MAP_ITEM_DOES_NOT_EXIST);
+    ASSERT_TEST(mapPut(ids, &id, &value) == MAP_SUCCESS);
+    ASSERT_TEST(*(int*)mapGet(ids, &id) == 7 && mapGetSize(ids) == 500);
+
+    int expected = 1;
+    MAP_FOREACH(int*, key, ids) {
+        ASSERT_TEST(*key == expected);
+        expected += 2;
+        freeIntKey(key);
+    }
+    ASSERT_TEST(expected == 1001);
+
+    int* key = mapLowerBound(ids, &missing);
+    ASSERT_TEST(key != NULL && *key == 3);
+    freeIntKey(key);
+
+    Map copy = mapCopy(ids);
+    mapDestroy(ids);
+    ASSERT_TEST(copy != NULL && mapGetSize(copy) == 500 && mapContains(copy, &id));
+    ASSERT_TEST(mapClear(copy) == MAP_SUCCESS && mapGetSize(copy) == 0 && mapGetFirst(copy) == NULL);
+    mapDestroy(copy);
+    return true;
+}
+
+#define SKIP_LIST_TEST_SIZE 1000
+#define SKIP_LIST_TEST_ROUNDS 20
+
+//Looks the even ids up until the writer is done; the writer never replaces or removes them. The
+//odd ones, which the writer removes and puts back, are only copied.
+static void* readSkipListMap(void* argument) {
+    Map ids = argument;
+    int ids_found = 0;
+    bool copies_match = true;
+    for (int round = 0; round < SKIP_LIST_TEST_ROUNDS; ++round) {
+        for (int id = 2; id <= SKIP_LIST_TEST_SIZE; id += 2) {
+            int* data = mapGet(ids, &id);
+            ids_found += data != NULL && *data == id;
+            int odd_id = id - 1;
+            int* copy = mapGetCopy(ids, &odd_id);
+            copies_match = copies_match && (copy == NULL || *copy == odd_id);
+            freeIntKey(copy);
+        }
+    }
+    return copies_match && ids_found == SKIP_LIST_TEST_ROUNDS * SKIP_LIST_TEST_SIZE / 2 ? argument : NULL;
+}
+
+bool testMapSkipList() {
+    Map ids = mapCreateSkipList(&copyIntKey, &copyIntKey, &freeIntKey, &freeIntKey,
+                                &compareIntKeys);
+    ASSERT_TEST(ids != NULL);
+    for (int current = 0; current < SKIP_LIST_TEST_SIZE; ++current) {
+        int id = (current * 379) % SKIP_LIST_TEST_SIZE + 1;
+        ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS);
+    }
+    ASSERT_TEST(mapGetSize(ids) == SKIP_LIST_TEST_SIZE);
+
+    //The odd ids come and go while another thread reads the even ones.
+    pthread_t reader;
+    ASSERT_TEST(pthread_create(&reader, NULL, &readSkipListMap, ids) == 0);
+    for (int round = 0; round < SKIP_LIST_TEST_ROUNDS; ++round) {
+        for (int id = 1; id <= SKIP_LIST_TEST_SIZE; id += 2) {
+            ASSERT_TEST(mapRemove(ids, &id) == MAP_SUCCESS);
+        }
+        for (int id = 1; id <= SKIP_LIST_TEST_SIZE; id += 2) {
+            ASSERT_TEST(mapPut(ids, &id, &id) == MAP_SUCCESS);
+        }
+    }
+    void* reader_result;
+    ASSERT_TEST(pthread_join(reader, &reader_result) == 0 && reader_result == ids);
+    ASSERT_TEST(mapGetSize(ids) == SKIP_LIST_TEST_SIZE);
+
+    int id = 3, value = 7, missing = SKIP_LIST_TEST_SIZE + 1;
+    ASSERT_TEST(mapPut(ids, &id, &value) == MAP_SUCCESS && *(int*)mapGet(ids, &id) == 7);
+    ASSERT_TEST(mapRemove(ids, &missing) == MAP_ITEM_DOES_NOT_EXIST && !mapContains(ids, &missing));
+    int* copy_of_value = mapGetCopy(ids, &id);
+    ASSERT_TEST(copy_of_value != NULL && copy_of_value != mapGet(ids, &id) && *copy_of_value == 7);
+    freeIntKey(copy_of_value);
+    ASSERT_TEST(mapGetCopy(ids, &missing) == NULL);
+
+    int expected = 1;
+    MAP_FOREACH(int*, key, ids) {
+        ASSERT_TEST(*key == expected);
+        ++expected;
+        freeIntKey(key);
+    }
+    ASSERT_TEST(expected == SKIP_LIST_TEST_SIZE + 1);
+
+    Map copy = mapCopy(ids);
+    mapDestroy(ids);
+    ASSERT_TEST(copy != NULL && mapGetSize(copy) == SKIP_LIST_TEST_SIZE && *(int*)mapGet(copy, &id) == 7);
+    ASSERT_TEST(mapClear(copy) == MAP_SUCCESS && mapGetSize(copy) == 0 && mapGetFirst(copy) == NULL);
+    mapDestroy(copy);
+    return true;
+}
+
+#define SKIP_LIST_TEST_WRITERS 4
+#define SKIP_LIST_TEST_SHARED 50
+
+typedef struct {
+    Map ids;
+    int writer;
+} SkipListWriter;
+
+//Puts its own ids, and puts and removes the shared ones after SKIP_LIST_TEST_SIZE along with the
+//other writers.
+static void* writeSkipListMap(void* argument) {
+    SkipListWriter* writer = argument;
+    bool succeeded = true;
+    for (int id = writer->writer + 1; id <= SKIP_LIST_TEST_SIZE; id += SKIP_LIST_TEST_WRITERS) {
+        succeeded = succeeded && mapPut(writer->ids, &id, &id) == MAP_SUCCESS;
+        int shared = SKIP_LIST_TEST_SIZE + 1 + id % SKIP_LIST_TEST_SHARED;
+        succeeded = succeeded && mapPut(writer->ids, &shared, &id) == MAP_SUCCESS;
+        MapResult removed = mapRemove(writer->ids, &shared);
+        succeeded = succeeded && (removed == MAP_SUCCESS || removed == MAP_ITEM_DOES_NOT_EXIST);
+    }
+    return succeeded ? argument : NULL;
+}
+
+bool testMapSkipListWriters() {
+    Map ids = mapCreateSkipList(&copyIntKey, &copyIntKey, &freeIntKey, &freeIntKey,
+                                &compareIntKeys);
+    ASSERT_TEST(ids != NULL);
+
+    pthread_t threads[SKIP_LIST_TEST_WRITERS];
+    SkipListWriter writers[SKIP_LIST_TEST_WRITERS];
+    for (int writer = 0; writer < SKIP_LIST_TEST_WRITERS; ++writer) {
+        writers[writer].ids = ids;
+        writers[writer].writer = writer;
+        ASSERT_TEST(pthread_create(&threads[writer], NULL, &writeSkipListMap, &writers[writer]) == 0);
+    }
+    for (int writer = 0; writer < SKIP_LIST_TEST_WRITERS; ++writer) {
+        void* writer_result;
+        ASSERT_TEST(pthread_join(threads[writer], &writer_result) == 0 && writer_result == &writers[writer]);
+    }
+
+    //Whichever shared ids the last removals missed are still there; every id of a writer is.
+    for (int shared = SKIP_LIST_TEST_SIZE + 1; shared <= SKIP_LIST_TEST_SIZE + SKIP_LIST_TEST_SHARED; ++shared) {
+        mapRemove(ids, &shared);
+    }
+    ASSERT_TEST(mapGetSize(ids) == SKIP_LIST_TEST_SIZE);
+    int expected = 1;
+    MAP_FOREACH(int*, key, ids) {
+        ASSERT_TEST(*key == expected && *(int*)mapGet(ids, key) == expected);
+        ++expected;
+        freeIntKey(key);
+    }
+    ASSERT_TEST(expected == SKIP_LIST_TEST_SIZE + 1);
+    mapDestroy(ids);
+    return true;
+}
+
+bool testMapBackends() {
+    ASSERT_TEST(mapGetBackendByName("btree") == MAP_BACKEND_BTREE);
+    ASSERT_TEST(mapGetBackendByName("hash") == MAP_BACKEND_DEFAULT && mapGetBackendByName(NULL) == MAP_BACKEND_DEFAULT);
+    ASSERT_TEST(mapCreateWithBackend(MAP_BACKEND_COUNT, &copyIntKey, &copyIntKey, &freeIntKey,
+                                     &freeIntKey, &compareIntKeys) == NULL);
+
+    //Every backend holds the same keys in the same order.
+    for (MapBackend backend = MAP_BACKEND_LIST; backend < MAP_BACKEND_COUNT; ++backend) {
+        ASSERT_TEST(mapGetBackendByName(mapGetBackendName(backend)) == backend);
+        Map ids = mapCreateWithBackend(backend, &copyIntKey, &copyIntKey, &freeIntKey,
+                                       &freeIntKey, &compareIntKeys);
+        ASSERT_TEST(ids != NULL && mapGetBackend(ids) == backend);
+        for (int current = 0; current < 100; ++current) {
+            int id = (current * 37) % 100;
+            ASSERT_TEST(mapPut(ids, &id, &current) == MAP_SUCCESS);
+        }
+        int id = 50;
+        ASSERT_TEST(mapRemove(ids, &id) == MAP_SUCCESS && mapGetSize(ids) == 99);
+
+        Map copy = mapCopy(ids);
+        mapDestroy(ids);
+        ASSERT_TEST(copy != NULL && mapGetBackend(copy) == backend);
+        int expected = 0;
+        MAP_FOREACH(int*, key, copy) {
+            ASSERT_TEST(*key == expected);
+            expected += expected == 49 ? 2 : 1;
+            freeIntKey(key);
+        }
+        ASSERT_TEST(expected == 100);
+        mapDestroy(copy);
+    }
+    return true;
+}
+
+//A typed map whose values count how many of them are stored, to check they're all released.
+typedef struct CountedValue_t {
+    int value;
+    int* live_values;
+} CountedValue;
+#define RELEASE_COUNTED_VALUE(counted) (--*(counted)->live_values)
+
+DECLARE_TYPED_MAP(CountedMap, countedMap, int, CountedValue)
+DEFINE_TYPED_MAP(CountedMap, countedMap, int, CountedValue, TYPED_MAP_COMPARE_SCALARS, RELEASE_COUNTED_VALUE,
+                 MEMORY_MAP_NODES)
+
+bool testTypedMap() {
+    int live_values = 0;
+    for (int use_arena = 0; use_arena <= 1; ++use_arena) {
+        Arena arena = use_arena ? arenaCreate(MEMORY_ARENAS) : NULL;
+        CountedMap values = countedMapCreate(arena);
+        ASSERT_TEST(values != NULL && countedMapFirst(values) == NULL);
+        for (int current = 0; current < 1000; ++current) {
+            int id = (current * 379) % 1000 + 1;
+            CountedValue value = { id, &live_values };
+            ++live_values;
+            CountedValue* stored = countedMapPut(values, id, &value);
+            ASSERT_TEST(stored != NULL && stored->value == id && countedMapKeyOf(stored) == id);
+        }
+        for (int id = 2; id <= 1000; id += 2) {
+            ASSERT_TEST(countedMapRemove(values, id));
+        }
+        ASSERT_TEST(!countedMapRemove(values, 2) && countedMapGet(values, 2) == NULL);
+        ASSERT_TEST(countedMapGetSize(values) == 500 && live_values == 500);
+
+        //Putting an existing key releases the value it replaces.
+        CountedValue replacement = { 7, &live_values };
+        ++live_values;
+        ASSERT_TEST(countedMapPut(values, 1, &replacement) == countedMapGet(values, 1));
+        ASSERT_TEST(countedMapGet(values, 1)->value == 7 && live_values == 500);
+
+        int expected = 1;
+        for (CountedValue* value = countedMapFirst(values); value != NULL; value = countedMapNext(values, value)) {
+            ASSERT_TEST(countedMapKeyOf(value) == expected);
+            expected += 2;
+        }
+        ASSERT_TEST(expected == 1001);
+
+        countedMapDestroy(values);
+        ASSERT_TEST(live_values == 0);
+        arenaDestroy(arena);
+    }
+    return true;
+}
+
+//Objects linked into an intrusive map through a field of their own.
+typedef struct LinkedId_t {
+    AvlLink link;
+    int id;
+} LinkedId;
+
+DECLARE_INTRUSIVE_MAP(LinkedIdMap, linkedIdMap, int, LinkedId)
+DEFINE_INTRUSIVE_MAP(LinkedIdMap, linkedIdMap, int, LinkedId, link, id, TYPED_MAP_COMPARE_SCALARS)
+
+bool testIntrusiveMap() {
+    LinkedId objects[100], duplicate = { .id = 37 };
+    LinkedIdMap ids;
+    linkedIdMapInit(&ids);
+    for (int current = 0; current < 100; ++current) {
+        objects[current].id = (current * 37) % 100;
+        ASSERT_TEST(linkedIdMapInsert(&ids, &objects[current]) == &objects[current]);
+    }
+    //The map allocates nothing, so the objects it returns are the ones inserted.
+    ASSERT_TEST(linkedIdMapInsert(&ids, &duplicate) == &objects[1] && linkedIdMapGetSize(&ids) == 100);
+    ASSERT_TEST(linkedIdMapGet(&ids, 37) == &objects[1] && linkedIdMapGet(&ids, 100) == NULL);
+
+    for (int current = 0; current < 100; current += 2) {
+        linkedIdMapRemove(&ids, &objects[current]);
+    }
+    ASSERT_TEST(linkedIdMapGetSize(&ids) == 50 && linkedIdMapGet(&ids, 0) == NULL);
+
+    int expected = 1;
+    for (LinkedId* object = linkedIdMapFirst(&ids); object != NULL; object = linkedIdMapNext(&ids, object)) {
+        ASSERT_TEST(object->id == expected && object->id % 2 == 1);
+        expected += 2;
+    }
+    ASSERT_TEST(expected == 101);
+
+    //A post-order walk visits every object once, children first.
+    int visited = 0;
+    for (LinkedId* object = linkedIdMapFirstPostorder(&ids); object != NULL;
+         object = linkedIdMapNextPostorder(&ids, object)) {
+        ASSERT_TEST(object->link.left == NULL || ((LinkedId*)object->link.left)->id < 0);
+        ASSERT_TEST(object->link.right == NULL || ((LinkedId*)object->link.right)->id < 0);
+        object->id = -1;
+        ++visited;
+    }
+    ASSERT_TEST(visited == 50);
+    return true;
+}
+
+bool testRoaringBitmap() {
+    //Three containers: a sparse one, one turned into a bitset, and one past the 16 bits of the others.
+    static bool in_first[3 << 16], in_second[3 << 16];
+    for (int use_arena = 0; use_arena <= 1; ++use_arena) {
+        Arena arena = use_arena ? arenaCreate(MEMORY_ARENAS) : NULL;
+        RoaringBitmap first, second;
+        bitmapInit(&first, arena);
+        bitmapInit(&second, NULL);
+        memset(in_first, 0, sizeof(in_first));
+        memset(in_second, 0, sizeof(in_second));
+        int first_count = 0;
+        for (int value = 0; value < (3 << 16); value += 7) {
+            bool dense = value >> 16 == 1;
+            if (dense || value % 5 == 0) {
+                ASSERT_TEST(bitmapAdd(&first, value));
+                in_first[value] = true;
+                ++first_count;
+            }
+            if (value % 3 == 0) {
+                ASSERT_TEST(bitmapAdd(&second, value));
+                in_second[value] = true;
+            }
+        }
+        ASSERT_TEST(bitmapAdd(&first, 35) && bitmapGetCardinality(&first) == first_count);
+
+        //Removal empties a bitset without turning it back into an array.
+        for (int value = 1 << 16; value < (2 << 16); value += 14) {
+            bitmapRemove(&first, value);
+            first_count -= in_first[value];
+            in_first[value] = false;
+        }
+        bitmapRemove(&first, 1);
+        ASSERT_TEST(bitmapGetCardinality(&first) == first_count);
+
+        int common_count = 0;
+        for (int value = 0; value < (3 << 16); ++value) {
+            ASSERT_TEST(bitmapContains(&first, value) == in_first[value]);
+            common_count += in_first[value] && in_second[value];
+        }
+        int* common = malloc(sizeof(*common) * (first_count + 1));
+        ASSERT_TEST(common != NULL);
+        ASSERT_TEST(bitmapIntersectionCardinality(&first, &second) == common_count);
+        ASSERT_TEST(bitmapIntersect(&second, &first, common) == common_count);
+        for (int current = 0, value = 0; value < (3 << 16); ++value) {
+            if (in_first[value] && in_second[value]) {
+                ASSERT_TEST(common[current++] == value);
+            }
+        }
+        free(common);
+
+        bitmapFree(&first);
+        bitmapFree(&second);
+        ASSERT_TEST(bitmapGetCardinality(&first) == 0 && !bitmapContains(&first, 35));
+        arenaDestroy(arena);
+    }
+    return true;
+}
+
 bool (*tests[]) (void) = {
         testChessAddTournament_segel,
         testChessRemoveTournament_segel,
@@ -470,7 +1663,35 @@ bool (*tests[]) (void) = {
         testChessRemovePlayer_maaroof,
         testChessRemovePlayer_2_maaroof,
         testAvgGameTime_maaroof,
-        testSavePlayerLevelsAndTournamentStatistics_maaroof
+        testSavePlayerLevelsAndTournamentStatistics_maaroof,
+        testChessSetWorkerCount,
+        testChessSavePlayersLevelsOrder,
+        testChessLocationQueries,
+        testChessGetMemoryStats,
+        testChessDumpMetrics,
+        testChessCreateWithArena,
+        testChessArenaTournamentChurn,
+        testChessRemoveTournamentAfterPlayerRemoval,
+        testChessSavePlayersLevelsAfterChanges,
+        testChessSparsePlayerIds,
+        testChessGetCommonPlayers,
+        testChessWithoutTournaments,
+        testChessRejectedGamesNewPlayers,
+        testGameColumns,
+        testGameStatus,
+        testGameKernels,
+        testInternedLocations,
+        testPlayerTableSpreadIds,
+        testTournamentContributions,
+        testMapFinger,
+        testMapRangeQueries,
+        testMapBTree,
+        testMapSkipList,
+        testMapSkipListWriters,
+        testMapBackends,
+        testTypedMap,
+        testIntrusiveMap,
+        testRoaringBitmap
 };
 
 /*The names of the test functions should be added here*/
@@ -486,10 +1707,38 @@ const char* testNames[] = {
         "testChessRemovePlayer_maaroof",
         "testChessRemovePlayer_2_maaroof",
         "testAvgGameTime_maaroof",
-        "testSavePlayerLevelsAndTournamentStatistics_maaroof"
+        "testSavePlayerLevelsAndTournamentStatistics_maaroof",
+        "testChessSetWorkerCount",
+        "testChessSavePlayersLevelsOrder",
+        "testChessLocationQueries",
+        "testChessGetMemoryStats",
+        "testChessDumpMetrics",
+        "testChessCreateWithArena",
+        "testChessArenaTournamentChurn",
+        "testChessRemoveTournamentAfterPlayerRemoval",
+        "testChessSavePlayersLevelsAfterChanges",
+        "testChessSparsePlayerIds",
+        "testChessGetCommonPlayers",
+        "testChessWithoutTournaments",
+        "testChessRejectedGamesNewPlayers",
+        "testGameColumns",
+        "testGameStatus",
+        "testGameKernels",
+        "testInternedLocations",
+        "testPlayerTableSpreadIds",
+        "testTournamentContributions",
+        "testMapFinger",
+        "testMapRangeQueries",
+        "testMapBTree",
+        "testMapSkipList",
+        "testMapSkipListWriters",
+        "testMapBackends",
+        "testTypedMap",
+        "testIntrusiveMap",
+        "testRoaringBitmap"
 };
 
-#define NUMBER_TESTS 12
+#define NUMBER_TESTS 40
 
 int main(int argc, char *argv[]) {
     if (1) {
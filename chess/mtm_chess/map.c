@@ -1,8 +1,14 @@
 #include "map.h"
+#include "mapBTree.h"
+#include "mapSkipList.h"
+#include "memoryStats.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #define INVALID -1
+#define BACKEND_ENVIRONMENT_VARIABLE "MAP_BACKEND"
+#define BACKEND_UNRESOLVED -1
 
 typedef struct LinkedListNode
 {
@@ -21,7 +27,15 @@ typedef enum SearchResults {
 struct Map_t
 {
     MapNode iterator;
+    //Set by mapGetFirstInRange: mapGetNext stops at this node. NULL iterates to the end.
+    MapNode iterator_end;
     MapNode elements;
+    //The last node, so appending a key larger than all others doesn't walk the list.
+    MapNode tail;
+    //The node before the most recently put or removed key. Searches for keys after it start there,
+    //so putting the next key in order, or looking up the key just put, takes O(1). Only mapPut and
+    //mapRemove move it; lookups read it, so they leave the map untouched.
+    MapNode finger;
 
     int length;
 
@@ -30,16 +44,54 @@ struct Map_t
     compareMapKeyElements compareElements;
     freeMapDataElements freeDataElement;
     freeMapKeyElements freeKeyElement;
+
+    //Set by mapCreateInArena: the map and its nodes come from the arena, and every node stores its
+    //key (and its data, if data_size is not 0) right after itself.
+    Arena arena;
+    size_t key_size;
+    size_t data_size;
+
+    //Every backend but MAP_BACKEND_LIST has an engine, which keeps the elements, the size and the
+    //iterator instead of the list.
+    MapBackend backend;
+    const MapEngine* engine;
+    void* engine_elements;
 };
 
+//The engine of each backend, in the order of MapBackend. The list is map.c's own.
+static const MapEngine* const ENGINES[] = {NULL, NULL, &BTREE_ENGINE, &SKIP_LIST_ENGINE};
+static const char* const BACKEND_NAMES[] = {"default", "list", "btree", "skiplist"};
+//MAP_BACKEND_DEFAULT resolved from the environment, on first use.
+static int default_backend = BACKEND_UNRESOLVED;
+
 //Declaring static auxiliary functions:
+static MapBackend resolveBackend(MapBackend backend);
 static MapNode findPreviousElementPosition(Map map, MapKeyElement key, SearchResults* results);
-static MapNode copyList(Map map, MapNode src);
+//Returns the first node whose key is not smaller than the given key (larger, if inclusive is false),
+//or NULL if there's none.
+static MapNode findBound(Map map, MapKeyElement key, bool inclusive);
+//Sets the iterator to the given node and range end, and returns the first key like mapGetFirst.
+static MapKeyElement startIteration(Map map, MapNode first, MapNode end);
+//Also sets last_node to the copy's last node.
+static MapNode copyList(Map map, MapNode src, MapNode* last_node);
 static void freeList(Map map, MapNode list);
 //addOrUpdateNode is designed to work with findPreviousElementPosition.
 //The position_node parameter is the return value of findPreviousElementPosition.
 //This function also updates the length of the map if necessary.
 static MapResult addOrUpdateNode(Map map, MapDataElement data_copy, MapKeyElement key_copy, MapNode position_node, SearchResults results);
+//Links a new node at the position found by findPreviousElementPosition, and updates the length.
+static void linkNode(Map map, MapNode new_node, MapNode position_node, SearchResults results);
+
+//Node storage. Nodes of arena maps have room for the inline key and data after them.
+static size_t alignToArena(size_t size);
+static size_t nodeSize(Map map);
+static MapNode allocateNode(Map map);
+static void releaseNode(Map map, MapNode node);
+//The equivalent of mapPut and of copying a node for arena maps.
+static MapResult putInArena(Map map, MapKeyElement keyElement, MapDataElement dataElement);
+static MapNode copyArenaNode(Map map, MapNode src);
+//Frees the elements of a node (not the node itself); inline elements need no freeing.
+static void freeNodeElements(Map map, MapNode node);
 
 Map mapCreate(copyMapDataElements copyDataElement,
               copyMapKeyElements copyKeyElement,
@@ -47,13 +99,77 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements)
 {
-    if (copyDataElement == NULL || copyKeyElement == NULL || freeDataElement == NULL
-        || freeKeyElement == NULL || compareKeyElements == NULL)
+    return mapCreateWithBackend(MAP_BACKEND_DEFAULT, copyDataElement, copyKeyElement, freeDataElement,
+                                freeKeyElement, compareKeyElements);
+}
+
+Map mapCreateWithBackend(MapBackend backend,
+                         copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements)
+{
+    if (backend < MAP_BACKEND_DEFAULT || backend >= MAP_BACKEND_COUNT || copyDataElement == NULL
+        || copyKeyElement == NULL || freeDataElement == NULL || freeKeyElement == NULL
+        || compareKeyElements == NULL)
+    {
+        return NULL;
+    }
+
+    Map map = trackedMalloc(MEMORY_MAPS, sizeof(*map));
+    if (map == NULL)
+    {
+        return NULL;
+    }
+
+    map->copyDataElement = copyDataElement;
+    map->copyKeyElement = copyKeyElement;
+    map->freeDataElement = freeDataElement;
+    map->freeKeyElement = freeKeyElement;
+    map->compareElements = compareKeyElements;
+
+    map->elements = NULL;
+    map->iterator = NULL;
+    map->iterator_end = NULL;
+    map->tail = NULL;
+    map->finger = NULL;
+    map->length = 0;
+
+    map->arena = NULL;
+    map->key_size = 0;
+    map->data_size = 0;
+    map->backend = resolveBackend(backend);
+    map->engine = ENGINES[map->backend];
+    map->engine_elements = NULL;
+    if (map->engine != NULL)
+    {
+        map->engine_elements = map->engine->create(copyDataElement, copyKeyElement, freeDataElement,
+                                                   freeKeyElement, compareKeyElements);
+        if (map->engine_elements == NULL)
+        {
+            trackedFree(MEMORY_MAPS, map, sizeof(*map));
+            return NULL;
+        }
+    }
+
+    return map;
+}
+
+Map mapCreateInArena(Arena arena, size_t key_size, size_t data_size,
+                     copyMapDataElements copyDataElement,
+                     copyMapKeyElements copyKeyElement,
+                     freeMapDataElements freeDataElement,
+                     freeMapKeyElements freeKeyElement,
+                     compareMapKeyElements compareKeyElements)
+{
+    if (arena == NULL || key_size == 0 || copyDataElement == NULL || copyKeyElement == NULL
+        || freeDataElement == NULL || freeKeyElement == NULL || compareKeyElements == NULL)
     {
         return NULL;
     }
 
-    Map map = malloc(sizeof(*map));
+    Map map = arenaAllocate(arena, sizeof(*map));
     if (map == NULL)
     {
         return NULL;
@@ -67,11 +183,70 @@ Map mapCreate(copyMapDataElements copyDataElement,
 
     map->elements = NULL;
     map->iterator = NULL;
+    map->iterator_end = NULL;
+    map->tail = NULL;
+    map->finger = NULL;
     map->length = 0;
 
+    map->arena = arena;
+    map->key_size = key_size;
+    map->data_size = data_size;
+    map->backend = MAP_BACKEND_LIST;
+    map->engine = NULL;
+    map->engine_elements = NULL;
+
     return map;
 }
 
+Map mapCreateBTree(copyMapDataElements copyDataElement,
+                   copyMapKeyElements copyKeyElement,
+                   freeMapDataElements freeDataElement,
+                   freeMapKeyElements freeKeyElement,
+                   compareMapKeyElements compareKeyElements)
+{
+    return mapCreateWithBackend(MAP_BACKEND_BTREE, copyDataElement, copyKeyElement, freeDataElement,
+                                freeKeyElement, compareKeyElements);
+}
+
+Map mapCreateSkipList(copyMapDataElements copyDataElement,
+                      copyMapKeyElements copyKeyElement,
+                      freeMapDataElements freeDataElement,
+                      freeMapKeyElements freeKeyElement,
+                      compareMapKeyElements compareKeyElements)
+{
+    return mapCreateWithBackend(MAP_BACKEND_SKIP_LIST, copyDataElement, copyKeyElement, freeDataElement,
+                                freeKeyElement, compareKeyElements);
+}
+
+MapBackend mapGetBackend(Map map)
+{
+    return map == NULL ? MAP_BACKEND_DEFAULT : map->backend;
+}
+
+const char* mapGetBackendName(MapBackend backend)
+{
+    if (backend < MAP_BACKEND_DEFAULT || backend >= MAP_BACKEND_COUNT)
+    {
+        return NULL;
+    }
+    return BACKEND_NAMES[backend];
+}
+
+MapBackend mapGetBackendByName(const char* name)
+{
+    if (name != NULL)
+    {
+        for (int backend = MAP_BACKEND_LIST; backend < MAP_BACKEND_COUNT; ++backend)
+        {
+            if (strcmp(name, BACKEND_NAMES[backend]) == 0)
+            {
+                return backend;
+            }
+        }
+    }
+    return MAP_BACKEND_DEFAULT;
+}
+
 void mapDestroy(Map map)
 {
     if (map == NULL)
@@ -79,9 +254,26 @@ void mapDestroy(Map map)
         return;
     }
 
-    freeList(map, map->elements);
+    if (map->arena == NULL)
+    {
+        freeList(map, map->elements);
+        if (map->engine != NULL)
+        {
+            map->engine->destroy(map->engine_elements);
+        }
+        trackedFree(MEMORY_MAPS, map, sizeof(*map));
+        return;
+    }
 
-    free(map);
+    //The nodes go away with the arena; only data held outside of it has to be freed.
+    if (map->data_size == 0)
+    {
+        for (MapNode node = map->elements; node != NULL; node = node->next)
+        {
+            map->freeDataElement(node->value);
+        }
+    }
+    arenaRelease(map->arena, map, sizeof(*map));
 }
 
 Map mapCopy(Map map)
@@ -91,12 +283,16 @@ Map mapCopy(Map map)
         return NULL;
     }
 
-    Map new_map = malloc(sizeof(*new_map));
+    Map new_map = map->arena == NULL ? trackedMalloc(MEMORY_MAPS, sizeof(*new_map))
+                                     : arenaAllocate(map->arena, sizeof(*new_map));
     if (new_map == NULL)
     {
         return NULL;
     }
 
+    new_map->arena = map->arena;
+    new_map->key_size = map->key_size;
+    new_map->data_size = map->data_size;
     new_map->length = map->length;
     new_map->copyDataElement = map->copyDataElement;
     new_map->copyKeyElement = map->copyKeyElement;
@@ -104,8 +300,18 @@ Map mapCopy(Map map)
     new_map->freeKeyElement = map->freeKeyElement;
     new_map->compareElements = map->compareElements;
 
-    new_map->elements = copyList(map, map->elements);
+    new_map->elements = copyList(map, map->elements, &new_map->tail);
     new_map->iterator = new_map->elements;
+    new_map->iterator_end = NULL;
+    new_map->finger = NULL;
+    new_map->backend = map->backend;
+    new_map->engine = map->engine;
+    new_map->engine_elements = NULL;
+    if (map->engine != NULL && (new_map->engine_elements = map->engine->copy(map->engine_elements)) == NULL)
+    {
+        trackedFree(MEMORY_MAPS, new_map, sizeof(*new_map));
+        return NULL;
+    }
 
     return new_map;
 }
@@ -116,6 +322,10 @@ int mapGetSize(Map map)
     {
         return INVALID;
     }
+    if (map->engine != NULL)
+    {
+        return map->engine->getSize(map->engine_elements);
+    }
     return map->length;
 }
 
@@ -126,6 +336,11 @@ bool mapContains(Map map, MapKeyElement element)
         return false;
     }
 
+    if (map->engine != NULL)
+    {
+        return map->engine->get(map->engine_elements, element) != NULL;
+    }
+
     SearchResults results;
     findPreviousElementPosition(map, element, &results);
     return (results == FOUND || results == FIRST_ELEMENT);
@@ -137,6 +352,10 @@ MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement)
     {
         return MAP_NULL_ARGUMENT;
     }
+    if (map->arena != NULL)
+    {
+        return putInArena(map, keyElement, dataElement);
+    }
     MapDataElement data_copy = map->copyDataElement(dataElement);
     if (data_copy == NULL)
     {
@@ -145,19 +364,27 @@ MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement)
     MapKeyElement key_copy = map->copyKeyElement(keyElement);
     if (key_copy == NULL)
     {
-        free(data_copy);
+        map->freeDataElement(data_copy);
         return MAP_OUT_OF_MEMORY;
     }
 
-    SearchResults results;
-    MapNode node = findPreviousElementPosition(map, keyElement, &results);
-
-    MapResult error = addOrUpdateNode(map, data_copy, key_copy, node, results);
+    MapResult error;
+    if (map->engine != NULL)
+    {
+        bool added = false;
+        error = map->engine->put(map->engine_elements, key_copy, data_copy, &added);
+    }
+    else
+    {
+        SearchResults results;
+        MapNode node = findPreviousElementPosition(map, keyElement, &results);
+        error = addOrUpdateNode(map, data_copy, key_copy, node, results);
+    }
 
     if (error == MAP_OUT_OF_MEMORY)
     {
-        free(data_copy);
-        free(key_copy);
+        map->freeDataElement(data_copy);
+        map->freeKeyElement(key_copy);
     }
 
     return error;
@@ -172,6 +399,11 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement)
         return NULL;
     }
 
+    if (map->engine != NULL)
+    {
+        return map->engine->get(map->engine_elements, keyElement);
+    }
+
     SearchResults results;
     MapNode position = findPreviousElementPosition(map, keyElement, &results);
 
@@ -190,6 +422,22 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement)
     return position->next->value;
 }
 
+MapDataElement mapGetCopy(Map map, MapKeyElement keyElement)
+{
+    if (map == NULL || keyElement == NULL)
+    {
+        return NULL;
+    }
+
+    if (map->engine != NULL)
+    {
+        return map->engine->getCopy(map->engine_elements, keyElement);
+    }
+
+    MapDataElement data = mapGet(map, keyElement);
+    return data == NULL ? NULL : map->copyDataElement(data);
+}
+
 MapResult mapRemove(Map map, MapKeyElement keyElement)
 {
     if (map == NULL || keyElement == NULL)
@@ -197,6 +445,11 @@ MapResult mapRemove(Map map, MapKeyElement keyElement)
         return MAP_NULL_ARGUMENT;
     }
 
+    if (map->engine != NULL)
+    {
+        return map->engine->remove(map->engine_elements, keyElement);
+    }
+
     SearchResults results;
     MapNode previous = findPreviousElementPosition(map, keyElement, &results);
     if (results == NOT_FOUND || results == NEEDS_TO_BE_FIRST)
@@ -205,19 +458,30 @@ MapResult mapRemove(Map map, MapKeyElement keyElement)
     }
     if (results == FIRST_ELEMENT)
     {
-        map->freeDataElement(map->elements->value);
-        map->freeKeyElement(map->elements->key);
+        freeNodeElements(map, map->elements);
         MapNode new_head = map->elements->next;
-        free(map->elements);
+        if (map->finger == map->elements)
+        {
+            map->finger = NULL;
+        }
+        if (map->tail == map->elements)
+        {
+            map->tail = NULL;
+        }
+        releaseNode(map, map->elements);
         map->elements = new_head;
     }
     else //results == FOUND
     {
         assert(previous != NULL);
-        map->freeKeyElement(previous->next->key);
-        map->freeDataElement(previous->next->value);
+        freeNodeElements(map, previous->next);
         MapNode new_next = previous->next->next;
-        free(previous->next);
+        if (map->tail == previous->next)
+        {
+            map->tail = previous;
+        }
+        map->finger = previous; //It may have been the removed node.
+        releaseNode(map, previous->next);
         previous->next = new_next;
     }
     --(map->length);
@@ -231,13 +495,80 @@ MapKeyElement mapGetFirst(Map map)
         return NULL;
     }
 
-    map->iterator = map->elements;
-    return mapGetNext(map);
+    if (map->engine != NULL)
+    {
+        map->engine->iterate(map->engine_elements, NULL, true, NULL);
+        return mapGetNext(map);
+    }
+
+    return startIteration(map, map->elements, NULL);
+}
+
+MapKeyElement mapLowerBound(Map map, MapKeyElement key)
+{
+    if (map == NULL || key == NULL)
+    {
+        return NULL;
+    }
+
+    if (map->engine != NULL)
+    {
+        map->engine->iterate(map->engine_elements, key, true, NULL);
+        return mapGetNext(map);
+    }
+
+    return startIteration(map, findBound(map, key, true), NULL);
+}
+
+MapKeyElement mapUpperBound(Map map, MapKeyElement key)
+{
+    if (map == NULL || key == NULL)
+    {
+        return NULL;
+    }
+
+    if (map->engine != NULL)
+    {
+        map->engine->iterate(map->engine_elements, key, false, NULL);
+        return mapGetNext(map);
+    }
+
+    return startIteration(map, findBound(map, key, false), NULL);
+}
+
+MapKeyElement mapGetFirstInRange(Map map, MapKeyElement low, MapKeyElement high)
+{
+    if (map == NULL || low == NULL || high == NULL)
+    {
+        return NULL;
+    }
+    if (map->compareElements(low, high) >= 0)
+    {
+        low = high; //An empty range.
+    }
+    if (map->engine != NULL)
+    {
+        map->engine->iterate(map->engine_elements, low, true, high);
+        return mapGetNext(map);
+    }
+
+    MapNode first = findBound(map, low, true);
+    return startIteration(map, first, findBound(map, high, true));
 }
 
 MapKeyElement mapGetNext(Map map)
 {
-    if (map == NULL || map->iterator == NULL)
+    if (map != NULL && map->engine != NULL)
+    {
+        MapKeyElement key = map->engine->currentKey(map->engine_elements);
+        MapKeyElement copy = key == NULL ? NULL : map->copyKeyElement(key);
+        if (copy != NULL)
+        {
+            map->engine->advance(map->engine_elements);
+        }
+        return copy;
+    }
+    if (map == NULL || map->iterator == NULL || map->iterator == map->iterator_end)
     {
         return NULL;
     }
@@ -260,8 +591,20 @@ MapResult mapClear(Map map)
         return MAP_NULL_ARGUMENT;
     }
 
+    if (map->engine != NULL)
+    {
+        MapResult result = map->engine->clear(map->engine_elements);
+        if (result != MAP_SUCCESS)
+        {
+            return result;
+        }
+    }
     freeList(map, map->elements);
     map->elements = NULL;
+    map->iterator = NULL;
+    map->iterator_end = NULL;
+    map->tail = NULL;
+    map->finger = NULL;
     map->length = 0;
 
     return MAP_SUCCESS;
@@ -269,6 +612,27 @@ MapResult mapClear(Map map)
 
 
 //Static auxiliary functions:
+static MapBackend resolveBackend(MapBackend backend)
+{
+    if (backend != MAP_BACKEND_DEFAULT)
+    {
+        return backend;
+    }
+
+    //Maps may be created from several threads; they all resolve the same value.
+    int resolved = __atomic_load_n(&default_backend, __ATOMIC_RELAXED);
+    if (resolved == BACKEND_UNRESOLVED)
+    {
+        resolved = mapGetBackendByName(getenv(BACKEND_ENVIRONMENT_VARIABLE));
+        if (resolved == MAP_BACKEND_DEFAULT)
+        {
+            resolved = MAP_BACKEND_LIST;
+        }
+        __atomic_store_n(&default_backend, resolved, __ATOMIC_RELAXED);
+    }
+    return resolved;
+}
+
 static MapNode findPreviousElementPosition(Map map, MapKeyElement key, SearchResults* results)
 {
     if (map == NULL || key == NULL || results == NULL)
@@ -294,6 +658,18 @@ static MapNode findPreviousElementPosition(Map map, MapKeyElement key, SearchRes
             return NULL;
         }
 
+        //Appending after the largest key.
+        if (map->compareElements(map->tail->key, key) < 0)
+        {
+            *results = NOT_FOUND;
+            return map->tail;
+        }
+        //The key can't come before the finger, so the search may start there.
+        if (map->finger != NULL && map->compareElements(map->finger->key, key) < 0)
+        {
+            current = map->finger;
+        }
+
         while (current != NULL)
         {
             next_node = current->next;
@@ -321,13 +697,64 @@ static MapNode findPreviousElementPosition(Map map, MapKeyElement key, SearchRes
     return previousElement;
 }
 
-static MapNode copyList(Map map, MapNode src)
+static MapNode findBound(Map map, MapKeyElement key, bool inclusive)
+{
+    SearchResults results;
+    MapNode previous = findPreviousElementPosition(map, key, &results);
+
+    if (results == FIRST_ELEMENT)
+    {
+        return inclusive ? map->elements : map->elements->next;
+    }
+    if (results == FOUND)
+    {
+        return inclusive ? previous->next : previous->next->next;
+    }
+    if (results == NOT_FOUND)
+    {
+        return previous->next;
+    }
+
+    //Else: results == NEEDS_TO_BE_FIRST, or the map is empty.
+    return map->elements;
+}
+
+static MapKeyElement startIteration(Map map, MapNode first, MapNode end)
+{
+    map->iterator = first;
+    map->iterator_end = end;
+    return mapGetNext(map);
+}
+
+static MapNode copyList(Map map, MapNode src, MapNode* last_node)
 {
     MapNode dest = NULL, last = NULL;
+    *last_node = NULL;
 
     while (src != NULL)
     {
-        MapNode new_node = malloc(sizeof(*new_node));
+        if (map->arena != NULL)
+        {
+            MapNode new_node = copyArenaNode(map, src);
+            if (new_node == NULL)
+            {
+                freeList(map, dest);
+                return NULL;
+            }
+            if (dest == NULL)
+            {
+                dest = new_node;
+            }
+            else
+            {
+                last->next = new_node;
+            }
+            last = new_node;
+            src = src->next;
+            continue;
+        }
+
+        MapNode new_node = trackedMalloc(MEMORY_MAP_NODES, sizeof(*new_node));
         if (new_node == NULL)
         {
             freeList(map, dest);
@@ -339,13 +766,15 @@ static MapNode copyList(Map map, MapNode src)
         new_node->value = map->copyDataElement(src->value);
         if (new_node->value == NULL)
         {
+            trackedFree(MEMORY_MAP_NODES, new_node, sizeof(*new_node));
             freeList(map, dest);
             return NULL;
         }
         new_node->key = map->copyKeyElement(src->key);
         if (new_node->key == NULL)
         {
-            free(new_node->value);
+            map->freeDataElement(new_node->value);
+            trackedFree(MEMORY_MAP_NODES, new_node, sizeof(*new_node));
             freeList(map, dest);
             return NULL;
         }
@@ -363,6 +792,7 @@ static MapNode copyList(Map map, MapNode src)
         src = src->next;
     }
 
+    *last_node = last;
     return dest;
 }
 
@@ -376,9 +806,8 @@ static void freeList(Map map, MapNode list)
     while (list != NULL)
     {
         MapNode next_node = list->next;
-        map->freeDataElement(list->value);
-        map->freeKeyElement(list->key);
-        free(list);
+        freeNodeElements(map, list);
+        releaseNode(map, list);
         list = next_node;
     }
 }
@@ -394,6 +823,7 @@ static MapResult addOrUpdateNode(Map map, MapDataElement data_copy, MapKeyElemen
         else
         {
             assert(position_node != NULL);
+            map->finger = position_node;
             position_node = position_node->next;
         }
         map->freeDataElement(position_node->value);
@@ -404,15 +834,21 @@ static MapResult addOrUpdateNode(Map map, MapDataElement data_copy, MapKeyElemen
         return MAP_SUCCESS;
     }
 
-    MapNode new_node = malloc(sizeof(*new_node));
+    MapNode new_node = allocateNode(map);
     if (new_node == NULL)
     {
         return MAP_OUT_OF_MEMORY;
     }
     new_node->value = data_copy;
     new_node->key = key_copy;
-    new_node->next = NULL;
 
+    linkNode(map, new_node, position_node, results);
+    return MAP_SUCCESS;
+}
+
+static void linkNode(Map map, MapNode new_node, MapNode position_node, SearchResults results)
+{
+    new_node->next = NULL;
     if (results == NEEDS_TO_BE_FIRST)
     {
         new_node->next = map->elements;
@@ -423,8 +859,152 @@ static MapResult addOrUpdateNode(Map map, MapDataElement data_copy, MapKeyElemen
         assert(position_node != NULL);
         new_node->next = position_node->next;
         position_node->next = new_node;
+        map->finger = position_node;
+    }
+    if (new_node->next == NULL)
+    {
+        map->tail = new_node;
     }
 
     ++(map->length);
+}
+
+//Inline keys start at the first aligned offset after the node, and inline data after them.
+static size_t alignToArena(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+static size_t nodeSize(Map map)
+{
+    if (map->arena == NULL)
+    {
+        return sizeof(struct LinkedListNode);
+    }
+    return alignToArena(sizeof(struct LinkedListNode)) + alignToArena(map->key_size) + map->data_size;
+}
+
+static MapNode allocateNode(Map map)
+{
+    if (map->arena == NULL)
+    {
+        return trackedMalloc(MEMORY_MAP_NODES, sizeof(struct LinkedListNode));
+    }
+
+    MapNode node = arenaAllocate(map->arena, nodeSize(map));
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    char* inline_elements = (char*)node + alignToArena(sizeof(*node));
+    node->key = inline_elements;
+    node->value = map->data_size == 0 ? NULL : inline_elements + alignToArena(map->key_size);
+    return node;
+}
+
+static void releaseNode(Map map, MapNode node)
+{
+    if (map->arena == NULL)
+    {
+        trackedFree(MEMORY_MAP_NODES, node, sizeof(*node));
+    }
+    else
+    {
+        arenaRelease(map->arena, node, nodeSize(map));
+    }
+}
+
+static void freeNodeElements(Map map, MapNode node)
+{
+    if (map->arena == NULL || map->data_size == 0)
+    {
+        map->freeDataElement(node->value);
+    }
+    if (map->arena == NULL)
+    {
+        map->freeKeyElement(node->key);
+    }
+}
+
+static MapResult putInArena(Map map, MapKeyElement keyElement, MapDataElement dataElement)
+{
+    MapDataElement data_copy = NULL;
+    if (map->data_size == 0)
+    {
+        data_copy = map->copyDataElement(dataElement);
+        if (data_copy == NULL)
+        {
+            return MAP_OUT_OF_MEMORY;
+        }
+    }
+
+    SearchResults results;
+    MapNode position_node = findPreviousElementPosition(map, keyElement, &results);
+    if (results == FOUND || results == FIRST_ELEMENT)
+    {
+        if (results == FOUND)
+        {
+            map->finger = position_node;
+        }
+        MapNode node = results == FIRST_ELEMENT ? map->elements : position_node->next;
+        if (map->data_size == 0)
+        {
+            map->freeDataElement(node->value);
+            node->value = data_copy;
+        }
+        else
+        {
+            memmove(node->value, dataElement, map->data_size); //The data may be the node's own.
+        }
+        return MAP_SUCCESS;
+    }
+
+    MapNode new_node = allocateNode(map);
+    if (new_node == NULL)
+    {
+        if (data_copy != NULL)
+        {
+            map->freeDataElement(data_copy);
+        }
+        return MAP_OUT_OF_MEMORY;
+    }
+
+    memcpy(new_node->key, keyElement, map->key_size);
+    if (map->data_size == 0)
+    {
+        new_node->value = data_copy;
+    }
+    else
+    {
+        memcpy(new_node->value, dataElement, map->data_size);
+    }
+
+    linkNode(map, new_node, position_node, results);
     return MAP_SUCCESS;
 }
+
+static MapNode copyArenaNode(Map map, MapNode src)
+{
+    MapNode new_node = allocateNode(map);
+    if (new_node == NULL)
+    {
+        return NULL;
+    }
+
+    new_node->next = NULL;
+    memcpy(new_node->key, src->key, map->key_size);
+    if (map->data_size != 0)
+    {
+        memcpy(new_node->value, src->value, map->data_size);
+        return new_node;
+    }
+
+    new_node->value = map->copyDataElement(src->value);
+    if (new_node->value == NULL)
+    {
+        releaseNode(map, new_node);
+        return NULL;
+    }
+    return new_node;
+}
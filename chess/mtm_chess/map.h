@@ -2,6 +2,8 @@
 #define MAP_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
 
 /**
 * Generic Map Container
@@ -11,8 +13,19 @@
 * where the state of the iterator after calling that function is not stated,
 * it is undefined. That is you cannot assume anything about it.
 *
+* Appending a key larger than all others takes O(1), and so do putting the key right after the
+* most recently put or removed one, and looking the latter up. mapGet and mapContains only read
+* the map, so several threads may look keys up at once as long as none changes the map.
+*
 * The following functions are available:
 *   mapCreate		- Creates a new empty map
+*   mapCreateWithBackend - Creates a new empty map kept in a given structure
+*   mapCreateInArena	- Creates a new empty map stored in an arena
+*   mapCreateBTree	- Creates a new empty map stored in a B+tree
+*   mapCreateSkipList	- Creates a new empty map which several threads may use at once
+*   mapGetBackend	- Returns the structure a map is kept in
+*   mapGetBackendName	- Returns the name of a structure
+*   mapGetBackendByName - Returns the structure of a given name
 *   mapDestroy		- Deletes an existing map and frees all resources
 *   mapCopy		- Copies an existing map
 *   mapGetSize		- Returns the size of a given map
@@ -30,10 +43,17 @@
 *   				  map, and returns a copy of it.
 *   mapGetNext		- Advances the internal iterator to the next key and
 *   				  returns a copy it.
+*   mapLowerBound	- Sets the internal iterator to the first key not smaller than
+*   				  a given key, and returns a copy of it.
+*   mapUpperBound	- Sets the internal iterator to the first key larger than
+*   				  a given key, and returns a copy of it.
+*   mapGetFirstInRange - Sets the internal iterator to the first key of the range
+*   				  [low, high); mapGetNext then stops before high.
 *	 mapClear		- Clears the contents of the map. Frees all the elements of
 *	 				  the map using the free function.
 * 	 MAP_FOREACH	- A macro for iterating over the map's elements, iterator needs to be deallocated (freed)
 *                     each iteration.
+* 	 MAP_FOREACH_RANGE - Like MAP_FOREACH, over the keys of the range [low, high) only.
 */
 
 /** Type for defining the map */
@@ -49,6 +69,25 @@ typedef enum MapResult_t {
     MAP_ITEM_DOES_NOT_EXIST
 } MapResult;
 
+/**
+* The structures a map may keep its elements in. All of them behave the same through this
+* interface, in the same key order; they differ in speed and memory:
+*   MAP_BACKEND_LIST - A sorted linked list. O(1) for keys put in ascending order and for repeated
+*     or consecutive lookups, O(n) otherwise.
+*   MAP_BACKEND_BTREE - A B+tree (see mapBTree.h). O(log n) for any key order, and the fastest to iterate.
+*   MAP_BACKEND_SKIP_LIST - A skip list (see mapSkipList.h). O(log n) expected, and safe to use
+*     from several threads at once (see mapCreateSkipList).
+* MAP_BACKEND_DEFAULT is the structure named by the MAP_BACKEND environment variable ("list",
+* "btree" or "skiplist") when the process creates its first such map, or the list if it's unset.
+*/
+typedef enum MapBackend_t {
+    MAP_BACKEND_DEFAULT,
+    MAP_BACKEND_LIST,
+    MAP_BACKEND_BTREE,
+    MAP_BACKEND_SKIP_LIST,
+    MAP_BACKEND_COUNT
+} MapBackend;
+
 /** Data element data type for map container */
 typedef void *MapDataElement;
 
@@ -78,7 +117,7 @@ typedef void(*freeMapKeyElements)(MapKeyElement);
 typedef int(*compareMapKeyElements)(MapKeyElement, MapKeyElement);
 
 /**
-* mapCreate: Allocates a new empty map.
+* mapCreate: Allocates a new empty map, kept in the MAP_BACKEND_DEFAULT structure.
 *
 * @param copyDataElement - Function pointer to be used for copying data elements into
 *  	the map or when copying the map.
@@ -100,6 +139,100 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements);
 
+/**
+* mapCreateWithBackend: Allocates a new empty map which keeps its elements in the given structure.
+* It takes the same functions as mapCreate.
+*
+* @return
+* 	NULL - if backend is not a MapBackend, one of the functions is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateWithBackend(MapBackend backend,
+                         copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements);
+
+/**
+* mapCreateInArena: Allocates a new empty map from an arena (see arena.h).
+*
+* The map and its nodes come from the arena, and each node stores its key in place: mapPut copies
+* keys of key_size bytes with memcpy instead of copyKeyElement. If data_size is not 0 the data
+* elements, of data_size bytes, are stored in place as well, and mapGet returns a pointer into the
+* node. Such data must not own other resources, since it is never passed to freeDataElement.
+* Otherwise the data elements are copied and freed with the given functions, as in mapCreate.
+*
+* copyKeyElement and freeKeyElement are still used for the keys returned by mapGetFirst and
+* mapGetNext, so iterating works the same as with any other map.
+*
+* mapDestroy only frees the data elements which are not stored in place: the rest of the map's
+* memory belongs to the arena, and is freed all at once by arenaDestroy. The arena must outlive the map.
+*
+* @return
+* 	NULL - if arena or one of the functions is NULL, key_size is 0 or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateInArena(Arena arena, size_t key_size, size_t data_size,
+                     copyMapDataElements copyDataElement,
+                     copyMapKeyElements copyKeyElement,
+                     freeMapDataElements freeDataElement,
+                     freeMapKeyElements freeKeyElement,
+                     compareMapKeyElements compareKeyElements);
+
+/**
+* mapCreateBTree: Allocates a new empty map which keeps its elements in a B+tree (see mapBTree.h)
+* instead of a sorted list, like mapCreateWithBackend with MAP_BACKEND_BTREE. It takes the same functions as mapCreate and behaves the same, but
+* mapPut, mapGet, mapContains and mapRemove take O(log n) whatever the order of the keys, and
+* iterating reads the keys from contiguous leaves.
+*
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateBTree(copyMapDataElements copyDataElement,
+                   copyMapKeyElements copyKeyElement,
+                   freeMapDataElements freeDataElement,
+                   freeMapKeyElements freeKeyElement,
+                   compareMapKeyElements compareKeyElements);
+
+/**
+* mapCreateSkipList: Allocates a new empty map which keeps its elements in a skip list (see
+* mapSkipList.h), like mapCreateWithBackend with MAP_BACKEND_SKIP_LIST. It takes the same functions as mapCreate and behaves the same, but mapGet,
+* mapGetCopy, mapContains, mapPut, mapRemove, mapClear and mapGetSize may be called from several
+* threads at once, and none of them takes a lock. Data returned by mapGet may be freed as soon as
+* another thread puts or removes its key; threads which can't rule that out use mapGetCopy, which
+* copies the data while it can't be freed. A mapClear racing with puts may leave the keys they put.
+* Iterating is not safe while other threads change the map.
+*
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateSkipList(copyMapDataElements copyDataElement,
+                      copyMapKeyElements copyKeyElement,
+                      freeMapDataElements freeDataElement,
+                      freeMapKeyElements freeKeyElement,
+                      compareMapKeyElements compareKeyElements);
+
+/**
+* mapGetBackend: Returns the structure the map keeps its elements in; never MAP_BACKEND_DEFAULT,
+* unless map is NULL. Maps created by mapCreateInArena are lists.
+*/
+MapBackend mapGetBackend(Map map);
+
+/**
+* mapGetBackendName: Returns the name of the given structure, as the MAP_BACKEND environment
+* variable takes it, or NULL if backend is not a MapBackend.
+*/
+const char* mapGetBackendName(MapBackend backend);
+
+/**
+* mapGetBackendByName: Returns the structure of the given name (see mapGetBackendName), or
+* MAP_BACKEND_DEFAULT if name is NULL or names none.
+*/
+MapBackend mapGetBackendByName(const char* name);
+
 /**
 * mapDestroy: Deallocates an existing map. Clears all elements by using the
 * stored free functions.
@@ -174,6 +307,23 @@ we want to get.
 */
 MapDataElement mapGet(Map map, MapKeyElement keyElement);
 
+/**
+*	mapGetCopy: Returns a copy of the data associated with a specific key in the map,
+*			made with the copy function given at initialization.
+*			Iterator status unchanged
+*
+* Unlike the data mapGet returns, the copy belongs to the caller, so it stays valid when other
+* threads put or remove the key of a skip-list map (see mapCreateSkipList).
+*
+* @param map - The map for which to get the data element from.
+* @param keyElement - The key element whose data to copy.
+* @return
+*  NULL if a NULL pointer was sent, the map does not contain the requested key or allocation fails.
+* 	A copy of the data element associated with the key otherwise; the caller frees it with the
+* 	map's free function.
+*/
+MapDataElement mapGetCopy(Map map, MapKeyElement keyElement);
+
 /**
 * 	mapRemove: Removes a pair of key and data elements from the map. The elements
 *  are found using the comparison function given at initialization. Once found,
@@ -190,6 +340,8 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement);
 * @return
 * 	MAP_NULL_ARGUMENT if a NULL was sent to the function
 *  MAP_ITEM_DOES_NOT_EXIST if an equal key item does not already exists in the map
+* 	MAP_OUT_OF_MEMORY if the map is a skip list and the calling thread's record for it (see
+* 	epoch.h) could not be allocated
 * 	MAP_SUCCESS the paired elements had been removed successfully
 */
 MapResult mapRemove(Map map, MapKeyElement keyElement);
@@ -221,6 +373,38 @@ MapKeyElement mapGetFirst(Map map);
 */
 MapKeyElement mapGetNext(Map map);
 
+/**
+*	mapLowerBound: Sets the internal iterator to the smallest key element which is not smaller
+*	than the given key (by the key compare function), and returns a copy of it.
+*	Finding it walks the map from the most recently accessed key when the given key is after it
+*	(see above), so paging forward through the map doesn't restart from the first key.
+* @param map - The map for which to set the iterator
+* @param keyElement - The bound. It doesn't have to be in the map.
+* @return
+* 	NULL if a NULL pointer was sent, no key of the map is large enough or allocation fails
+* 	A copy of the found key element otherwise. mapGetNext continues from it.
+*/
+MapKeyElement mapLowerBound(Map map, MapKeyElement keyElement);
+
+/**
+*	mapUpperBound: Like mapLowerBound, for the smallest key element which is larger than the
+*	given key.
+*/
+MapKeyElement mapUpperBound(Map map, MapKeyElement keyElement);
+
+/**
+*	mapGetFirstInRange: Sets the internal iterator to the smallest key element of the range
+*	[low, high), and returns a copy of it. Until the iterator is set again, mapGetNext returns
+*	NULL after the last key element of the range.
+* @param map - The map for which to set the iterator
+* @param low - The smallest key of the range. It doesn't have to be in the map.
+* @param high - The first key after the range. It doesn't have to be in the map.
+* @return
+* 	NULL if a NULL pointer was sent, the range is empty or allocation fails
+* 	A copy of the first key element of the range otherwise
+*/
+MapKeyElement mapGetFirstInRange(Map map, MapKeyElement low, MapKeyElement high);
+
 
 /**
 * mapClear: Removes all key and data elements from target map.
@@ -229,6 +413,8 @@ MapKeyElement mapGetNext(Map map);
 * 	Target map to remove all element from.
 * @return
 * 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_OUT_OF_MEMORY - if the map is a skip list and the calling thread's record for it (see
+* 	epoch.h) could not be allocated. The map is unchanged then.
 * 	MAP_SUCCESS - Otherwise.
 */
 MapResult mapClear(Map map);
@@ -243,4 +429,14 @@ MapResult mapClear(Map map);
         iterator ;\
         iterator = mapGetNext(map))
 
+/*!
+* Macro for iterating over the keys of a map in the range [low, high).
+* Declares a new iterator for the loop.
+* iterator needs to be deallocated (freed) each iteration
+*/
+#define MAP_FOREACH_RANGE(type, iterator, map, low, high) \
+    for(type iterator = (type) mapGetFirstInRange(map, low, high) ; \
+        iterator ;\
+        iterator = mapGetNext(map))
+
 #endif /* MAP_H_ */
@@ -0,0 +1,642 @@
+#include "mapBTree.h"
+#include "memoryStats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+//Keys per node. The key and pointer arrays of a node then fill four cache lines.
+#define BTREE_CAPACITY 15
+//Nodes other than the root are rebalanced once they have fewer keys than this.
+#define BTREE_MINIMUM (BTREE_CAPACITY / 2)
+
+typedef struct BTree_t *BTree;
+
+typedef struct BTreeNode_t
+{
+    int count;
+    bool is_leaf;
+    MapKeyElement keys[BTREE_CAPACITY];
+    //In a leaf, pointers[i] is the data of keys[i]. In an internal node, pointers[i] is the child
+    //holding the keys smaller than keys[i], and pointers[count] the child holding the rest:
+    //every key of pointers[i] < keys[i] <= every key of pointers[i + 1].
+    void* pointers[BTREE_CAPACITY + 1];
+    //The next leaf in key order. NULL in the last leaf and in internal nodes.
+    struct BTreeNode_t* next;
+} *BTreeNode;
+
+struct BTree_t
+{
+    //Never NULL; an empty tree is a single empty leaf. That leaf stays the first one for good.
+    BTreeNode root;
+    BTreeNode first_leaf;
+    int size;
+
+    copyMapDataElements copyDataElement;
+    copyMapKeyElements copyKeyElement;
+    freeMapDataElements freeDataElement;
+    freeMapKeyElements freeKeyElement;
+    compareMapKeyElements compareElements;
+
+    //The cursor is at key cursor_index of cursor_leaf, and ends at key end_index of end_leaf.
+    //A NULL leaf is the end of the tree.
+    BTreeNode cursor_leaf;
+    int cursor_index;
+    BTreeNode end_leaf;
+    int end_index;
+};
+
+//The engine's operations (see mapEngine.h):
+static void* btreeCreate(copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements);
+static void btreeDestroy(void* engine);
+static void* btreeCopy(void* engine);
+static MapResult btreePut(void* engine, MapKeyElement key, MapDataElement data, bool* added);
+static MapDataElement btreeGet(void* engine, MapKeyElement key);
+static MapDataElement btreeGetCopy(void* engine, MapKeyElement key);
+static MapResult btreeRemove(void* engine, MapKeyElement key);
+static MapResult btreeClear(void* engine);
+static int btreeGetSize(void* engine);
+static void btreeIterate(void* engine, MapKeyElement low, bool inclusive, MapKeyElement high);
+static MapKeyElement btreeCurrentKey(void* engine);
+static void btreeAdvance(void* engine);
+
+const MapEngine BTREE_ENGINE = {
+    &btreeCreate,
+    &btreeDestroy,
+    &btreeCopy,
+    &btreePut,
+    &btreeGet,
+    &btreeGetCopy,
+    &btreeRemove,
+    &btreeClear,
+    &btreeGetSize,
+    &btreeIterate,
+    &btreeCurrentKey,
+    &btreeAdvance
+};
+
+//Declaring static auxiliary functions:
+static BTreeNode createNode(bool is_leaf);
+static void freeNode(BTreeNode node);
+//Frees the keys and data under the node, and the nodes except for keep.
+static void freeSubtree(BTree tree, BTreeNode node, BTreeNode keep);
+//The first index of the node whose key is not smaller than the given one (larger, if inclusive is false).
+static int findIndex(BTree tree, BTreeNode node, MapKeyElement key, bool inclusive);
+//Finds the first key not smaller than the given one (larger, if inclusive is false).
+static void findPosition(BTree tree, MapKeyElement key, bool inclusive, BTreeNode* leaf, int* index);
+//Moves a position past the end of its leaf to the start of the next nonempty one.
+static void normalizePosition(BTreeNode* leaf, int* index);
+
+//Insertion splits full nodes on the way down, so that a split never has to climb back up.
+//Splits the full child of the given (non-full) parent. Returns false if an allocation failed,
+//leaving the tree unchanged.
+static bool splitChild(BTree tree, BTreeNode parent, int child);
+
+//Removal rebalances on the way back up. Returns whether the node dropped below BTREE_MINIMUM keys.
+static bool removeFromNode(BTree tree, BTreeNode node, MapKeyElement key, bool* removed);
+//Refills the given child of parent from a sibling, or merges it with one.
+static void rebalanceChild(BTree tree, BTreeNode parent, int child);
+//Moving a key between leaves needs a new separator copy; these return false if it couldn't be made.
+//The child then stays small, which costs some space but leaves the tree valid.
+static bool borrowFromLeft(BTree tree, BTreeNode parent, int child);
+static bool borrowFromRight(BTree tree, BTreeNode parent, int child);
+//Merges the child right of the given one into it.
+static void mergeChildren(BTree tree, BTreeNode parent, int child);
+
+static void* btreeCreate(copyMapDataElements copyDataElement,
+                         copyMapKeyElements copyKeyElement,
+                         freeMapDataElements freeDataElement,
+                         freeMapKeyElements freeKeyElement,
+                         compareMapKeyElements compareKeyElements)
+{
+    BTree tree = trackedMalloc(MEMORY_MAPS, sizeof(*tree));
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+
+    tree->root = createNode(true);
+    if (tree->root == NULL)
+    {
+        trackedFree(MEMORY_MAPS, tree, sizeof(*tree));
+        return NULL;
+    }
+
+    tree->first_leaf = tree->root;
+    tree->copyDataElement = copyDataElement;
+    tree->copyKeyElement = copyKeyElement;
+    tree->freeDataElement = freeDataElement;
+    tree->freeKeyElement = freeKeyElement;
+    tree->compareElements = compareKeyElements;
+    tree->cursor_leaf = NULL;
+    tree->cursor_index = 0;
+    tree->end_leaf = NULL;
+    tree->end_index = 0;
+    tree->size = 0;
+
+    return tree;
+}
+
+static void btreeDestroy(void* engine)
+{
+    BTree tree = engine;
+    if (tree == NULL)
+    {
+        return;
+    }
+
+    freeSubtree(tree, tree->root, NULL);
+    trackedFree(MEMORY_MAPS, tree, sizeof(*tree));
+}
+
+static void* btreeCopy(void* engine)
+{
+    BTree tree = engine;
+    BTree copy = btreeCreate(tree->copyDataElement, tree->copyKeyElement, tree->freeDataElement,
+                             tree->freeKeyElement, tree->compareElements);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+
+    for (BTreeNode leaf = tree->first_leaf; leaf != NULL; leaf = leaf->next)
+    {
+        for (int index = 0; index < leaf->count; ++index)
+        {
+            bool added;
+            MapKeyElement key = tree->copyKeyElement(leaf->keys[index]);
+            MapDataElement data = key == NULL ? NULL : tree->copyDataElement(leaf->pointers[index]);
+            if (data == NULL || btreePut(copy, key, data, &added) != MAP_SUCCESS)
+            {
+                if (key != NULL)
+                {
+                    tree->freeKeyElement(key);
+                }
+                if (data != NULL)
+                {
+                    tree->freeDataElement(data);
+                }
+                btreeDestroy(copy);
+                return NULL;
+            }
+        }
+    }
+
+    return copy;
+}
+
+static MapResult btreePut(void* engine, MapKeyElement key, MapDataElement data, bool* added)
+{
+    BTree tree = engine;
+    if (tree->root->count == BTREE_CAPACITY)
+    {
+        BTreeNode new_root = createNode(false);
+        if (new_root == NULL)
+        {
+            return MAP_OUT_OF_MEMORY;
+        }
+        new_root->pointers[0] = tree->root;
+        if (!splitChild(tree, new_root, 0))
+        {
+            freeNode(new_root);
+            return MAP_OUT_OF_MEMORY;
+        }
+        tree->root = new_root;
+    }
+
+    BTreeNode node = tree->root;
+    while (!node->is_leaf)
+    {
+        int child = findIndex(tree, node, key, false);
+        if (((BTreeNode)node->pointers[child])->count == BTREE_CAPACITY)
+        {
+            if (!splitChild(tree, node, child))
+            {
+                return MAP_OUT_OF_MEMORY;
+            }
+            if (tree->compareElements(node->keys[child], key) <= 0)
+            {
+                ++child;
+            }
+        }
+        node = node->pointers[child];
+    }
+
+    int index = findIndex(tree, node, key, true);
+    if (index < node->count && tree->compareElements(node->keys[index], key) == 0)
+    {
+        tree->freeKeyElement(node->keys[index]);
+        tree->freeDataElement(node->pointers[index]);
+        node->keys[index] = key;
+        node->pointers[index] = data;
+        *added = false;
+        return MAP_SUCCESS;
+    }
+
+    memmove(node->keys + index + 1, node->keys + index, sizeof(*(node->keys)) * (node->count - index));
+    memmove(node->pointers + index + 1, node->pointers + index,
+            sizeof(*(node->pointers)) * (node->count - index));
+    node->keys[index] = key;
+    node->pointers[index] = data;
+    ++(node->count);
+    ++(tree->size);
+    *added = true;
+    return MAP_SUCCESS;
+}
+
+static MapDataElement btreeGet(void* engine, MapKeyElement key)
+{
+    BTree tree = engine;
+    BTreeNode node = tree->root;
+    while (!node->is_leaf)
+    {
+        node = node->pointers[findIndex(tree, node, key, false)];
+    }
+
+    int index = findIndex(tree, node, key, true);
+    if (index < node->count && tree->compareElements(node->keys[index], key) == 0)
+    {
+        return node->pointers[index];
+    }
+    return NULL;
+}
+
+static MapDataElement btreeGetCopy(void* engine, MapKeyElement key)
+{
+    BTree tree = engine;
+    MapDataElement data = btreeGet(tree, key);
+    return data == NULL ? NULL : tree->copyDataElement(data);
+}
+
+static MapResult btreeRemove(void* engine, MapKeyElement key)
+{
+    BTree tree = engine;
+    bool removed = false;
+    removeFromNode(tree, tree->root, key, &removed);
+
+    //A root left with a single child hands the root over to it.
+    if (!tree->root->is_leaf && tree->root->count == 0)
+    {
+        BTreeNode old_root = tree->root;
+        tree->root = old_root->pointers[0];
+        freeNode(old_root);
+    }
+
+    if (!removed)
+    {
+        return MAP_ITEM_DOES_NOT_EXIST;
+    }
+    --(tree->size);
+    return MAP_SUCCESS;
+}
+
+static MapResult btreeClear(void* engine)
+{
+    BTree tree = engine;
+    freeSubtree(tree, tree->root, tree->first_leaf);
+    tree->root = tree->first_leaf;
+    tree->first_leaf->count = 0;
+    tree->first_leaf->next = NULL;
+    tree->cursor_leaf = NULL;
+    tree->end_leaf = NULL;
+    tree->size = 0;
+    return MAP_SUCCESS;
+}
+
+static int btreeGetSize(void* engine)
+{
+    return ((BTree)engine)->size;
+}
+
+static void btreeIterate(void* engine, MapKeyElement low, bool inclusive, MapKeyElement high)
+{
+    BTree tree = engine;
+    if (low == NULL)
+    {
+        tree->cursor_leaf = tree->first_leaf;
+        tree->cursor_index = 0;
+        normalizePosition(&tree->cursor_leaf, &tree->cursor_index);
+    }
+    else
+    {
+        findPosition(tree, low, inclusive, &tree->cursor_leaf, &tree->cursor_index);
+    }
+
+    if (high == NULL)
+    {
+        tree->end_leaf = NULL;
+        tree->end_index = 0;
+    }
+    else
+    {
+        findPosition(tree, high, true, &tree->end_leaf, &tree->end_index);
+    }
+}
+
+static MapKeyElement btreeCurrentKey(void* engine)
+{
+    BTree tree = engine;
+    if (tree->cursor_leaf == NULL
+        || (tree->cursor_leaf == tree->end_leaf && tree->cursor_index == tree->end_index))
+    {
+        return NULL;
+    }
+    return tree->cursor_leaf->keys[tree->cursor_index];
+}
+
+static void btreeAdvance(void* engine)
+{
+    BTree tree = engine;
+    if (btreeCurrentKey(tree) == NULL)
+    {
+        return;
+    }
+
+    ++(tree->cursor_index);
+    normalizePosition(&tree->cursor_leaf, &tree->cursor_index);
+}
+
+
+//Static auxiliary functions:
+static BTreeNode createNode(bool is_leaf)
+{
+    BTreeNode node = trackedMalloc(MEMORY_MAP_NODES, sizeof(*node));
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->count = 0;
+    node->is_leaf = is_leaf;
+    node->next = NULL;
+    return node;
+}
+
+static void freeNode(BTreeNode node)
+{
+    trackedFree(MEMORY_MAP_NODES, node, sizeof(*node));
+}
+
+static void freeSubtree(BTree tree, BTreeNode node, BTreeNode keep)
+{
+    for (int index = 0; index < node->count; ++index)
+    {
+        tree->freeKeyElement(node->keys[index]);
+        if (node->is_leaf)
+        {
+            tree->freeDataElement(node->pointers[index]);
+        }
+        else
+        {
+            freeSubtree(tree, node->pointers[index], keep);
+        }
+    }
+    if (!node->is_leaf)
+    {
+        freeSubtree(tree, node->pointers[node->count], keep);
+    }
+
+    if (node != keep)
+    {
+        freeNode(node);
+    }
+}
+
+static int findIndex(BTree tree, BTreeNode node, MapKeyElement key, bool inclusive)
+{
+    int low = 0, high = node->count;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        int comparison = tree->compareElements(node->keys[middle], key);
+        if (comparison < 0 || (comparison == 0 && !inclusive))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void findPosition(BTree tree, MapKeyElement key, bool inclusive, BTreeNode* leaf, int* index)
+{
+    //Keys equal to a separator are in the child right of it, so both bounds descend the same way.
+    BTreeNode node = tree->root;
+    while (!node->is_leaf)
+    {
+        node = node->pointers[findIndex(tree, node, key, false)];
+    }
+
+    *leaf = node;
+    *index = findIndex(tree, node, key, inclusive);
+    normalizePosition(leaf, index);
+}
+
+static void normalizePosition(BTreeNode* leaf, int* index)
+{
+    while (*leaf != NULL && *index >= (*leaf)->count)
+    {
+        *leaf = (*leaf)->next;
+        *index = 0;
+    }
+}
+
+static bool splitChild(BTree tree, BTreeNode parent, int child)
+{
+    BTreeNode left = parent->pointers[child];
+    BTreeNode right = createNode(left->is_leaf);
+    if (right == NULL)
+    {
+        return false;
+    }
+
+    int middle = BTREE_CAPACITY / 2;
+    MapKeyElement separator;
+    if (left->is_leaf)
+    {
+        //The leaf keeps its first keys; the separator is a copy of the first key moving right.
+        separator = tree->copyKeyElement(left->keys[middle]);
+        if (separator == NULL)
+        {
+            freeNode(right);
+            return false;
+        }
+        right->count = BTREE_CAPACITY - middle;
+        memcpy(right->keys, left->keys + middle, sizeof(*(right->keys)) * right->count);
+        memcpy(right->pointers, left->pointers + middle, sizeof(*(right->pointers)) * right->count);
+        right->next = left->next;
+        left->next = right;
+    }
+    else
+    {
+        //The middle key itself moves up.
+        separator = left->keys[middle];
+        right->count = BTREE_CAPACITY - middle - 1;
+        memcpy(right->keys, left->keys + middle + 1, sizeof(*(right->keys)) * right->count);
+        memcpy(right->pointers, left->pointers + middle + 1, sizeof(*(right->pointers)) * (right->count + 1));
+    }
+    left->count = middle;
+
+    memmove(parent->keys + child + 1, parent->keys + child, sizeof(*(parent->keys)) * (parent->count - child));
+    memmove(parent->pointers + child + 2, parent->pointers + child + 1,
+            sizeof(*(parent->pointers)) * (parent->count - child));
+    parent->keys[child] = separator;
+    parent->pointers[child + 1] = right;
+    ++(parent->count);
+    return true;
+}
+
+static bool removeFromNode(BTree tree, BTreeNode node, MapKeyElement key, bool* removed)
+{
+    if (!node->is_leaf)
+    {
+        int child = findIndex(tree, node, key, false);
+        if (removeFromNode(tree, node->pointers[child], key, removed))
+        {
+            rebalanceChild(tree, node, child);
+        }
+        return node->count < BTREE_MINIMUM;
+    }
+
+    int index = findIndex(tree, node, key, true);
+    if (index == node->count || tree->compareElements(node->keys[index], key) != 0)
+    {
+        return false;
+    }
+
+    tree->freeKeyElement(node->keys[index]);
+    tree->freeDataElement(node->pointers[index]);
+    --(node->count);
+    memmove(node->keys + index, node->keys + index + 1, sizeof(*(node->keys)) * (node->count - index));
+    memmove(node->pointers + index, node->pointers + index + 1,
+            sizeof(*(node->pointers)) * (node->count - index));
+    *removed = true;
+    return node->count < BTREE_MINIMUM;
+}
+
+static void rebalanceChild(BTree tree, BTreeNode parent, int child)
+{
+    BTreeNode node = parent->pointers[child];
+    BTreeNode left = child > 0 ? parent->pointers[child - 1] : NULL;
+    BTreeNode right = child < parent->count ? parent->pointers[child + 1] : NULL;
+    //Merging internal nodes brings the separator down between them.
+    int merged_extra = node->is_leaf ? 0 : 1;
+
+    if (left != NULL && left->count > BTREE_MINIMUM && borrowFromLeft(tree, parent, child))
+    {
+        return;
+    }
+    if (right != NULL && right->count > BTREE_MINIMUM && borrowFromRight(tree, parent, child))
+    {
+        return;
+    }
+
+    if (left != NULL && left->count + node->count + merged_extra <= BTREE_CAPACITY)
+    {
+        mergeChildren(tree, parent, child - 1);
+    }
+    else if (right != NULL && node->count + right->count + merged_extra <= BTREE_CAPACITY)
+    {
+        mergeChildren(tree, parent, child);
+    }
+}
+
+static bool borrowFromLeft(BTree tree, BTreeNode parent, int child)
+{
+    BTreeNode node = parent->pointers[child];
+    BTreeNode left = parent->pointers[child - 1];
+
+    if (node->is_leaf)
+    {
+        MapKeyElement separator = tree->copyKeyElement(left->keys[left->count - 1]);
+        if (separator == NULL)
+        {
+            return false;
+        }
+        memmove(node->keys + 1, node->keys, sizeof(*(node->keys)) * node->count);
+        memmove(node->pointers + 1, node->pointers, sizeof(*(node->pointers)) * node->count);
+        node->keys[0] = left->keys[left->count - 1];
+        node->pointers[0] = left->pointers[left->count - 1];
+        tree->freeKeyElement(parent->keys[child - 1]);
+        parent->keys[child - 1] = separator;
+    }
+    else
+    {
+        memmove(node->keys + 1, node->keys, sizeof(*(node->keys)) * node->count);
+        memmove(node->pointers + 1, node->pointers, sizeof(*(node->pointers)) * (node->count + 1));
+        node->keys[0] = parent->keys[child - 1];
+        node->pointers[0] = left->pointers[left->count];
+        parent->keys[child - 1] = left->keys[left->count - 1];
+    }
+
+    --(left->count);
+    ++(node->count);
+    return true;
+}
+
+static bool borrowFromRight(BTree tree, BTreeNode parent, int child)
+{
+    BTreeNode node = parent->pointers[child];
+    BTreeNode right = parent->pointers[child + 1];
+
+    if (node->is_leaf)
+    {
+        //The right leaf keeps more than BTREE_MINIMUM keys, so it has a second one to separate at.
+        MapKeyElement separator = tree->copyKeyElement(right->keys[1]);
+        if (separator == NULL)
+        {
+            return false;
+        }
+        node->keys[node->count] = right->keys[0];
+        node->pointers[node->count] = right->pointers[0];
+        tree->freeKeyElement(parent->keys[child]);
+        parent->keys[child] = separator;
+        memmove(right->pointers, right->pointers + 1, sizeof(*(right->pointers)) * (right->count - 1));
+    }
+    else
+    {
+        node->keys[node->count] = parent->keys[child];
+        node->pointers[node->count + 1] = right->pointers[0];
+        parent->keys[child] = right->keys[0];
+        memmove(right->pointers, right->pointers + 1, sizeof(*(right->pointers)) * right->count);
+    }
+    memmove(right->keys, right->keys + 1, sizeof(*(right->keys)) * (right->count - 1));
+
+    --(right->count);
+    ++(node->count);
+    return true;
+}
+
+static void mergeChildren(BTree tree, BTreeNode parent, int child)
+{
+    BTreeNode left = parent->pointers[child];
+    BTreeNode right = parent->pointers[child + 1];
+
+    if (left->is_leaf)
+    {
+        tree->freeKeyElement(parent->keys[child]);
+        memcpy(left->keys + left->count, right->keys, sizeof(*(left->keys)) * right->count);
+        memcpy(left->pointers + left->count, right->pointers, sizeof(*(left->pointers)) * right->count);
+        left->count += right->count;
+        left->next = right->next;
+    }
+    else
+    {
+        left->keys[left->count] = parent->keys[child];
+        memcpy(left->keys + left->count + 1, right->keys, sizeof(*(left->keys)) * right->count);
+        memcpy(left->pointers + left->count + 1, right->pointers, sizeof(*(left->pointers)) * (right->count + 1));
+        left->count += right->count + 1;
+    }
+    freeNode(right);
+
+    --(parent->count);
+    memmove(parent->keys + child, parent->keys + child + 1, sizeof(*(parent->keys)) * (parent->count - child));
+    memmove(parent->pointers + child + 1, parent->pointers + child + 2,
+            sizeof(*(parent->pointers)) * (parent->count - child));
+}
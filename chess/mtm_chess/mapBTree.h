@@ -0,0 +1,19 @@
+#ifndef MAP_BTREE_H
+#define MAP_BTREE_H
+
+#include "mapEngine.h"
+
+/**
+* B+tree engine behind the MAP_BACKEND_BTREE maps (see map.h and mapEngine.h).
+*
+* Every node holds up to a few cache lines' worth of contiguous key pointers, so a lookup touches
+* O(log n) nodes and compares inside each with a binary search. The data sits in the leaves only,
+* and the leaves are linked in key order: iterating is a sequential walk over them.
+*
+* The tree owns the keys and data put into it and frees them with the functions it was created
+* with. The separator keys of the internal nodes are copies of leaf keys.
+*/
+
+extern const MapEngine BTREE_ENGINE;
+
+#endif //MAP_BTREE_H
@@ -0,0 +1,58 @@
+#ifndef MAP_ENGINE_H
+#define MAP_ENGINE_H
+
+#include <stdbool.h>
+#include "map.h"
+
+/**
+* The operations of a structure keeping the elements of a map (see mapCreateWithBackend in map.h).
+* map.c keeps the elements of MAP_BACKEND_LIST maps itself; every other backend has an engine,
+* which map.c calls through this table.
+*
+* An engine owns the keys and data put into it and frees them with the functions it was created
+* with; map.c makes the copies before putting them. Engines keep a single cursor for map.c's
+* internal iterator.
+*
+* The operations, where engine is the value create returned:
+*   create	- Creates an empty engine. Returns NULL if an allocation failed.
+*   destroy	- Frees the engine with all of its keys and data. Does nothing for NULL.
+*   copy	- Copies the engine with copies of its keys and data. Returns NULL if an allocation failed.
+*   put		- Takes the given key and data over, replacing the data of an equal key (one of the
+*		  equal keys is freed then), and sets added to whether the key is new. Returns
+*		  MAP_OUT_OF_MEMORY, without taking anything over, if an allocation failed.
+*   get		- Returns the data of the key equal to the given one, or NULL.
+*   getCopy	- Returns a copy of the data of the key equal to the given one, made with the copy
+*		  function the engine was created with, or NULL if there's none or the copy failed.
+*   remove	- Removes and frees the key equal to the given one and its data. Returns
+*		  MAP_ITEM_DOES_NOT_EXIST if there's none.
+*   clear	- Removes and frees every key and data. Returns MAP_OUT_OF_MEMORY, leaving the engine
+*		  unchanged, if it couldn't allocate what it needs to do that.
+*   getSize	- Returns the number of keys.
+*   iterate	- Sets the cursor to the first key not smaller than low (larger, if inclusive is false),
+*		  or to the first key if low is NULL. The cursor then stops at the first key not
+*		  smaller than high, or at the end if high is NULL. Changing the engine leaves the
+*		  cursor undefined.
+*   currentKey	- Returns the key under the cursor (not a copy), or NULL at the cursor's end.
+*   advance	- Moves the cursor to the next key, unless it's at its end.
+*/
+typedef struct MapEngine_t
+{
+    void* (*create)(copyMapDataElements copyDataElement,
+                    copyMapKeyElements copyKeyElement,
+                    freeMapDataElements freeDataElement,
+                    freeMapKeyElements freeKeyElement,
+                    compareMapKeyElements compareKeyElements);
+    void (*destroy)(void* engine);
+    void* (*copy)(void* engine);
+    MapResult (*put)(void* engine, MapKeyElement key, MapDataElement data, bool* added);
+    MapDataElement (*get)(void* engine, MapKeyElement key);
+    MapDataElement (*getCopy)(void* engine, MapKeyElement key);
+    MapResult (*remove)(void* engine, MapKeyElement key);
+    MapResult (*clear)(void* engine);
+    int (*getSize)(void* engine);
+    void (*iterate)(void* engine, MapKeyElement low, bool inclusive, MapKeyElement high);
+    MapKeyElement (*currentKey)(void* engine);
+    void (*advance)(void* engine);
+} MapEngine;
+
+#endif //MAP_ENGINE_H
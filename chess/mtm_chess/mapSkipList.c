@@ -0,0 +1,780 @@
+#include "mapSkipList.h"
+#include "epoch.h"
+#include "memoryStats.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+//Each level holds about a quarter of the nodes below it, so this many levels serve 4^16 keys.
+#define SKIP_LIST_MAX_HEIGHT 16
+#define RANDOM_SEED 0x9e3779b9u
+//Set in a node's forward pointer once the node is being unlinked on that level, and in its data
+//once its key is removed. Nodes and data come from malloc, so the lowest bit is otherwise clear.
+#define REMOVED_MARK ((uintptr_t)1)
+
+typedef struct SkipList_t *SkipList;
+
+typedef struct SkipNode_t
+{
+    MapKeyElement key;
+    //Swapped atomically when the key's data is replaced; marked by the removal which takes the key.
+    MapDataElement data;
+    int height;
+    //The node's inserter and its remover each let go of it once done linking or unlinking it; the
+    //last of them retires it.
+    int owners;
+    //Once the node is unlinked, it waits for the readers in the list's retired nodes.
+    struct SkipNode_t* retired_next;
+    unsigned long retired_epoch;
+    //The node's forward pointer on each of its levels, read and written atomically.
+    struct SkipNode_t* next[];
+} *SkipNode;
+
+//Data replaced by skipListPut, waiting for the readers.
+typedef struct RetiredData_t
+{
+    MapDataElement data;
+    unsigned long epoch;
+    struct RetiredData_t* next;
+} *RetiredData;
+
+struct SkipList_t
+{
+    SkipNode head; //A keyless node of the maximal height, before the first key.
+    int size;
+    unsigned int random_state; //Advanced atomically by every insertion.
+
+    copyMapDataElements copyDataElement;
+    copyMapKeyElements copyKeyElement;
+    freeMapDataElements freeDataElement;
+    freeMapKeyElements freeKeyElement;
+    compareMapKeyElements compareElements;
+
+    //Stacks pushed with compare-and-swap, and taken whole by whoever reclaims them.
+    SkipNode retired_nodes;
+    RetiredData retired_data;
+
+    //The cursor ends at end; NULL is the end of the list.
+    SkipNode cursor;
+    SkipNode end;
+};
+
+//The engine's operations (see mapEngine.h):
+static void* skipListCreate(copyMapDataElements copyDataElement,
+                            copyMapKeyElements copyKeyElement,
+                            freeMapDataElements freeDataElement,
+                            freeMapKeyElements freeKeyElement,
+                            compareMapKeyElements compareKeyElements);
+static void skipListDestroy(void* engine);
+static void* skipListCopy(void* engine);
+static MapResult skipListPut(void* engine, MapKeyElement key, MapDataElement data, bool* added);
+static MapDataElement skipListGet(void* engine, MapKeyElement key);
+static MapDataElement skipListGetCopy(void* engine, MapKeyElement key);
+static MapResult skipListRemove(void* engine, MapKeyElement key);
+static MapResult skipListClear(void* engine);
+static int skipListGetSize(void* engine);
+static void skipListIterate(void* engine, MapKeyElement low, bool inclusive, MapKeyElement high);
+static MapKeyElement skipListCurrentKey(void* engine);
+static void skipListAdvance(void* engine);
+
+const MapEngine SKIP_LIST_ENGINE = {
+    &skipListCreate,
+    &skipListDestroy,
+    &skipListCopy,
+    &skipListPut,
+    &skipListGet,
+    &skipListGetCopy,
+    &skipListRemove,
+    &skipListClear,
+    &skipListGetSize,
+    &skipListIterate,
+    &skipListCurrentKey,
+    &skipListAdvance
+};
+
+//Declaring static auxiliary functions:
+static SkipNode createNode(int height);
+static void freeNode(SkipNode node);
+static bool isMarked(void* pointer);
+static void* withMark(void* pointer);
+static void* withoutMark(void* pointer);
+//Sequentially consistent: an inserter linking a level and then checking the node's data, and a
+//remover marking the data and then searching that level, must not both miss the other.
+//Returns the node's forward pointer on the level, mark included.
+static SkipNode loadNext(SkipNode node, int level);
+static MapDataElement loadData(SkipNode node);
+static bool compareAndSwapNext(SkipNode node, int level, SkipNode expected, SkipNode desired);
+static int randomHeight(SkipList list);
+
+//Sets predecessors and successors to the nodes around the given key on each level, unlinking the
+//marked nodes on the way. Returns whether successors[0] holds the key. Run in a critical section.
+static bool findPosition(SkipList list, MapKeyElement key, SkipNode* predecessors, SkipNode* successors);
+//One pass of findPosition; returns false if another thread changed a predecessor under it.
+static bool tryFindPosition(SkipList list, MapKeyElement key, SkipNode* predecessors, SkipNode* successors);
+//Returns the first node whose key is not smaller than the given one (larger, if inclusive is
+//false), or NULL, without changing the list. Nodes being unlinked are stepped over.
+static SkipNode findNode(SkipList list, MapKeyElement key, bool inclusive);
+//Returns the first node from the given one on whose key is still in the list, or NULL.
+static SkipNode skipRemoved(SkipNode node);
+//Returns the data of the key equal to the given one, or NULL. Run in a critical section.
+static MapDataElement lookUp(SkipList list, MapKeyElement key);
+
+//Links the levels above the bottom one of a node just linked there, then lets go of it.
+static void linkUpperLevels(SkipList list, SkipNode node, SkipNode* predecessors, SkipNode* successors);
+//Marks the node's forward pointers from the top level down, so nothing more is linked after it.
+static void markLevels(SkipNode node);
+//Removes the node's key unless another thread did first; returns whether this call did.
+static bool removeNode(SkipList list, SkipNode node);
+static void releaseNode(SkipList list, SkipNode node);
+
+//Push an unlinked node or replaced data for freeing.
+static void retireNode(SkipList list, SkipNode node);
+static void retireData(SkipList list, RetiredData retired);
+//Frees whatever was retired and no reader can still be on. Called outside critical sections.
+static void reclaim(SkipList list);
+
+static void* skipListCreate(copyMapDataElements copyDataElement,
+                            copyMapKeyElements copyKeyElement,
+                            freeMapDataElements freeDataElement,
+                            freeMapKeyElements freeKeyElement,
+                            compareMapKeyElements compareKeyElements)
+{
+    SkipList list = trackedMalloc(MEMORY_MAPS, sizeof(*list));
+    if (list == NULL)
+    {
+        return NULL;
+    }
+
+    list->head = createNode(SKIP_LIST_MAX_HEIGHT);
+    if (list->head == NULL)
+    {
+        trackedFree(MEMORY_MAPS, list, sizeof(*list));
+        return NULL;
+    }
+
+    list->head->key = NULL;
+    list->head->data = NULL;
+    list->size = 0;
+    list->random_state = RANDOM_SEED;
+    list->copyDataElement = copyDataElement;
+    list->copyKeyElement = copyKeyElement;
+    list->freeDataElement = freeDataElement;
+    list->freeKeyElement = freeKeyElement;
+    list->compareElements = compareKeyElements;
+    list->retired_nodes = NULL;
+    list->retired_data = NULL;
+    list->cursor = NULL;
+    list->end = NULL;
+
+    return list;
+}
+
+static void skipListDestroy(void* engine)
+{
+    SkipList list = engine;
+    if (list == NULL)
+    {
+        return;
+    }
+
+    //Nobody else uses the list anymore, so everything can go right away.
+    SkipNode node = list->head->next[0];
+    while (node != NULL)
+    {
+        SkipNode next = withoutMark(node->next[0]);
+        list->freeKeyElement(node->key);
+        list->freeDataElement(withoutMark(node->data));
+        freeNode(node);
+        node = next;
+    }
+    while (list->retired_nodes != NULL)
+    {
+        SkipNode next = list->retired_nodes->retired_next;
+        list->freeKeyElement(list->retired_nodes->key);
+        list->freeDataElement(withoutMark(list->retired_nodes->data));
+        freeNode(list->retired_nodes);
+        list->retired_nodes = next;
+    }
+    while (list->retired_data != NULL)
+    {
+        RetiredData next = list->retired_data->next;
+        list->freeDataElement(list->retired_data->data);
+        trackedFree(MEMORY_MAPS, list->retired_data, sizeof(*(list->retired_data)));
+        list->retired_data = next;
+    }
+
+    freeNode(list->head);
+    trackedFree(MEMORY_MAPS, list, sizeof(*list));
+}
+
+static void* skipListCopy(void* engine)
+{
+    SkipList list = engine;
+    SkipList copy = skipListCreate(list->copyDataElement, list->copyKeyElement, list->freeDataElement,
+                                   list->freeKeyElement, list->compareElements);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    if (!epochEnter())
+    {
+        skipListDestroy(copy);
+        return NULL;
+    }
+
+    //Keys put or removed by other threads meanwhile may or may not make it into the copy.
+    for (SkipNode node = skipRemoved(withoutMark(loadNext(list->head, 0))); node != NULL;
+         node = skipRemoved(withoutMark(loadNext(node, 0))))
+    {
+        bool added;
+        MapDataElement node_data = loadData(node);
+        if (isMarked(node_data))
+        {
+            continue;
+        }
+        MapKeyElement key = list->copyKeyElement(node->key);
+        MapDataElement data = key == NULL ? NULL : list->copyDataElement(node_data);
+        if (data == NULL || skipListPut(copy, key, data, &added) != MAP_SUCCESS)
+        {
+            if (key != NULL)
+            {
+                list->freeKeyElement(key);
+            }
+            if (data != NULL)
+            {
+                list->freeDataElement(data);
+            }
+            epochExit();
+            skipListDestroy(copy);
+            return NULL;
+        }
+    }
+    epochExit();
+
+    return copy;
+}
+
+static MapResult skipListPut(void* engine, MapKeyElement key, MapDataElement data, bool* added)
+{
+    SkipList list = engine;
+    SkipNode predecessors[SKIP_LIST_MAX_HEIGHT];
+    SkipNode successors[SKIP_LIST_MAX_HEIGHT];
+    SkipNode new_node = NULL;
+    RetiredData retired = NULL;
+    MapResult result = MAP_OUT_OF_MEMORY;
+
+    if (!epochEnter())
+    {
+        return MAP_OUT_OF_MEMORY;
+    }
+    while (true)
+    {
+        if (findPosition(list, key, predecessors, successors))
+        {
+            SkipNode node = successors[0];
+            MapDataElement old_data = loadData(node);
+            if (isMarked(old_data))
+            {
+                //Being removed: help, so that the next search unlinks it, and insert after all.
+                markLevels(node);
+                continue;
+            }
+            if (retired == NULL)
+            {
+                retired = trackedMalloc(MEMORY_MAPS, sizeof(*retired));
+                if (retired == NULL)
+                {
+                    break;
+                }
+            }
+            if (__atomic_compare_exchange_n(&node->data, &old_data, data, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            {
+                //The node keeps its own key, which lookups may be comparing against right now.
+                list->freeKeyElement(key);
+                retired->data = old_data;
+                retireData(list, retired);
+                retired = NULL;
+                *added = false;
+                result = MAP_SUCCESS;
+                break;
+            }
+            continue;
+        }
+
+        if (new_node == NULL)
+        {
+            new_node = createNode(randomHeight(list));
+            if (new_node == NULL)
+            {
+                break;
+            }
+            new_node->key = key;
+            new_node->data = data;
+        }
+        for (int level = 0; level < new_node->height; ++level)
+        {
+            new_node->next[level] = successors[level];
+        }
+        //The key is in the list as soon as the bottom level links it.
+        if (compareAndSwapNext(predecessors[0], 0, successors[0], new_node))
+        {
+            __atomic_add_fetch(&list->size, 1, __ATOMIC_RELAXED);
+            linkUpperLevels(list, new_node, predecessors, successors);
+            new_node = NULL;
+            *added = true;
+            result = MAP_SUCCESS;
+            break;
+        }
+    }
+    epochExit();
+
+    //Whatever wasn't used was never seen by another thread.
+    if (new_node != NULL)
+    {
+        freeNode(new_node);
+    }
+    if (retired != NULL)
+    {
+        trackedFree(MEMORY_MAPS, retired, sizeof(*retired));
+    }
+    reclaim(list);
+    return result;
+}
+
+static MapDataElement skipListGet(void* engine, MapKeyElement key)
+{
+    SkipList list = engine;
+    if (!epochEnter())
+    {
+        return NULL;
+    }
+    MapDataElement data = lookUp(list, key);
+    epochExit();
+    return data;
+}
+
+static MapDataElement skipListGetCopy(void* engine, MapKeyElement key)
+{
+    SkipList list = engine;
+    if (!epochEnter())
+    {
+        return NULL;
+    }
+    //Copied before leaving the critical section, while a put or removal of the key can't free it.
+    MapDataElement data = lookUp(list, key);
+    MapDataElement copy = data == NULL ? NULL : list->copyDataElement(data);
+    epochExit();
+    return copy;
+}
+
+static MapResult skipListRemove(void* engine, MapKeyElement key)
+{
+    SkipList list = engine;
+    SkipNode predecessors[SKIP_LIST_MAX_HEIGHT];
+    SkipNode successors[SKIP_LIST_MAX_HEIGHT];
+    MapResult result = MAP_ITEM_DOES_NOT_EXIST;
+
+    if (!epochEnter())
+    {
+        return MAP_OUT_OF_MEMORY;
+    }
+    while (findPosition(list, key, predecessors, successors))
+    {
+        if (removeNode(list, successors[0]))
+        {
+            result = MAP_SUCCESS;
+            break;
+        }
+        //Another removal took it first: help, then look again for a key put back since.
+        markLevels(successors[0]);
+    }
+    epochExit();
+
+    reclaim(list);
+    return result;
+}
+
+static MapResult skipListClear(void* engine)
+{
+    SkipList list = engine;
+    if (!epochEnter())
+    {
+        return MAP_OUT_OF_MEMORY;
+    }
+    //Removed key by key: keys which other threads put meanwhile may stay.
+    for (SkipNode node = withoutMark(loadNext(list->head, 0)); node != NULL;
+         node = withoutMark(loadNext(node, 0)))
+    {
+        removeNode(list, node);
+    }
+    epochExit();
+
+    reclaim(list);
+    return MAP_SUCCESS;
+}
+
+static int skipListGetSize(void* engine)
+{
+    SkipList list = engine;
+    return __atomic_load_n(&list->size, __ATOMIC_RELAXED);
+}
+
+static void skipListIterate(void* engine, MapKeyElement low, bool inclusive, MapKeyElement high)
+{
+    //Iterating is not safe alongside removals anyway, so no node can be freed under the cursor.
+    SkipList list = engine;
+    list->cursor = low == NULL ? withoutMark(loadNext(list->head, 0)) : findNode(list, low, inclusive);
+    list->cursor = skipRemoved(list->cursor);
+    list->end = high == NULL ? NULL : skipRemoved(findNode(list, high, true));
+}
+
+static MapKeyElement skipListCurrentKey(void* engine)
+{
+    SkipList list = engine;
+    if (list->cursor == NULL || list->cursor == list->end)
+    {
+        return NULL;
+    }
+    return list->cursor->key;
+}
+
+static void skipListAdvance(void* engine)
+{
+    SkipList list = engine;
+    if (skipListCurrentKey(list) != NULL)
+    {
+        list->cursor = skipRemoved(withoutMark(loadNext(list->cursor, 0)));
+    }
+}
+
+
+//Static auxiliary functions:
+static SkipNode createNode(int height)
+{
+    SkipNode node = trackedMalloc(MEMORY_MAP_NODES, sizeof(*node) + sizeof(node->next[0]) * height);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->height = height;
+    node->owners = 2;
+    node->retired_next = NULL;
+    for (int level = 0; level < height; ++level)
+    {
+        node->next[level] = NULL;
+    }
+    return node;
+}
+
+static void freeNode(SkipNode node)
+{
+    trackedFree(MEMORY_MAP_NODES, node, sizeof(*node) + sizeof(node->next[0]) * node->height);
+}
+
+static bool isMarked(void* pointer)
+{
+    return ((uintptr_t)pointer & REMOVED_MARK) != 0;
+}
+
+static void* withMark(void* pointer)
+{
+    return (void*)((uintptr_t)pointer | REMOVED_MARK);
+}
+
+static void* withoutMark(void* pointer)
+{
+    return (void*)((uintptr_t)pointer & ~REMOVED_MARK);
+}
+
+static SkipNode loadNext(SkipNode node, int level)
+{
+    return __atomic_load_n(&node->next[level], __ATOMIC_SEQ_CST);
+}
+
+static MapDataElement loadData(SkipNode node)
+{
+    return __atomic_load_n(&node->data, __ATOMIC_SEQ_CST);
+}
+
+static bool compareAndSwapNext(SkipNode node, int level, SkipNode expected, SkipNode desired)
+{
+    return __atomic_compare_exchange_n(&node->next[level], &expected, desired, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static int randomHeight(SkipList list)
+{
+    //A Weyl sequence mixed by murmur3's finalizer; each further level takes two more zero bits.
+    uint32_t random = __atomic_add_fetch(&list->random_state, RANDOM_SEED, __ATOMIC_RELAXED);
+    random ^= random >> 16;
+    random *= 0x85ebca6bu;
+    random ^= random >> 13;
+    random *= 0xc2b2ae35u;
+    random ^= random >> 16;
+
+    int height = 1;
+    while (height < SKIP_LIST_MAX_HEIGHT && (random & 3) == 0)
+    {
+        ++height;
+        random >>= 2;
+    }
+    return height;
+}
+
+static bool findPosition(SkipList list, MapKeyElement key, SkipNode* predecessors, SkipNode* successors)
+{
+    while (!tryFindPosition(list, key, predecessors, successors))
+    {
+    }
+    return successors[0] != NULL && list->compareElements(successors[0]->key, key) == 0;
+}
+
+static bool tryFindPosition(SkipList list, MapKeyElement key, SkipNode* predecessors, SkipNode* successors)
+{
+    SkipNode node = list->head;
+    for (int level = SKIP_LIST_MAX_HEIGHT - 1; level >= 0; --level)
+    {
+        SkipNode next = withoutMark(loadNext(node, level));
+        while (next != NULL)
+        {
+            SkipNode after = loadNext(next, level);
+            if (isMarked(after))
+            {
+                //A removal marked next on this level: unlink it there. If node itself is being
+                //unlinked meanwhile, its pointer is marked too, and the search starts over.
+                if (!compareAndSwapNext(node, level, next, withoutMark(after)))
+                {
+                    return false;
+                }
+                next = withoutMark(after);
+                continue;
+            }
+            if (list->compareElements(next->key, key) >= 0)
+            {
+                break;
+            }
+            node = next;
+            next = after;
+        }
+        predecessors[level] = node;
+        successors[level] = next;
+    }
+    return true;
+}
+
+static SkipNode findNode(SkipList list, MapKeyElement key, bool inclusive)
+{
+    SkipNode node = list->head, next = NULL;
+    for (int level = SKIP_LIST_MAX_HEIGHT - 1; level >= 0; --level)
+    {
+        next = withoutMark(loadNext(node, level));
+        while (next != NULL)
+        {
+            SkipNode after = loadNext(next, level);
+            if (isMarked(after))
+            {
+                next = withoutMark(after);
+                continue;
+            }
+            int comparison = list->compareElements(next->key, key);
+            if (comparison > 0 || (comparison == 0 && inclusive))
+            {
+                break;
+            }
+            node = next;
+            next = after;
+        }
+    }
+    //Not loaded again: a key put since would be returned in place of the one compared above.
+    return next;
+}
+
+static SkipNode skipRemoved(SkipNode node)
+{
+    while (node != NULL && isMarked(loadData(node)))
+    {
+        node = withoutMark(loadNext(node, 0));
+    }
+    return node;
+}
+
+static MapDataElement lookUp(SkipList list, MapKeyElement key)
+{
+    SkipNode node = findNode(list, key, true);
+    if (node == NULL || list->compareElements(node->key, key) != 0)
+    {
+        return NULL;
+    }
+    MapDataElement data = loadData(node);
+    return isMarked(data) ? NULL : data;
+}
+
+static void linkUpperLevels(SkipList list, SkipNode node, SkipNode* predecessors, SkipNode* successors)
+{
+    for (int level = 1; level < node->height && !isMarked(loadData(node)); ++level)
+    {
+        while (true)
+        {
+            SkipNode next = loadNext(node, level);
+            if (isMarked(next))
+            {
+                break;
+            }
+            //Pointed at the current successor first, so the node never skips a key on this level.
+            if (next != successors[level] && !compareAndSwapNext(node, level, next, successors[level]))
+            {
+                continue;
+            }
+            if (compareAndSwapNext(predecessors[level], level, successors[level], node))
+            {
+                break;
+            }
+            findPosition(list, node->key, predecessors, successors);
+            if (successors[0] != node)
+            {
+                //Already unlinked from the bottom level by its removal.
+                break;
+            }
+        }
+        if (isMarked(loadNext(node, level)))
+        {
+            break;
+        }
+    }
+
+    //A removal which marked the node before its last level was linked may not have unlinked it there.
+    if (isMarked(loadData(node)))
+    {
+        findPosition(list, node->key, predecessors, successors);
+    }
+    releaseNode(list, node);
+}
+
+static void markLevels(SkipNode node)
+{
+    for (int level = node->height - 1; level >= 0; --level)
+    {
+        SkipNode next = loadNext(node, level);
+        while (!isMarked(next) && !compareAndSwapNext(node, level, next, withMark(next)))
+        {
+            next = loadNext(node, level);
+        }
+    }
+}
+
+static bool removeNode(SkipList list, SkipNode node)
+{
+    MapDataElement data = loadData(node);
+    while (!isMarked(data))
+    {
+        if (__atomic_compare_exchange_n(&node->data, &data, withMark(data), false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            SkipNode predecessors[SKIP_LIST_MAX_HEIGHT];
+            SkipNode successors[SKIP_LIST_MAX_HEIGHT];
+            __atomic_sub_fetch(&list->size, 1, __ATOMIC_RELAXED);
+            markLevels(node);
+            //The search unlinks marked nodes on every level it passes, which includes the node's.
+            findPosition(list, node->key, predecessors, successors);
+            releaseNode(list, node);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void releaseNode(SkipList list, SkipNode node)
+{
+    if (__atomic_sub_fetch(&node->owners, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        retireNode(list, node);
+    }
+}
+
+static void retireNode(SkipList list, SkipNode node)
+{
+    node->retired_epoch = epochCurrent();
+    node->retired_next = __atomic_load_n(&list->retired_nodes, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&list->retired_nodes, &node->retired_next, node, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static void retireData(SkipList list, RetiredData retired)
+{
+    retired->epoch = epochCurrent();
+    retired->next = __atomic_load_n(&list->retired_data, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&list->retired_data, &retired->next, retired, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static void reclaim(SkipList list)
+{
+    if (__atomic_load_n(&list->retired_nodes, __ATOMIC_RELAXED) == NULL &&
+        __atomic_load_n(&list->retired_data, __ATOMIC_RELAXED) == NULL)
+    {
+        return;
+    }
+
+    //What's still in use goes back on the stacks, after whatever was pushed meanwhile.
+    SkipNode nodes = __atomic_exchange_n(&list->retired_nodes, NULL, __ATOMIC_ACQUIRE);
+    SkipNode kept_nodes = NULL, kept_nodes_tail = NULL;
+    while (nodes != NULL)
+    {
+        SkipNode node = nodes;
+        nodes = node->retired_next;
+        if (epochIsSafe(node->retired_epoch))
+        {
+            list->freeKeyElement(node->key);
+            list->freeDataElement(withoutMark(node->data));
+            freeNode(node);
+            continue;
+        }
+        node->retired_next = kept_nodes;
+        kept_nodes = node;
+        if (kept_nodes_tail == NULL)
+        {
+            kept_nodes_tail = node;
+        }
+    }
+    if (kept_nodes != NULL)
+    {
+        kept_nodes_tail->retired_next = __atomic_load_n(&list->retired_nodes, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&list->retired_nodes, &kept_nodes_tail->retired_next,
+                                            kept_nodes, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    RetiredData data = __atomic_exchange_n(&list->retired_data, NULL, __ATOMIC_ACQUIRE);
+    RetiredData kept_data = NULL, kept_data_tail = NULL;
+    while (data != NULL)
+    {
+        RetiredData retired = data;
+        data = retired->next;
+        if (epochIsSafe(retired->epoch))
+        {
+            list->freeDataElement(retired->data);
+            trackedFree(MEMORY_MAPS, retired, sizeof(*retired));
+            continue;
+        }
+        retired->next = kept_data;
+        kept_data = retired;
+        if (kept_data_tail == NULL)
+        {
+            kept_data_tail = retired;
+        }
+    }
+    if (kept_data != NULL)
+    {
+        kept_data_tail->next = __atomic_load_n(&list->retired_data, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&list->retired_data, &kept_data_tail->next, kept_data,
+                                            false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+    }
+}
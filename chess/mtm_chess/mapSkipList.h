@@ -0,0 +1,28 @@
+#ifndef MAP_SKIP_LIST_H
+#define MAP_SKIP_LIST_H
+
+#include "mapEngine.h"
+
+/**
+* Skip-list engine behind the MAP_BACKEND_SKIP_LIST maps (see map.h and mapEngine.h).
+*
+* Every node is linked into the bottom list and, with probability 1/4 per level, into the lists
+* above it, so a search skips ahead on the upper levels and takes O(log n) expected.
+*
+* Nothing takes a lock. A put links its node into the bottom list with a compare-and-swap on the
+* predecessor's forward pointer, which is what makes the key visible, then into the lists above.
+* A removal first marks the node's data, which takes the key out of the map, then the lowest bit
+* of each of its forward pointers, so that nothing is linked after it; searches then unlink marked
+* nodes as they pass them. Removed nodes (and replaced data) are only freed once no other thread
+* can still be on them (see epoch.h). A clear removes the keys one by one.
+* Iterating is not safe while other threads remove keys.
+*
+* Replaced data is freed once no lookup can be returning it, but a pointer to it which get already
+* returned is left dangling; getCopy copies the data before leaving the critical section instead.
+* Unlike the other engines, put keeps the list's own key when it replaces data, since lookups may
+* be comparing against it.
+*/
+
+extern const MapEngine SKIP_LIST_ENGINE;
+
+#endif //MAP_SKIP_LIST_H
@@ -0,0 +1,67 @@
+#include "memoryStats.h"
+#include <stdbool.h>
+
+#ifdef CHESS_MEMORY_STATS
+
+static MemoryUsage usages[MEMORY_CATEGORY_COUNT];
+
+//Declaring static auxiliary functions:
+static void addLiveBytes(MemoryCategory category, long long bytes);
+
+void* trackedMalloc(MemoryCategory category, size_t size)
+{
+    void* pointer = malloc(size);
+    if (pointer != NULL)
+    {
+        __atomic_fetch_add(&usages[category].allocations, 1, __ATOMIC_RELAXED);
+        addLiveBytes(category, (long long)size);
+    }
+    return pointer;
+}
+
+void* trackedRealloc(MemoryCategory category, void* pointer, size_t old_size, size_t new_size)
+{
+    void* resized = realloc(pointer, new_size);
+    if (resized != NULL)
+    {
+        __atomic_fetch_add(&usages[category].allocations, 1, __ATOMIC_RELAXED);
+        addLiveBytes(category, (long long)new_size - (long long)old_size);
+    }
+    return resized;
+}
+
+void trackedFree(MemoryCategory category, void* pointer, size_t size)
+{
+    if (pointer == NULL)
+    {
+        return;
+    }
+    free(pointer);
+    addLiveBytes(category, -(long long)size);
+}
+
+MemoryUsage getMemoryUsage(MemoryCategory category)
+{
+    MemoryUsage usage;
+    usage.allocations = __atomic_load_n(&usages[category].allocations, __ATOMIC_RELAXED);
+    usage.live_bytes = __atomic_load_n(&usages[category].live_bytes, __ATOMIC_RELAXED);
+    usage.peak_bytes = __atomic_load_n(&usages[category].peak_bytes, __ATOMIC_RELAXED);
+    return usage;
+}
+
+
+//Static auxiliary functions:
+static void addLiveBytes(MemoryCategory category, long long bytes)
+{
+    long long live = __atomic_add_fetch(&usages[category].live_bytes, bytes, __ATOMIC_RELAXED);
+    long long peak = __atomic_load_n(&usages[category].peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak
+           && !__atomic_compare_exchange_n(&usages[category].peak_bytes, &peak, live, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+#else
+typedef int memory_stats_disabled; //ISO C forbids an empty translation unit.
+#endif
@@ -0,0 +1,53 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <stdlib.h>
+
+//Allocation accounting, compiled in with -DCHESS_MEMORY_STATS.
+//
+//Every allocation of the tracked objects goes through the tracked* functions below, which count
+//the allocations and the live bytes of their category. Without the flag they are plain
+//malloc/realloc/free, so the instrumentation costs nothing.
+//The counters are shared by the whole process and updated atomically.
+
+typedef enum {
+    MEMORY_MAP_NODES,
+    MEMORY_MAP_KEYS,
+    MEMORY_PLAYERS,
+    MEMORY_GAMES,
+    MEMORY_TOURNAMENTS,
+    MEMORY_LOCATIONS,
+    MEMORY_ARENAS, //The arenas of chess systems (see chessCreateWithArena), whatever they hold.
+    MEMORY_MAPS, //The maps' own structs, with those of their engines.
+    MEMORY_SYSTEMS, //The chess systems' own structs.
+    MEMORY_CATEGORY_COUNT
+} MemoryCategory;
+
+typedef struct MemoryUsage_t
+{
+    long long allocations; //Calls to trackedMalloc and trackedRealloc so far.
+    long long live_bytes;
+    long long peak_bytes;
+} MemoryUsage;
+
+#ifdef CHESS_MEMORY_STATS
+#define MEMORY_STATS_ENABLED 1
+
+void* trackedMalloc(MemoryCategory category, size_t size);
+//old_size is the size of the block being resized (0 for NULL).
+void* trackedRealloc(MemoryCategory category, void* pointer, size_t old_size, size_t new_size);
+//size is the size the block was allocated with.
+void trackedFree(MemoryCategory category, void* pointer, size_t size);
+
+MemoryUsage getMemoryUsage(MemoryCategory category);
+
+#else
+#define MEMORY_STATS_ENABLED 0
+
+#define trackedMalloc(category, size) malloc(size)
+#define trackedRealloc(category, pointer, old_size, new_size) realloc((pointer), (new_size))
+#define trackedFree(category, pointer, size) free(pointer)
+
+#endif
+
+#endif //MEMORY_STATS_H
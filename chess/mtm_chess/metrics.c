@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200112L //For pthreads and clock_gettime under -std=c99.
+
+#include "metrics.h"
+
+#ifdef CHESS_METRICS
+
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+//Latencies below 4ns get a bucket each; above, every power of two is split into 4 buckets.
+#define SUB_BUCKET_BITS 2
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define BUCKET_COUNT ((63 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+static const char* ENTRY_POINT_NAMES[METRICS_ENTRY_POINT_COUNT] = {
+    "chessCreate", "chessCreateWithArena", "chessDestroy", "chessSetWorkerCount", "chessAddTournament", "chessAddGame",
+    "chessRemoveTournament", "chessRemovePlayer", "chessEndTournament", "chessCalculateAveragePlayTime",
+    "chessSavePlayersLevels", "chessSaveTournamentStatistics", "chessGetLocationTournaments",
+    "chessGetLocationStatistics", "chessGetCommonPlayers", "chessGetMemoryStats"
+};
+
+//One entry point's counters.
+typedef struct EntryMetrics_t
+{
+    long long calls;
+    long long failures;
+    long long total_ns;
+    long long max_ns;
+    long long buckets[BUCKET_COUNT];
+} EntryMetrics;
+
+//A thread's counters. Only its thread writes them; the dump reads them concurrently, so every
+//access is atomic (relaxed: the counters are independent).
+typedef struct MetricsShard_t
+{
+    EntryMetrics entries[METRICS_ENTRY_POINT_COUNT];
+    struct MetricsShard_t* next;
+} *MetricsShard;
+
+static pthread_once_t shard_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t shard_key;
+//Shards are never freed: a thread's counts outlive it.
+static pthread_mutex_t shards_lock = PTHREAD_MUTEX_INITIALIZER;
+static MetricsShard shards = NULL;
+
+//Declaring static auxiliary functions:
+static void createShardKey(void);
+static MetricsShard getShard(void);
+static int bucketOf(long long latency);
+static long long bucketUpperBound(int bucket);
+static void increase(long long* counter, long long value);
+static long long percentile(const long long* buckets, long long calls, double fraction);
+
+long long metricsStart(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+void metricsRecord(MetricsEntryPoint entry_point, long long start, bool failed)
+{
+    long long latency = metricsStart() - start;
+    MetricsShard shard = getShard();
+    if (shard == NULL)
+    {
+        return;
+    }
+
+    EntryMetrics* metrics = &shard->entries[entry_point];
+    increase(&metrics->calls, 1);
+    increase(&metrics->failures, failed);
+    increase(&metrics->total_ns, latency);
+    increase(&metrics->buckets[bucketOf(latency)], 1);
+    if (latency > __atomic_load_n(&metrics->max_ns, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&metrics->max_ns, latency, __ATOMIC_RELAXED);
+    }
+}
+
+bool metricsDump(FILE* file)
+{
+    EntryMetrics* sums = calloc(METRICS_ENTRY_POINT_COUNT, sizeof(*sums));
+    if (sums == NULL)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&shards_lock);
+    for (MetricsShard shard = shards; shard != NULL; shard = shard->next)
+    {
+        for (int entry_point = 0; entry_point < METRICS_ENTRY_POINT_COUNT; ++entry_point)
+        {
+            EntryMetrics* metrics = &shard->entries[entry_point];
+            EntryMetrics* sum = &sums[entry_point];
+            sum->calls += __atomic_load_n(&metrics->calls, __ATOMIC_RELAXED);
+            sum->failures += __atomic_load_n(&metrics->failures, __ATOMIC_RELAXED);
+            sum->total_ns += __atomic_load_n(&metrics->total_ns, __ATOMIC_RELAXED);
+            long long max_ns = __atomic_load_n(&metrics->max_ns, __ATOMIC_RELAXED);
+            sum->max_ns = max_ns > sum->max_ns ? max_ns : sum->max_ns;
+            for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+            {
+                sum->buckets[bucket] += __atomic_load_n(&metrics->buckets[bucket], __ATOMIC_RELAXED);
+            }
+        }
+    }
+    pthread_mutex_unlock(&shards_lock);
+
+    bool success = true;
+    for (int entry_point = 0; entry_point < METRICS_ENTRY_POINT_COUNT && success; ++entry_point)
+    {
+        EntryMetrics* sum = &sums[entry_point];
+        //The buckets were read after the calls, so they may count a few more calls.
+        long long calls = 0;
+        for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            calls += sum->buckets[bucket];
+        }
+        success = fprintf(file, "api=%s calls=%lld failures=%lld total_ns=%lld mean_ns=%lld p50_ns=%lld "
+                                "p90_ns=%lld p99_ns=%lld p999_ns=%lld max_ns=%lld\n",
+                          ENTRY_POINT_NAMES[entry_point], sum->calls, sum->failures, sum->total_ns,
+                          sum->calls == 0 ? 0 : sum->total_ns / sum->calls,
+                          percentile(sum->buckets, calls, 0.5), percentile(sum->buckets, calls, 0.9),
+                          percentile(sum->buckets, calls, 0.99), percentile(sum->buckets, calls, 0.999),
+                          sum->max_ns) >= 0;
+    }
+
+    free(sums);
+    return success;
+}
+
+
+//Static auxiliary functions:
+static void createShardKey(void)
+{
+    pthread_key_create(&shard_key, NULL);
+}
+
+static MetricsShard getShard(void)
+{
+    pthread_once(&shard_key_once, &createShardKey);
+    MetricsShard shard = pthread_getspecific(shard_key);
+    if (shard != NULL)
+    {
+        return shard;
+    }
+
+    shard = calloc(1, sizeof(*shard));
+    if (shard == NULL || pthread_setspecific(shard_key, shard) != 0)
+    {
+        free(shard);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&shards_lock);
+    shard->next = shards;
+    shards = shard;
+    pthread_mutex_unlock(&shards_lock);
+    return shard;
+}
+
+static int bucketOf(long long latency)
+{
+    if (latency < SUB_BUCKETS)
+    {
+        return latency < 0 ? 0 : (int)latency;
+    }
+
+    int magnitude = 63 - __builtin_clzll((unsigned long long)latency);
+    int sub_bucket = (int)((latency >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+static long long bucketUpperBound(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    int magnitude = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    long long sub_bucket = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << (magnitude - SUB_BUCKET_BITS)) - 1;
+}
+
+//The only writer is the shard's thread, so a load and a store make an atomic increase.
+static void increase(long long* counter, long long value)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+static long long percentile(const long long* buckets, long long calls, double fraction)
+{
+    long long rank = (long long)(fraction * calls), seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen > rank)
+        {
+            return bucketUpperBound(bucket);
+        }
+    }
+    return 0;
+}
+
+#else
+typedef int metrics_disabled; //ISO C forbids an empty translation unit.
+#endif
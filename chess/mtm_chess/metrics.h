@@ -0,0 +1,54 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+//Call counters and latency histograms of the public chess API, compiled in with -DCHESS_METRICS.
+//
+//Each thread records into its own shard, so recording takes no lock and shares no cache line;
+//the shards are only summed when the metrics are dumped. Latencies go into log-scale buckets,
+//four per power of two (HDR-style), so percentiles are exact to within 25%.
+//Without the flag metricsStart and metricsRecord expand to nothing.
+
+typedef enum {
+    METRICS_CHESS_CREATE,
+    METRICS_CHESS_CREATE_WITH_ARENA,
+    METRICS_CHESS_DESTROY,
+    METRICS_CHESS_SET_WORKER_COUNT,
+    METRICS_CHESS_ADD_TOURNAMENT,
+    METRICS_CHESS_ADD_GAME,
+    METRICS_CHESS_REMOVE_TOURNAMENT,
+    METRICS_CHESS_REMOVE_PLAYER,
+    METRICS_CHESS_END_TOURNAMENT,
+    METRICS_CHESS_CALCULATE_AVERAGE_PLAY_TIME,
+    METRICS_CHESS_SAVE_PLAYERS_LEVELS,
+    METRICS_CHESS_SAVE_TOURNAMENT_STATISTICS,
+    METRICS_CHESS_GET_LOCATION_TOURNAMENTS,
+    METRICS_CHESS_GET_LOCATION_STATISTICS,
+    METRICS_CHESS_GET_COMMON_PLAYERS,
+    METRICS_CHESS_GET_MEMORY_STATS,
+    METRICS_ENTRY_POINT_COUNT
+} MetricsEntryPoint;
+
+#ifdef CHESS_METRICS
+#define METRICS_ENABLED 1
+
+//Returns the current time, to be passed to metricsRecord once the call returns.
+long long metricsStart(void);
+//Records a call of the entry point which started at the given time.
+void metricsRecord(MetricsEntryPoint entry_point, long long start, bool failed);
+//Prints one line per entry point:
+//api=<name> calls=<n> failures=<n> total_ns=<t> mean_ns=<t> p50_ns=<t> p90_ns=<t> p99_ns=<t> p999_ns=<t> max_ns=<t>
+//Returns false if writing failed.
+bool metricsDump(FILE* file);
+
+#else
+#define METRICS_ENABLED 0
+
+#define metricsStart() 0
+#define metricsRecord(entry_point, start, failed) ((void)(start))
+
+#endif
+
+#endif //METRICS_H
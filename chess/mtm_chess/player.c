@@ -1,70 +1,184 @@
 #include "player.h"
+#include "memoryStats.h"
+#include <string.h>
+#include <stdint.h>
+
+#define INITIAL_CAPACITY 16
 
 struct Player_t
 {
-    int player_id;
     int wins;
     int losses;
     int draws;
 
+    //Cached by getPlayerLevel. Every change of the results above marks it dirty.
+    double level;
+    bool level_dirty;
+    bool present; //Whether the player is in the system.
 };
 
+typedef struct PlayerSlot_t
+{
+    int player_id; //0 for an empty slot.
+    int player_index;
+} PlayerSlot;
+
+//Declaring static auxiliary functions:
+static void resetPlayer(Player player);
+//Grows the players and ids arrays, and the slots along with them. Returns false if an allocation failed.
+static bool growPlayerTable(PlayerTable* table);
+//Returns the id's first slot in probing order: the high bits of the id times 2^32 / phi (Fibonacci
+//hashing), which depend on all of the id's bits, unlike the low ones.
+static unsigned int playerSlot(int player_id, int slot_capacity);
+//Returns the first empty slot in the id's probing order.
+static PlayerSlot* claimPlayerSlot(PlayerSlot* slots, int slot_capacity, int player_id);
+
 //Construction & destruction:
-Player createPlayer(int player_id)
+void initPlayerTable(PlayerTable* table)
+{
+    table->players = NULL;
+    table->ids = NULL;
+    table->index_bound = NO_PLAYER_INDEX + 1;
+    table->capacity = 0;
+    table->size = 0;
+    table->slots = NULL;
+    table->slot_capacity = 0;
+}
+
+void freePlayerTable(PlayerTable* table)
+{
+    trackedFree(MEMORY_PLAYERS, table->players, sizeof(*(table->players)) * table->capacity);
+    trackedFree(MEMORY_PLAYERS, table->ids, sizeof(*(table->ids)) * table->capacity);
+    trackedFree(MEMORY_PLAYERS, table->slots, sizeof(*(table->slots)) * table->slot_capacity);
+    initPlayerTable(table);
+}
+
+//Index lookups:
+int findPlayerIndex(const PlayerTable* table, int player_id)
 {
-    Player player = malloc(sizeof(*player));
-    if (player == NULL)
+    if (table->slot_capacity == 0 || player_id <= 0)
     {
-        return NULL;
+        return NO_PLAYER_INDEX;
     }
 
-    player->player_id = player_id;
-    player->wins = 0;
-    player->losses = 0;
-    player->draws = 0;
+    unsigned int mask = (unsigned int)(table->slot_capacity - 1);
+    for (unsigned int slot = playerSlot(player_id, table->slot_capacity); table->slots[slot].player_id != 0;
+         slot = (slot + 1) & mask)
+    {
+        if (table->slots[slot].player_id == player_id)
+        {
+            return table->slots[slot].player_index;
+        }
+    }
+    return NO_PLAYER_INDEX;
+}
 
-    return player;
+int addPlayerIndex(PlayerTable* table, int player_id)
+{
+    assert(player_id > 0);
+    int player_index = findPlayerIndex(table, player_id);
+    if (player_index != NO_PLAYER_INDEX)
+    {
+        return player_index;
+    }
+
+    if (table->index_bound >= table->capacity && !growPlayerTable(table))
+    {
+        return NO_PLAYER_INDEX;
+    }
+
+    player_index = table->index_bound++;
+    table->ids[player_index] = player_id;
+    resetPlayer(&table->players[player_index]);
+
+    PlayerSlot* slot = claimPlayerSlot(table->slots, table->slot_capacity, player_id);
+    slot->player_id = player_id;
+    slot->player_index = player_index;
+    return player_index;
 }
 
-void freePlayer(Player player)
+int getIndexedPlayerId(const PlayerTable* table, int player_index)
 {
-    free(player); //As promised :)
+    assert(player_index > NO_PLAYER_INDEX && player_index < table->index_bound);
+    return table->ids[player_index];
 }
 
+int getPlayerIndexBound(const PlayerTable* table)
+{
+    return table->index_bound;
+}
 
+int getPlayerTableSize(const PlayerTable* table)
+{
+    return table->size;
+}
 
-//Getters & Setters:
-int getWins(Player player)
+Player getPlayerAt(PlayerTable* table, int player_index)
 {
-    assert(player != NULL);
-    if (player == NULL)
+    if (player_index <= NO_PLAYER_INDEX || player_index >= table->index_bound
+        || !table->players[player_index].present)
+    {
+        return NULL;
+    }
+    return &table->players[player_index];
+}
+
+Player enterPlayer(PlayerTable* table, int player_index)
+{
+    assert(player_index > NO_PLAYER_INDEX && player_index < table->index_bound);
+    Player player = &table->players[player_index];
+    if (!player->present)
     {
-        return ILLEGAL_PLAYER;
+        player->present = true;
+        ++table->size;
     }
+    return player;
+}
+
+void removePlayer(PlayerTable* table, int player_index)
+{
+    Player player = getPlayerAt(table, player_index);
+    assert(player != NULL);
+    resetPlayer(player);
+    --table->size;
+}
 
+//Getters & Setters:
+int getWins(Player player)
+{
+    assert(player != NULL);
     return player->wins;
 }
 
 int getLosses(Player player)
 {
     assert(player != NULL);
-    if (player == NULL)
-    {
-        return ILLEGAL_PLAYER;
-    }
-
     return player->losses;
 }
 
 int getDraws(Player player)
 {
     assert(player != NULL);
-    if (player == NULL)
+    return player->draws;
+}
+
+double getPlayerLevel(Player player)
+{
+    assert(player != NULL);
+    if (player->level_dirty)
     {
-        return ILLEGAL_PLAYER;
+        int games = player->wins + player->losses + player->draws;
+        player->level = ((double)(6*player->wins - 10*player->losses + 2*player->draws) / games);
+        player->level_dirty = false;
     }
 
-    return player->draws;
+    return player->level;
+}
+
+bool isPlayerLevelDirty(Player player)
+{
+    assert(player != NULL);
+    return player->level_dirty;
 }
 
 //additional functions:
@@ -74,6 +188,7 @@ void increaseWins(Player player)
     if (player != NULL)
     {
         ++(player->wins);
+        player->level_dirty = true;
     }
 }
 
@@ -83,6 +198,7 @@ void increaseDraws(Player player)
     if (player != NULL)
     {
         ++(player->draws);
+        player->level_dirty = true;
     }
 }
 
@@ -92,6 +208,7 @@ void increaseLosses(Player player)
     if (player != NULL)
     {
         ++(player->losses);
+        player->level_dirty = true;
     }
 }
 
@@ -101,6 +218,7 @@ void decreaseWins(Player player)
     if (player != NULL && (player->wins-1) >= 0)
     {
         --(player->wins);
+        player->level_dirty = true;
     }
 }
 
@@ -110,6 +228,7 @@ void decreaseDraws(Player player)
     if (player != NULL && (player->draws-1) >= 0)
     {
         --(player->draws);
+        player->level_dirty = true;
     }
 }
 
@@ -119,63 +238,92 @@ void decreaseLosses(Player player)
     if (player != NULL && (player->losses-1) >= 0)
     {
         --(player->losses);
+        player->level_dirty = true;
     }
 }
 
-Player copyPlayer(Player player)
+void subtractPlayerStatistics(Player player, int wins, int losses, int draws)
 {
-    if(!player)
-    {
-        return NULL;
-    }
-
-    Player copy = malloc(sizeof(*copy));
-    if(copy==NULL)
+    assert(player != NULL);
+    if (player != NULL)
     {
-        return NULL;
+        player->wins = player->wins > wins ? player->wins - wins : 0;
+        player->losses = player->losses > losses ? player->losses - losses : 0;
+        player->draws = player->draws > draws ? player->draws - draws : 0;
+        player->level_dirty = true;
     }
-    copy->player_id = player->player_id;
-    copy->wins = player->wins;
-    copy->losses = player->losses;
-    copy->draws = player->draws;
-
-    return copy;
 }
 
-int playerScore(Player player)
-{
-    return ((2 * player->wins) + player->draws);
-}
 
-//Map-related functions:
-MapDataElement mapPlayerCopy(MapDataElement player)
+//Static auxiliary functions:
+static void resetPlayer(Player player)
 {
-    return copyPlayer((Player)player);
+    player->wins = 0;
+    player->losses = 0;
+    player->draws = 0;
+    player->level = 0;
+    player->level_dirty = true;
+    player->present = false;
 }
 
-MapKeyElement mapPlayerIdCopy(MapKeyElement id)
+static bool growPlayerTable(PlayerTable* table)
 {
-    int *new = malloc(sizeof(int));
-    if (new == NULL)
+    int capacity = table->capacity == 0 ? INITIAL_CAPACITY : 2 * table->capacity;
+    int slot_capacity = 2 * capacity;
+
+    struct Player_t* players = trackedMalloc(MEMORY_PLAYERS, sizeof(*players) * capacity);
+    int* ids = trackedMalloc(MEMORY_PLAYERS, sizeof(*ids) * capacity);
+    PlayerSlot* slots = trackedMalloc(MEMORY_PLAYERS, sizeof(*slots) * slot_capacity);
+    if (players == NULL || ids == NULL || slots == NULL)
     {
-        return NULL;
+        trackedFree(MEMORY_PLAYERS, players, sizeof(*players) * capacity);
+        trackedFree(MEMORY_PLAYERS, ids, sizeof(*ids) * capacity);
+        trackedFree(MEMORY_PLAYERS, slots, sizeof(*slots) * slot_capacity);
+        return false;
     }
-    *new = *((int*)id);
-    return new;
-}
 
-void mapPlayerDataFree(MapDataElement player)
-{
-    freePlayer((Player)player);
+    if (table->capacity > 0)
+    {
+        memcpy(players, table->players, sizeof(*players) * table->index_bound);
+        memcpy(ids, table->ids, sizeof(*ids) * table->index_bound);
+    }
+    memset(slots, 0, sizeof(*slots) * slot_capacity);
+    for (int slot = 0; slot < table->slot_capacity; ++slot)
+    {
+        if (table->slots[slot].player_id != 0)
+        {
+            *claimPlayerSlot(slots, slot_capacity, table->slots[slot].player_id) = table->slots[slot];
+        }
+    }
+
+    trackedFree(MEMORY_PLAYERS, table->players, sizeof(*players) * table->capacity);
+    trackedFree(MEMORY_PLAYERS, table->ids, sizeof(*ids) * table->capacity);
+    trackedFree(MEMORY_PLAYERS, table->slots, sizeof(*slots) * table->slot_capacity);
+    table->players = players;
+    table->ids = ids;
+    table->slots = slots;
+    table->capacity = capacity;
+    table->slot_capacity = slot_capacity;
+    return true;
 }
 
-void mapPlayerIdFree(MapKeyElement id)
+static unsigned int playerSlot(int player_id, int slot_capacity)
 {
-    free((int*)id);
+    assert(slot_capacity > 1);
+    int shift = 32;
+    for (int size = slot_capacity; size > 1; size >>= 1)
+    {
+        --shift;
+    }
+    return (unsigned int)(((uint32_t)player_id * UINT32_C(2654435761)) >> shift);
 }
 
-int mapPlayerKeyCompare(MapKeyElement id1, MapKeyElement id2)
+static PlayerSlot* claimPlayerSlot(PlayerSlot* slots, int slot_capacity, int player_id)
 {
-    return (*((int*)id1) - *((int*)id2));
+    unsigned int slot = playerSlot(player_id, slot_capacity);
+    while (slots[slot].player_id != 0)
+    {
+        slot = (slot + 1) & (unsigned int)(slot_capacity - 1);
+    }
+    return &slots[slot];
 }
-
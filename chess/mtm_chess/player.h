@@ -2,21 +2,63 @@
 #define PLAYER_H
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
-#include "map.h"
-#define ILLEGAL_PLAYER (-1)
+//Internal player indices start at 1; this one stands for no player.
+#define NO_PLAYER_INDEX 0
 
 //Type to expose:
 typedef struct Player_t *Player;
 
+//The system's players, stored densely. Every player id the system meets is given the next internal
+//index, which it keeps for the system's lifetime (even once the player is removed), so the games can
+//store indices instead of ids. The players' results live in one array indexed by them, and whole-table
+//passes are plain scans of the indices [1, getPlayerIndexBound).
+typedef struct PlayerTable_t
+{
+    struct Player_t* players; //players[index]; players[NO_PLAYER_INDEX] is unused.
+    int* ids;                 //ids[index] is the player id the index was given to.
+    int index_bound;          //Indices given so far, plus one.
+    int capacity;             //Of both arrays.
+    int size;                 //Players in the system: with games, and not removed.
+
+    //Open addressing from ids to indices, with linear probing, at most half full.
+    struct PlayerSlot_t* slots;
+    int slot_capacity; //A power of two, or 0 before the first index is given.
+} PlayerTable;
+
 //Construction & destruction:
-Player createPlayer(int player_id);
-void freePlayer(Player player);
+//The table allocates nothing until the first index is given.
+void initPlayerTable(PlayerTable* table);
+void freePlayerTable(PlayerTable* table);
+
+//Index lookups:
+//Returns the index of the given id, or NO_PLAYER_INDEX if the id never got one.
+int findPlayerIndex(const PlayerTable* table, int player_id);
+//Same, giving the id the next index if it has none. Returns NO_PLAYER_INDEX if an allocation failed.
+//Giving an index may move the players, so it invalidates every Player taken from the table.
+int addPlayerIndex(PlayerTable* table, int player_id);
+int getIndexedPlayerId(const PlayerTable* table, int player_index);
+int getPlayerIndexBound(const PlayerTable* table);
+int getPlayerTableSize(const PlayerTable* table);
+
+//Returns the player of the given index, or NULL if it isn't in the system (it has no games, or it
+//was removed).
+Player getPlayerAt(PlayerTable* table, int player_index);
+//Returns the player of the given index, putting it in the system without games if it isn't there.
+Player enterPlayer(PlayerTable* table, int player_index);
+//Takes the player out of the system, forgetting its results. Its index stays its id's.
+void removePlayer(PlayerTable* table, int player_index);
 
 //Getters & setters:
 int getWins(Player player);
 int getLosses(Player player);
 int getDraws(Player player);
+//(6*wins - 10*losses + 2*draws) / games, nan for a player without games.
+//Computed on the first call after the results changed and cached until they change again.
+double getPlayerLevel(Player player);
+//Whether the results changed since getPlayerLevel last computed the level.
+bool isPlayerLevelDirty(Player player);
 
 //additional functions:
 void increaseWins(Player player);
@@ -25,15 +67,8 @@ void increaseDraws(Player player);
 void decreaseWins(Player player);
 void decreaseLosses(Player player);
 void decreaseDraws(Player player);
-Player copyPlayer(Player player);
-int playerScore(Player player);
-
-//Map-related functions:
-MapDataElement mapPlayerCopy(MapDataElement player);
-MapKeyElement mapPlayerIdCopy(MapKeyElement id);
-void mapPlayerDataFree(MapDataElement player);
-void mapPlayerIdFree(MapKeyElement id);
-int mapPlayerKeyCompare(MapKeyElement id1, MapKeyElement id2);
+//Takes back several results at once. Like the decrease functions, no count goes below 0.
+void subtractPlayerStatistics(Player player, int wins, int losses, int draws);
 
 
-#endif //PLAYER_H
\ No newline at end of file
+#endif //PLAYER_H
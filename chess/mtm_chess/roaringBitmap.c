@@ -0,0 +1,448 @@
+#include "roaringBitmap.h"
+#include "memoryStats.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BITSET_WORDS (65536 / 64)
+#define INITIAL_ARRAY_CAPACITY 4
+#define INITIAL_CONTAINER_CAPACITY 4
+
+typedef struct BitmapContainer_t
+{
+    uint16_t key; //The high 16 bits of the container's values.
+    int cardinality;
+    //An array container keeps the low 16 bits of its values sorted in values, with room for
+    //capacity of them. A bitset container has words instead (values is then NULL), with bit i
+    //set for the value whose low bits are i.
+    uint16_t* values;
+    int capacity;
+    uint64_t* words;
+} BitmapContainer;
+
+//Declaring static auxiliary functions:
+static void* allocate(RoaringBitmap* bitmap, size_t size);
+static void release(RoaringBitmap* bitmap, void* pointer, size_t size);
+static void releaseContainer(RoaringBitmap* bitmap, BitmapContainer* container);
+//Returns the position of the first container whose key is not smaller than the given one, and sets
+//found to whether its key is the given one.
+static int findContainer(const RoaringBitmap* bitmap, uint16_t key, bool* found);
+//Returns the first position of the sorted array whose value is not smaller than the given one.
+static int lowerBound(const uint16_t* values, int count, uint16_t low);
+//Inserts an empty array container at the given position. Returns NULL if an allocation failed.
+static BitmapContainer* insertContainer(RoaringBitmap* bitmap, int position, uint16_t key);
+static void removeContainer(RoaringBitmap* bitmap, int position);
+//Both return false, leaving the container as it was, if an allocation failed.
+static bool growArray(RoaringBitmap* bitmap, BitmapContainer* container);
+static bool convertToBitset(RoaringBitmap* bitmap, BitmapContainer* container);
+static bool testBit(const uint64_t* words, uint16_t low);
+//Counts the values in both containers, which have the same key. Unless values is NULL, they are
+//also put in it in ascending order.
+static int intersectContainers(const BitmapContainer* container1, const BitmapContainer* container2,
+                               int* values);
+//Same for every pair of containers with equal keys.
+static int intersectBitmaps(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2, int* values);
+
+//Construction & destruction:
+void bitmapInit(RoaringBitmap* bitmap, Arena arena)
+{
+    bitmap->containers = NULL;
+    bitmap->container_count = 0;
+    bitmap->container_capacity = 0;
+    bitmap->cardinality = 0;
+    bitmap->arena = arena;
+}
+
+void bitmapFree(RoaringBitmap* bitmap)
+{
+    for (int position = 0; position < bitmap->container_count; ++position)
+    {
+        releaseContainer(bitmap, &bitmap->containers[position]);
+    }
+    release(bitmap, bitmap->containers, sizeof(*(bitmap->containers)) * bitmap->container_capacity);
+    bitmapInit(bitmap, bitmap->arena);
+}
+
+bool bitmapAdd(RoaringBitmap* bitmap, int value)
+{
+    assert(value >= 0);
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)(value & 0xFFFF);
+    bool found;
+    int position = findContainer(bitmap, key, &found);
+    BitmapContainer* container = found ? &bitmap->containers[position] : insertContainer(bitmap, position, key);
+    if (container == NULL)
+    {
+        return false;
+    }
+
+    if (container->words == NULL)
+    {
+        int slot = lowerBound(container->values, container->cardinality, low);
+        if (slot < container->cardinality && container->values[slot] == low)
+        {
+            return true;
+        }
+
+        if (container->cardinality < BITMAP_ARRAY_MAX_SIZE)
+        {
+            if (container->cardinality == container->capacity && !growArray(bitmap, container))
+            {
+                return false;
+            }
+            memmove(container->values + slot + 1, container->values + slot,
+                    sizeof(*(container->values)) * (container->cardinality - slot));
+            container->values[slot] = low;
+            ++container->cardinality;
+            ++bitmap->cardinality;
+            return true;
+        }
+
+        if (!convertToBitset(bitmap, container))
+        {
+            return false;
+        }
+    }
+
+    if (!testBit(container->words, low))
+    {
+        container->words[low / 64] |= (uint64_t)1 << (low % 64);
+        ++container->cardinality;
+        ++bitmap->cardinality;
+    }
+    return true;
+}
+
+void bitmapRemove(RoaringBitmap* bitmap, int value)
+{
+    assert(value >= 0);
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)(value & 0xFFFF);
+    bool found;
+    int position = findContainer(bitmap, key, &found);
+    if (!found)
+    {
+        return;
+    }
+
+    BitmapContainer* container = &bitmap->containers[position];
+    if (container->words == NULL)
+    {
+        int slot = lowerBound(container->values, container->cardinality, low);
+        if (slot == container->cardinality || container->values[slot] != low)
+        {
+            return;
+        }
+        memmove(container->values + slot, container->values + slot + 1,
+                sizeof(*(container->values)) * (container->cardinality - slot - 1));
+    }
+    else
+    {
+        if (!testBit(container->words, low))
+        {
+            return;
+        }
+        container->words[low / 64] &= ~((uint64_t)1 << (low % 64));
+    }
+
+    --bitmap->cardinality;
+    if (--container->cardinality == 0)
+    {
+        removeContainer(bitmap, position);
+    }
+}
+
+bool bitmapContains(const RoaringBitmap* bitmap, int value)
+{
+    if (value < 0)
+    {
+        return false;
+    }
+
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)(value & 0xFFFF);
+    bool found;
+    int position = findContainer(bitmap, key, &found);
+    if (!found)
+    {
+        return false;
+    }
+
+    const BitmapContainer* container = &bitmap->containers[position];
+    if (container->words != NULL)
+    {
+        return testBit(container->words, low);
+    }
+    int slot = lowerBound(container->values, container->cardinality, low);
+    return slot < container->cardinality && container->values[slot] == low;
+}
+
+int bitmapGetCardinality(const RoaringBitmap* bitmap)
+{
+    return bitmap->cardinality;
+}
+
+int bitmapIntersectionCardinality(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2)
+{
+    return intersectBitmaps(bitmap1, bitmap2, NULL);
+}
+
+int bitmapIntersect(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2, int* values)
+{
+    return intersectBitmaps(bitmap1, bitmap2, values);
+}
+
+
+//Static auxiliary functions:
+static void* allocate(RoaringBitmap* bitmap, size_t size)
+{
+    if (bitmap->arena == NULL)
+    {
+        return trackedMalloc(MEMORY_PLAYERS, size);
+    }
+    return arenaAllocate(bitmap->arena, size);
+}
+
+static void release(RoaringBitmap* bitmap, void* pointer, size_t size)
+{
+    if (bitmap->arena == NULL)
+    {
+        trackedFree(MEMORY_PLAYERS, pointer, size);
+    }
+    else
+    {
+        arenaRelease(bitmap->arena, pointer, size);
+    }
+}
+
+static void releaseContainer(RoaringBitmap* bitmap, BitmapContainer* container)
+{
+    if (container->words != NULL)
+    {
+        release(bitmap, container->words, sizeof(*(container->words)) * BITSET_WORDS);
+    }
+    else
+    {
+        release(bitmap, container->values, sizeof(*(container->values)) * container->capacity);
+    }
+}
+
+static int findContainer(const RoaringBitmap* bitmap, uint16_t key, bool* found)
+{
+    int low = 0, high = bitmap->container_count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (bitmap->containers[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    *found = low < bitmap->container_count && bitmap->containers[low].key == key;
+    return low;
+}
+
+static int lowerBound(const uint16_t* values, int count, uint16_t low)
+{
+    int begin = 0, end = count;
+    while (begin < end)
+    {
+        int middle = begin + (end - begin) / 2;
+        if (values[middle] < low)
+        {
+            begin = middle + 1;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+static BitmapContainer* insertContainer(RoaringBitmap* bitmap, int position, uint16_t key)
+{
+    uint16_t* values = allocate(bitmap, sizeof(*values) * INITIAL_ARRAY_CAPACITY);
+    if (values == NULL)
+    {
+        return NULL;
+    }
+
+    if (bitmap->container_count == bitmap->container_capacity)
+    {
+        int capacity = bitmap->container_capacity == 0 ? INITIAL_CONTAINER_CAPACITY
+                                                       : 2 * bitmap->container_capacity;
+        BitmapContainer* containers = allocate(bitmap, sizeof(*containers) * capacity);
+        if (containers == NULL)
+        {
+            release(bitmap, values, sizeof(*values) * INITIAL_ARRAY_CAPACITY);
+            return NULL;
+        }
+        if (bitmap->container_count > 0)
+        {
+            memcpy(containers, bitmap->containers, sizeof(*containers) * bitmap->container_count);
+        }
+        release(bitmap, bitmap->containers, sizeof(*containers) * bitmap->container_capacity);
+        bitmap->containers = containers;
+        bitmap->container_capacity = capacity;
+    }
+
+    BitmapContainer* container = &bitmap->containers[position];
+    memmove(container + 1, container, sizeof(*container) * (bitmap->container_count - position));
+    ++bitmap->container_count;
+
+    container->key = key;
+    container->cardinality = 0;
+    container->values = values;
+    container->capacity = INITIAL_ARRAY_CAPACITY;
+    container->words = NULL;
+    return container;
+}
+
+static void removeContainer(RoaringBitmap* bitmap, int position)
+{
+    BitmapContainer* container = &bitmap->containers[position];
+    releaseContainer(bitmap, container);
+    memmove(container, container + 1, sizeof(*container) * (bitmap->container_count - position - 1));
+    --bitmap->container_count;
+}
+
+static bool growArray(RoaringBitmap* bitmap, BitmapContainer* container)
+{
+    int capacity = 2 * container->capacity > BITMAP_ARRAY_MAX_SIZE ? BITMAP_ARRAY_MAX_SIZE : 2 * container->capacity;
+    uint16_t* values = allocate(bitmap, sizeof(*values) * capacity);
+    if (values == NULL)
+    {
+        return false;
+    }
+
+    memcpy(values, container->values, sizeof(*values) * container->cardinality);
+    release(bitmap, container->values, sizeof(*values) * container->capacity);
+    container->values = values;
+    container->capacity = capacity;
+    return true;
+}
+
+static bool convertToBitset(RoaringBitmap* bitmap, BitmapContainer* container)
+{
+    uint64_t* words = allocate(bitmap, sizeof(*words) * BITSET_WORDS);
+    if (words == NULL)
+    {
+        return false;
+    }
+
+    memset(words, 0, sizeof(*words) * BITSET_WORDS);
+    for (int current = 0; current < container->cardinality; ++current)
+    {
+        uint16_t low = container->values[current];
+        words[low / 64] |= (uint64_t)1 << (low % 64);
+    }
+    release(bitmap, container->values, sizeof(*(container->values)) * container->capacity);
+    container->values = NULL;
+    container->capacity = 0;
+    container->words = words;
+    return true;
+}
+
+static bool testBit(const uint64_t* words, uint16_t low)
+{
+    return (words[low / 64] >> (low % 64)) & 1;
+}
+
+static int intersectContainers(const BitmapContainer* container1, const BitmapContainer* container2,
+                               int* values)
+{
+    int base = (int)container1->key << 16;
+    int count = 0;
+
+    if (container1->words != NULL && container2->words != NULL)
+    {
+        for (int word = 0; word < BITSET_WORDS; ++word)
+        {
+            uint64_t common = container1->words[word] & container2->words[word];
+            if (values == NULL)
+            {
+                count += __builtin_popcountll(common);
+                continue;
+            }
+            while (common != 0)
+            {
+                values[count++] = base + 64 * word + __builtin_ctzll(common);
+                common &= common - 1;
+            }
+        }
+        return count;
+    }
+
+    if (container1->words != NULL || container2->words != NULL)
+    {
+        //Probing the bitset for each value of the array.
+        const BitmapContainer* array = container1->words == NULL ? container1 : container2;
+        const uint64_t* words = container1->words == NULL ? container2->words : container1->words;
+        for (int current = 0; current < array->cardinality; ++current)
+        {
+            if (testBit(words, array->values[current]))
+            {
+                if (values != NULL)
+                {
+                    values[count] = base + array->values[current];
+                }
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    int first = 0, second = 0;
+    while (first < container1->cardinality && second < container2->cardinality)
+    {
+        if (container1->values[first] < container2->values[second])
+        {
+            ++first;
+        }
+        else if (container1->values[first] > container2->values[second])
+        {
+            ++second;
+        }
+        else
+        {
+            if (values != NULL)
+            {
+                values[count] = base + container1->values[first];
+            }
+            ++count;
+            ++first;
+            ++second;
+        }
+    }
+    return count;
+}
+
+static int intersectBitmaps(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2, int* values)
+{
+    int count = 0;
+    int first = 0, second = 0;
+
+    while (first < bitmap1->container_count && second < bitmap2->container_count)
+    {
+        const BitmapContainer* container1 = &bitmap1->containers[first];
+        const BitmapContainer* container2 = &bitmap2->containers[second];
+        if (container1->key < container2->key)
+        {
+            ++first;
+        }
+        else if (container1->key > container2->key)
+        {
+            ++second;
+        }
+        else
+        {
+            count += intersectContainers(container1, container2, values == NULL ? NULL : values + count);
+            ++first;
+            ++second;
+        }
+    }
+    return count;
+}
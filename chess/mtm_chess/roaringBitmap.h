@@ -0,0 +1,64 @@
+#ifndef ROARING_BITMAP_H
+#define ROARING_BITMAP_H
+
+#include <stdbool.h>
+#include "arena.h"
+
+/**
+* Compressed set of non-negative ints, roaring style
+*
+* The values are split by their high 16 bits into containers, kept sorted by those bits. A container
+* holds the low 16 bits of its values either as a sorted array, while it has up to
+* BITMAP_ARRAY_MAX_SIZE of them, or as a bitset of 2^16 bits beyond that. Sparse sets thus cost two
+* bytes per value and dense ones a bit per value, and set operations run container by container:
+* merges of arrays, probes of bitsets, or word-wise ANDs of two bitsets.
+*
+* Dense values, such as the internal player indices (see player.h), mostly share a container, so
+* a lookup is a bit test or a short binary search.
+*
+* The following functions are available:
+*   bitmapInit			- Makes an empty bitmap
+*   bitmapFree			- Frees the bitmap's containers, leaving it empty
+*   bitmapAdd			- Adds a value
+*   bitmapRemove		- Removes a value
+*   bitmapContains		- Returns whether a value is in the bitmap
+*   bitmapGetCardinality	- Returns the number of values, in O(1)
+*   bitmapIntersectionCardinality - Returns the number of values in both of two bitmaps
+*   bitmapIntersect		- Puts the values in both of two bitmaps into an array
+*
+* A bitmap is not thread safe.
+*/
+
+//A container turns into a bitset once it would hold more values than this (a bitset's size, in
+//array entries).
+#define BITMAP_ARRAY_MAX_SIZE 4096
+
+typedef struct RoaringBitmap_t
+{
+    struct BitmapContainer_t* containers; //Sorted by their high bits.
+    int container_count;
+    int container_capacity;
+    int cardinality;
+    Arena arena; //Where the containers are allocated; NULL for the heap.
+} RoaringBitmap;
+
+//Construction & destruction:
+//The containers will be allocated from the given arena, or from the heap if it is NULL.
+void bitmapInit(RoaringBitmap* bitmap, Arena arena);
+void bitmapFree(RoaringBitmap* bitmap);
+
+//Returns false, leaving the bitmap as it was, if an allocation failed. Adding a value the bitmap
+//holds already does nothing.
+bool bitmapAdd(RoaringBitmap* bitmap, int value);
+//Removing a value never allocates. Containers left empty are freed, but bitsets are not turned
+//back into arrays.
+void bitmapRemove(RoaringBitmap* bitmap, int value);
+bool bitmapContains(const RoaringBitmap* bitmap, int value);
+int bitmapGetCardinality(const RoaringBitmap* bitmap);
+
+int bitmapIntersectionCardinality(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2);
+//Puts the values in both bitmaps into values in ascending order, and returns their number.
+//values must fit the smaller cardinality of the two.
+int bitmapIntersect(const RoaringBitmap* bitmap1, const RoaringBitmap* bitmap2, int* values);
+
+#endif //ROARING_BITMAP_H
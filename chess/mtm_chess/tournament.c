@@ -1,4 +1,7 @@
 #include "tournament.h"
+#include "memoryStats.h"
+#include "roaringBitmap.h"
+#include <stdint.h>
 
 
 //static function declarations:
@@ -6,30 +9,81 @@
 static bool playedMaximumGames(Tournament tournament, int player);
 //Checks location validity.
 static bool invalidLocation(const char* tournament_location);
-static bool isPlayersFirstGame(Tournament tournament, int player_id);
 //Updates the statistics (wins/losses/draws) of a given player based on a given game.
 //Only meant to be used when adding a game to a tournament, NOT ON PLAYER REMOVAL.
-static ChessResult updatePlayerStatistics(Game game, Map players, int player_id);
+static void updatePlayerStatistics(const GameColumns* games, int game, PlayerTable* players, int player_index);
 //Calls the previous function on both players of a given game.
-static ChessResult updatePlayersStatistics(Game game, Map players);
+static void updatePlayersStatistics(const GameColumns* games, int game, PlayerTable* players);
 static void setTournamentWinner(Tournament tournament, int winner);
 
+//What a participant got from the tournament's games, as taken back when the tournament is removed.
+//wins + losses + draws is also the number of games the player played, as defined by didPlayerPlay.
+typedef struct PlayerContribution_t
+{
+    int player_index; //NO_PLAYER_INDEX (0) for an empty slot.
+    int wins;
+    int losses;
+    int draws;
+} PlayerContribution;
+
+//The contributions of all the participants, kept up to date with the games. Open addressing with
+//linear probing, at most half full.
+typedef struct ContributionTable_t
+{
+    PlayerContribution* slots;
+    int capacity; //A power of two, or 0 before the first game.
+    int count;
+} ContributionTable;
+
+//Returns the player's contribution, or NULL if the player has no game in the tournament.
+static PlayerContribution* findContribution(const ContributionTable* table, int player_index);
+//Same, adding an empty contribution if needed. Returns NULL if an allocation failed.
+static PlayerContribution* addContribution(Tournament tournament, int player_index);
+//Adds (sign 1) or takes out (sign -1) what the game gives its players in its current state.
+//Both players must be in the table.
+static void applyGameContribution(Tournament tournament, int game, int sign);
+static int getPlayedGames(Tournament tournament, int player_index);
+//Adds to the contributions what the forfeited games give their players in calculateTournamentWinner:
+//a loss to the removed player, or a draw to each of two removed players.
+static void addForfeitedResults(const GameColumns* games, ContributionTable* results);
+//Whether the first player beats the second for the tournament's win: by score, then by fewer losses,
+//then by more wins, then by the smaller id.
+static bool isBetterCandidate(const PlayerContribution* player, int player_id,
+                              const PlayerContribution* winner, int winner_id);
+//Returns the player's first slot in probing order: the high bits of the index times 2^32 / phi
+//(Fibonacci hashing), as for the player ids (see player.c).
+static unsigned int contributionSlot(int player_index, int capacity);
+//Returns the first empty slot in the player's probing order.
+static PlayerContribution* claimContributionSlot(PlayerContribution* slots, int capacity, int player_index);
+
 struct Tournament_t
 {
-    unsigned int tournament_id;
-    char* location;
-    Map games;
+    AvlLink link; //In the system's tournaments map.
+    int tournament_id;
+    Location location;
+    //The games and the contributions are allocated from the tournament's own arena, so freeing
+    //the tournament releases them all at once.
+    Arena arena;
+    GameColumns games;
+    ContributionTable contributions;
+    //Players with a game here they didn't forfeit by being removed from the system.
+    RoaringBitmap participants;
+    //Participants who left the set above when they were removed; the tournament still counts them.
+    int departed_count;
     int winner;
     int max_games_per_player;
-    int player_count;
     bool finished;
     
 };
 
 
+DEFINE_INTRUSIVE_MAP(TournamentMap, tournamentMap, int, struct Tournament_t, link, tournament_id,
+                     TYPED_MAP_COMPARE_SCALARS)
+
+
 //Construction & destruction:
-Tournament createTournament(int tournament_id, const char* location_str,
-                            int max_games_per_player, ChessResult* error)
+Tournament createTournament(int tournament_id, LocationTable locations, const char* location_str,
+                            int max_games_per_player, Arena arena, ChessResult* error)
 {
     *error = CHESS_SUCCESS;
 
@@ -51,56 +105,62 @@ Tournament createTournament(int tournament_id, const char* location_str,
         return NULL;
     }
 
-    Tournament tournament = malloc(sizeof(*tournament));
+    Tournament tournament = arena != NULL ? arenaAllocate(arena, sizeof(*tournament))
+                                          : trackedMalloc(MEMORY_TOURNAMENTS, sizeof(*tournament));
     if (tournament == NULL)
     {
         *error = CHESS_OUT_OF_MEMORY;
         return NULL;
     }
 
-    
-    tournament->location = malloc(sizeof(*(tournament->location)) * (strlen(location_str) + 1));
+    tournament->arena = arenaCreate(MEMORY_GAMES);
+    tournament->location = tournament->arena == NULL ? NULL : internLocation(locations, location_str);
     if (tournament->location == NULL)
     {
         *error = CHESS_OUT_OF_MEMORY;
-        free(tournament);
+        arenaDestroy(tournament->arena);
+        if (arena != NULL)
+        {
+            arenaRelease(arena, tournament, sizeof(*tournament));
+        }
+        else
+        {
+            trackedFree(MEMORY_TOURNAMENTS, tournament, sizeof(*tournament));
+        }
         return NULL;
     }
 
-    strcpy(tournament->location, location_str);
-
-    tournament->games = mapCreate(&mapGameCopy,
-                        &mapGameIdCopy,
-                        &mapGameDataFree,
-                        &mapGameIdFree,
-                        &mapGameKeyCompare);
-   
-    if (tournament->games == NULL)
-    {
-        free(tournament->location);
-        free(tournament);
-        *error = CHESS_OUT_OF_MEMORY;
-        return NULL;
-    }
+    initGameColumns(&tournament->games, tournament->arena);
+    tournament->contributions.slots = NULL;
+    tournament->contributions.capacity = 0;
+    tournament->contributions.count = 0;
+    bitmapInit(&tournament->participants, tournament->arena);
+    tournament->departed_count = 0;
 
     tournament->max_games_per_player = max_games_per_player;
-    tournament->player_count = 0;
     tournament->tournament_id = tournament_id;  
     tournament->finished = false;
 
     return tournament;        
 }
 
-void freeTournament(Tournament tournament)
+void freeTournament(Tournament tournament, Arena arena)
 {
     if(tournament == NULL)
     {
         return;
     }
 
-    free(tournament->location);
-    mapDestroy(tournament->games);
-    free(tournament);
+    releaseLocation(tournament->location);
+    arenaDestroy(tournament->arena); //The games and participants go with it.
+    if (arena != NULL)
+    {
+        arenaRelease(arena, tournament, sizeof(*tournament));
+    }
+    else
+    {
+        trackedFree(MEMORY_TOURNAMENTS, tournament, sizeof(*tournament));
+    }
 }
 
 
@@ -110,13 +170,21 @@ int getTournamentWinner(Tournament tournament)
     return tournament->winner;
 }
 
-char* getLocation(Tournament tournament)
+const char* getLocation(Tournament tournament)
+{
+    return getLocationName(tournament->location);
+}
+Location getLocationHandle(Tournament tournament)
 {
     return tournament->location;
 }
 int getPlayerCount(Tournament tournament)
 {
-    return tournament->player_count;
+    return bitmapGetCardinality(&tournament->participants) + tournament->departed_count;
+}
+const RoaringBitmap* getParticipants(Tournament tournament)
+{
+    return &tournament->participants;
 }
 bool isFinished(Tournament tournament)
 {
@@ -124,41 +192,11 @@ bool isFinished(Tournament tournament)
 }
 int getGameCount(Tournament tournament)
 {
-    return mapGetSize(tournament->games);
+    return tournament->games.count;
 }
 
 //additional functions:
-Tournament copyTournament(Tournament src)
-{
-    if (src == NULL)
-    {
-        return NULL;
-    }
-
-    Tournament copy = malloc(sizeof(*copy));
-    if (copy == NULL)
-    {
-        return NULL;
-    }
-
-    copy->finished = src->finished;
-    copy->tournament_id = src->tournament_id;
-    copy->player_count = src->player_count;
-    copy->games = mapCopy(src->games);
-    copy->winner = src->winner;
-    copy->max_games_per_player = src->max_games_per_player;
-    copy->location = malloc(sizeof(*(copy->location)) * (strlen(src->location) + 1));
-    if(copy->location == NULL)
-    {
-        return NULL;
-    }
-
-    strcpy(copy->location, src->location);
-
-    return copy;
-}
-
-ChessResult endTournament(Tournament tournament)
+ChessResult endTournament(Tournament tournament, const PlayerTable* players)
 {
     if(isFinished(tournament))
     {
@@ -169,8 +207,11 @@ ChessResult endTournament(Tournament tournament)
         return CHESS_NO_GAMES;
     }
 
-    int winnerId = calculateTournamentWinner(tournament);
-    assert(winnerId != NO_WINNER);
+    int winnerId = calculateTournamentWinner(tournament, players);
+    if (winnerId == NO_WINNER)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
     setTournamentWinner(tournament, winnerId);
 
     tournament->finished = true;
@@ -178,143 +219,137 @@ ChessResult endTournament(Tournament tournament)
     return CHESS_SUCCESS;
 }
 
-ChessResult removeTournamentFromStatistics(Tournament tournament, Map players)
+ChessResult removeTournamentFromStatistics(Tournament tournament, PlayerTable* players)
 {
     if (tournament == NULL || players == NULL)
     {
         return CHESS_NULL_ARGUMENT;
     }
 
-    MAP_FOREACH(int*, current_game, tournament->games)
+    PlayerContribution* slots = tournament->contributions.slots;
+    for (int slot = 0; slot < tournament->contributions.capacity; ++slot)
     {
-        Game game = mapGet(tournament->games, current_game);
-        int id1 = getPlayer1Id(game), id2 = getPlayer2Id(game);
-        Player player1 = mapGet(players, &id1),
-            player2 = mapGet(players, &id2);
-        
-        decreaseTournamentStatistics(game, player1, player2);
+        if (slots[slot].player_index == NO_PLAYER_INDEX || slots[slot].wins + slots[slot].losses + slots[slot].draws == 0)
+        {
+            continue;
+        }
 
-        free(current_game);
+        //Players removed from the system have no statistics left to update.
+        Player player = getPlayerAt(players, slots[slot].player_index);
+        if (player != NULL)
+        {
+            subtractPlayerStatistics(player, slots[slot].wins, slots[slot].losses, slots[slot].draws);
+        }
     }
 
     return CHESS_SUCCESS;
 }
 
-void decreaseTournamentStatistics(Game game, Player player1, Player player2)
+ChessResult addGameToTournament(Tournament tournament, int first_player, int second_player, Winner winner, int play_time, PlayerTable* players)
 {
-    Winner winner = getWinner(game);
-    if (isPlayerForfeited(game))
+    ChessResult error = validateGame(tournament, first_player, second_player, play_time);
+    if (error == CHESS_SUCCESS && first_player == second_player)
     {
-        if (winner != DRAW)
-        {
-            Player player_to_update =
-                winner == FIRST_PLAYER ? player1 : player2;
-            decreaseWins(player_to_update);
-        }
+        //appendGame rejects it too, but only after the participants would have been updated.
+        error = CHESS_INVALID_ID;
     }
-    else
+
+    if (error != CHESS_SUCCESS)
     {
-        if (winner == DRAW)
-        {
-            decreaseDraws(player1);
-            decreaseDraws(player2);
-        }
-        else
-        {
-            Player winning_player =
-                winner == FIRST_PLAYER ? player1 : player2,
-                    losing_player =
-                winner == SECOND_PLAYER ? player1 : player2;
-            decreaseWins(winning_player);
-            decreaseLosses(losing_player);
-        }
+         return error;
+    }
+
+    //The contributions and participants are made room for first, so the game is only added if they
+    //can be updated.
+    if (addContribution(tournament, first_player) == NULL || addContribution(tournament, second_player) == NULL
+        || !bitmapAdd(&tournament->participants, first_player)
+        || !bitmapAdd(&tournament->participants, second_player))
+    {
+        return CHESS_OUT_OF_MEMORY;
     }
+
+    //Games are never removed, so the new game's index is its id.
+    error = appendGame(&tournament->games, first_player, second_player, winner, play_time);
+    if(error != CHESS_SUCCESS)
+    {
+        return error;
+    }
+
+    applyGameContribution(tournament, tournament->games.count - 1, 1);
+    updatePlayersStatistics(&tournament->games, tournament->games.count - 1, players);
+
+    return CHESS_SUCCESS;
 }
 
-ChessResult addGameToTournament(Tournament tournament, int first_player, int second_player, Winner winner, int play_time, Map players_map)
+ChessResult validateGame(Tournament tournament, int first_player, int second_player, int play_time)
 {
-    ChessResult error = CHESS_SUCCESS;
     if(tournament == NULL)
     {
-        error = CHESS_NULL_ARGUMENT;
+        return CHESS_NULL_ARGUMENT;
     }
     else if(isFinished(tournament))
     {
-        error = CHESS_TOURNAMENT_ENDED;
+        return CHESS_TOURNAMENT_ENDED;
     }
+    //No game is stored with NO_PLAYER_INDEX, so the checks below find none for it.
     else if (alreadyExistsInTournament(tournament, first_player, second_player))
     {
-        error = CHESS_GAME_ALREADY_EXISTS;
+        return CHESS_GAME_ALREADY_EXISTS;
     }
     else if (play_time < 0)
     {
-        error = CHESS_INVALID_PLAY_TIME;
+        return CHESS_INVALID_PLAY_TIME;
     }
     else if(playedMaximumGames(tournament, first_player)
         || playedMaximumGames(tournament, second_player))
     {
-        error = CHESS_EXCEEDED_GAMES;
-    }
-
-    if (error != CHESS_SUCCESS)
-    {
-         return error;
+        return CHESS_EXCEEDED_GAMES;
     }
 
-    Game game = createGame(first_player, second_player, winner, play_time, &error);
-    if(game == NULL)
-    {
-        return error;
-    }
+    return CHESS_SUCCESS;
+}
 
-    int newKey = mapGetSize(tournament->games) + 1; //TODO: Check if this works. Do we have no game removal?
-    int valueToAdd = isPlayersFirstGame(tournament, first_player)
-                     + isPlayersFirstGame(tournament, second_player);
+int forfeitPlayerGames(Tournament tournament, int player_index, int* promoted_players)
+{
+    int promoted_count = 0;
 
-    if(mapPut(tournament->games, &newKey, game) == MAP_OUT_OF_MEMORY)
+    //Only participants have games to forfeit.
+    if (!bitmapContains(&tournament->participants, player_index))
     {
-        freeGame(game);
-        return CHESS_OUT_OF_MEMORY;
+        return 0;
     }
 
-    freeGame(game);
-
-    tournament->player_count += valueToAdd;
-
-
-    return updatePlayersStatistics(mapGet(tournament->games, &newKey), players_map);
-}
-
-ChessResult removePlayer(Tournament tournament, int player_id, Map players)
-{
-    MAP_FOREACH(int*, current_game_id, tournament->games)
+    for (int game = 0; game < tournament->games.count; ++game)
     {
-        Game game = mapGet(tournament->games, current_game_id);
-        assert(game != NULL);
-
-        if(didPlayerPlay(game, player_id))
+        if(didPlayerPlay(&tournament->games, game, player_index))
         {
-            setPlayerForfeited(game, player_id, players);
+            applyGameContribution(tournament, game, -1);
+            int promoted_index = setPlayerForfeited(&tournament->games, game, player_index);
+            applyGameContribution(tournament, game, 1);
+            if (promoted_index != NO_WINNER)
+            {
+                promoted_players[promoted_count++] = promoted_index;
+            }
         }
-
-        free(current_game_id);
     }
 
-    return CHESS_SUCCESS;
+    //All of the player's games are forfeited now, so it played none (see didPlayerPlay).
+    bitmapRemove(&tournament->participants, player_index);
+    ++tournament->departed_count;
+
+    return promoted_count;
 }
 
 bool alreadyExistsInTournament(Tournament tournament, int first_player,int second_player)
 {
-    Game game;
+    const int* player1 = tournament->games.player1;
+    const int* player2 = tournament->games.player2;
 
-    MAP_FOREACH(int*, current_key, tournament->games)
+    for (int game = 0; game < tournament->games.count; ++game)
     {
-        game = mapGet(tournament->games, current_key);
-
-        free(current_key);
-
-        if(((getPlayer1Id(game) == first_player && getPlayer2Id(game) == second_player) ||
-            (getPlayer2Id(game) == first_player && getPlayer1Id(game) == second_player))  && !isPlayerForfeited(game))
+        if(((player1[game] == first_player && player2[game] == second_player) ||
+            (player2[game] == first_player && player1[game] == second_player))
+            && !isPlayerForfeited(&tournament->games, game))
         {
             return true;
         }
@@ -322,26 +357,13 @@ bool alreadyExistsInTournament(Tournament tournament, int first_player,int secon
     return false;
 }
 
-int getTotalPlayerPlayTime(Tournament tournament, int id, int* tournament_game_count)
+int getTotalPlayerPlayTime(Tournament tournament, int player_index, int* tournament_game_count)
 {
-    int total_playtime = 0;
+    int game_count;
+    int total_playtime = getPlayerTotalPlayTime(&tournament->games, player_index, &game_count);
     if (tournament_game_count != NULL)
     {
-        *tournament_game_count = 0;
-    }
-
-    MAP_FOREACH(int*, current_game_id, tournament->games)
-    {
-        Game game = mapGet(tournament->games, current_game_id);
-        assert(game != NULL);
-
-        total_playtime += getPlayerPlayTime(game, id);
-        if (tournament_game_count != NULL && didPlayerPlay(game, id))
-        {
-            ++(*tournament_game_count);
-        }
-
-        free(current_game_id);
+        *tournament_game_count = game_count;
     }
 
     return total_playtime;
@@ -351,193 +373,54 @@ void getGameTimeStatistics(Tournament tournament, int *longest_time, double *ave
 {
     assert(getGameCount(tournament) > 0);
 
-    int maximum_game_time = 0, total_time = 0;
-
-    MAP_FOREACH(int*, current_game_id, tournament->games)
-    {
-        Game game = mapGet(tournament->games, current_game_id);
-        int time = getTime(game);
-
-        maximum_game_time = time > maximum_game_time ? time : maximum_game_time;
-        total_time += time;
-
-        free(current_game_id);
-    }
-
-    *longest_time = maximum_game_time;
+    int total_time;
+    getGamesTimeStatistics(&tournament->games, longest_time, &total_time);
     *average_time = (double)total_time/getGameCount(tournament);
 }
 
-Map createTournamentPlayersMap(Tournament tournament)
+long long getTotalGameTime(Tournament tournament)
 {
-    Map players_in_tournament = mapCreate(&mapPlayerCopy,
-                                            &mapPlayerIdCopy,
-                                            &mapPlayerDataFree,
-                                            &mapPlayerIdFree,
-                                            &mapPlayerKeyCompare);
-    if(players_in_tournament == NULL)
-    {
-        return NULL;
-    }
-
-     Game game;
-     Player player;
-     int current_player1;
-     int current_player2;
-     
-    MAP_FOREACH(int*, current_game, tournament->games)
-    {
-        game = mapGet(tournament->games, current_game);
-        current_player1 = getPlayer1Id(game);
-        current_player2 = getPlayer2Id(game);
-            
-
-        if(!mapContains(players_in_tournament, &current_player1))
-        {
-            player = createPlayer(getPlayer1Id(game));
-            MapResult result = mapPut(players_in_tournament, &current_player1, player);
-            freePlayer(player);
-            if(result == MAP_OUT_OF_MEMORY)
-            {
-                mapDestroy(players_in_tournament);
-                return NULL;
-            }
-        }
-        if(!mapContains(players_in_tournament, &current_player2))
-        {
-            player = createPlayer(getPlayer2Id(game));
-            MapResult result = mapPut(players_in_tournament, &current_player2, player);
-            freePlayer(player);
-            if(result == MAP_OUT_OF_MEMORY)
-            {
-                mapDestroy(players_in_tournament);
-                return NULL;
-            }
-        }  
-        free(current_game);  
-    }
-    return intTournamentPlayersMap(players_in_tournament, tournament);
+    return tournament->games.total_time;
 }
 
-Map intTournamentPlayersMap(Map players_in_tournament, Tournament tournament)
+int calculateTournamentWinner(Tournament tournament, const PlayerTable* players)
 {
-    Game game;
-    int player1_id;
-    int player2_id;
-    MAP_FOREACH(int*, current_game, tournament->games)
+    //The contributions are the results the games give as they stand, but for the forfeited games.
+    ContributionTable results = tournament->contributions;
+    if (tournament->games.forfeited_count > 0)
     {
-        game = mapGet(tournament->games, current_game);
-        player1_id = getPlayer1Id(game);
-        player2_id = getPlayer2Id(game);
-
-        Player player1 = mapGet(players_in_tournament, &player1_id);
-        Player player2 = mapGet(players_in_tournament, &player2_id);
-        Winner winner = getWinner(game);
-
-        if(winner == FIRST_PLAYER)
+        results.slots = malloc(sizeof(*(results.slots)) * results.capacity);
+        if (results.slots == NULL)
         {
-            increaseWins(player1);
-            increaseLosses(player2);
-        }
-        else if(winner == SECOND_PLAYER)
-        {          
-            increaseWins(player2);
-            increaseLosses(player1);
+            return NO_WINNER;
         }
-        else
-        { 
-            increaseDraws(player1);
-            increaseDraws(player2);
-        }
-        free(current_game);
+        memcpy(results.slots, tournament->contributions.slots, sizeof(*(results.slots)) * results.capacity);
+        addForfeitedResults(&tournament->games, &results);
     }
-    return players_in_tournament;
-}
 
-int calculateTournamentWinner(Tournament tournament)
-{
-     Player current_player;
-     Player current_winner;
-     int current_winner_score = -1;
-     int current_winner_id = 0;
-
-    Map players_in_tournament = createTournamentPlayersMap(tournament);
-    if(players_in_tournament == NULL)
+    const PlayerContribution* winner = NULL;
+    int winner_id = NO_WINNER;
+    for (int slot = 0; slot < results.capacity; ++slot)
     {
-        return NO_WINNER;
-    }
-
-        MAP_FOREACH(int*, current_player_id, players_in_tournament)
+        const PlayerContribution* player = &results.slots[slot];
+        if (player->player_index == NO_PLAYER_INDEX)
         {
-            current_player = mapGet(players_in_tournament, current_player_id);
-            current_winner = mapGet(players_in_tournament, &current_winner_id); 
-
-            if(playerScore(current_player) > current_winner_score)
-            {
-               current_winner_score = playerScore(current_player);
-               current_winner_id = *current_player_id; 
-            }
-            else if(playerScore(current_player) == current_winner_score)
-            {
-                if(getLosses(current_player) < getLosses(current_winner))
-                {
-                    current_winner_score = playerScore(current_player);
-                    current_winner_id = *current_player_id;
-                }
-                else if(getLosses(current_player) == getLosses(current_winner))
-                {
-                    if(getWins(current_player) > getWins(current_winner))
-                    {
-                        current_winner_score = playerScore(current_player);
-                        current_winner_id = *current_player_id;
-                    }
-                    else if(getWins(current_player) == getWins(current_winner))
-                    {
-                        if(*current_player_id < current_winner_id)
-                        {
-                            current_winner_score = playerScore(current_player);
-                            current_winner_id = *current_player_id;
-                        }
-                    }
-                }
-                
-            }
-            free(current_player_id);
+            continue;
         }
-        mapDestroy(players_in_tournament);
-        return current_winner_id;   
-}
 
-//Map-related functions:
-MapDataElement mapTournamentCopy(MapDataElement tournament)
-{
-    return copyTournament((Tournament)tournament);
-}
+        int player_id = getIndexedPlayerId(players, player->player_index);
+        if (winner == NULL || isBetterCandidate(player, player_id, winner, winner_id))
+        {
+            winner = player;
+            winner_id = player_id;
+        }
+    }
 
-MapKeyElement mapTournamentIdCopy(MapKeyElement id)
-{
-    int *new = malloc(sizeof(int));
-    if (new == NULL)
+    if (results.slots != tournament->contributions.slots)
     {
-        return NULL;
+        free(results.slots);
     }
-    *new = *((int*)id);
-    return new;
-}
-
-void mapTournamentDataFree(MapDataElement tournament)
-{
-    freeTournament((Tournament)tournament);
-}
-
-void mapTournamentIdFree(MapKeyElement id)
-{
-    free((int*)id);
-}
-
-int mapTournamentKeyCompare(MapKeyElement id1, MapKeyElement id2)
-{
-    return (*((int*)id1) - *((int*)id2));
+    return winner_id;
 }
 
 //static functions:
@@ -571,101 +454,193 @@ static bool invalidLocation(const char* tournament_location)
 
 static bool playedMaximumGames(Tournament tournament, int player)
 {   
-    Game game;
-    int gamesPlayed = 0;
+    return (getPlayedGames(tournament, player) >= tournament->max_games_per_player);
+}
+
+static void updatePlayerStatistics(const GameColumns* games, int game, PlayerTable* players, int player_index)
+{
+    assert(!isPlayerForfeited(games, game));
+
+    Player player = enterPlayer(players, player_index);
 
-    MAP_FOREACH(int*, current_key, tournament->games)
+    Winner winner = getWinner(games, game);
+    if (winner == DRAW)
     {
-        game = mapGet(tournament->games, current_key);
-        bool isAutoWin = isPlayerForfeited(game);
-        if (((isAutoWin && getWinnerId(game) == player))
-             || ((!isAutoWin) && (getPlayer1Id(game) == player || getPlayer2Id(game) == player)))
-        {
-            ++gamesPlayed;
-        }
+        increaseDraws(player);
+    }
+    else if (getWinnerId(games, game) == player_index)
+    {
+        increaseWins(player);
+    }
+    else
+    {
+        increaseLosses(player);
+    }
+}
 
-        free(current_key);
+static void updatePlayersStatistics(const GameColumns* games, int game, PlayerTable* players)
+{
+    updatePlayerStatistics(games, game, players, getPlayer1Id(games, game));
+    updatePlayerStatistics(games, game, players, getPlayer2Id(games, game));
+}
+
+static void setTournamentWinner(Tournament tournament, int winner)
+{
+    tournament->winner = winner;
+}
+
+static PlayerContribution* findContribution(const ContributionTable* table, int player_index)
+{
+    if (table->capacity == 0)
+    {
+        return NULL;
     }
 
-    return (gamesPlayed >= tournament->max_games_per_player);
+    unsigned int mask = (unsigned int)(table->capacity - 1);
+    for (unsigned int slot = contributionSlot(player_index, table->capacity);
+         table->slots[slot].player_index != NO_PLAYER_INDEX; slot = (slot + 1) & mask)
+    {
+        if (table->slots[slot].player_index == player_index)
+        {
+            return &table->slots[slot];
+        }
+    }
+    return NULL;
 }
 
-static ChessResult updatePlayerStatistics(Game game, Map players, int player_id)
+static PlayerContribution* addContribution(Tournament tournament, int player_index)
 {
-    assert(!isPlayerForfeited(game));
+    ContributionTable* table = &tournament->contributions;
+    PlayerContribution* contribution = findContribution(table, player_index);
+    if (contribution != NULL)
+    {
+        return contribution;
+    }
 
-    if (!mapContains(players, &player_id))
+    if (2 * (table->count + 1) > table->capacity)
     {
-        Player player = createPlayer(player_id);
-        if (player == NULL)
+        int capacity = table->capacity == 0 ? 8 : 2 * table->capacity;
+        PlayerContribution* slots = arenaAllocate(tournament->arena, sizeof(*slots) * capacity);
+        if (slots == NULL)
         {
-            return CHESS_OUT_OF_MEMORY;
+            return NULL;
         }
-        MapResult error = mapPut(players, &player_id, player);
-        freePlayer(player);
-        if (error != MAP_SUCCESS)
+        memset(slots, 0, sizeof(*slots) * capacity);
+
+        for (int slot = 0; slot < table->capacity; ++slot)
         {
-            if (error == MAP_OUT_OF_MEMORY)
+            if (table->slots[slot].player_index != NO_PLAYER_INDEX)
             {
-                return CHESS_OUT_OF_MEMORY;
+                *claimContributionSlot(slots, capacity, table->slots[slot].player_index) = table->slots[slot];
             }
-            assert(false /* We shouldn't ever get here. */);
         }
+        arenaRelease(tournament->arena, table->slots, sizeof(*(table->slots)) * table->capacity);
+        table->slots = slots;
+        table->capacity = capacity;
     }
 
-    Player player = mapGet(players, &player_id);
-    if (player == NULL)
+    contribution = claimContributionSlot(table->slots, table->capacity, player_index);
+    contribution->player_index = player_index;
+    ++table->count;
+    return contribution;
+}
+
+static unsigned int contributionSlot(int player_index, int capacity)
+{
+    assert(capacity > 1);
+    int shift = 32;
+    for (int size = capacity; size > 1; size >>= 1)
     {
-        return CHESS_OUT_OF_MEMORY;
+        --shift;
     }
+    return (unsigned int)(((uint32_t)player_index * UINT32_C(2654435761)) >> shift);
+}
 
-    Winner winner = getWinner(game);
-    if (winner == DRAW)
+static PlayerContribution* claimContributionSlot(PlayerContribution* slots, int capacity, int player_index)
+{
+    unsigned int slot = contributionSlot(player_index, capacity);
+    while (slots[slot].player_index != NO_PLAYER_INDEX)
     {
-        increaseDraws(player);
+        slot = (slot + 1) & (unsigned int)(capacity - 1);
+    }
+    return &slots[slot];
+}
+
+static void applyGameContribution(Tournament tournament, int game, int sign)
+{
+    const GameColumns* games = &tournament->games;
+    Winner winner = getWinner(games, game);
+    PlayerContribution* player1 = findContribution(&tournament->contributions, getPlayer1Id(games, game));
+    PlayerContribution* player2 = findContribution(&tournament->contributions, getPlayer2Id(games, game));
+    assert(player1 != NULL && player2 != NULL);
+    PlayerContribution* winning_player = winner == FIRST_PLAYER ? player1 : player2;
+    PlayerContribution* losing_player = winner == FIRST_PLAYER ? player2 : player1;
+
+    if (isPlayerForfeited(games, game))
+    {
+        //The removed player's results are gone; only the winner keeps a win.
+        if (winner != DRAW)
+        {
+            winning_player->wins += sign;
+        }
     }
-    else if (getWinnerId(game) == player_id)
+    else if (winner == DRAW)
     {
-        increaseWins(player);
+        player1->draws += sign;
+        player2->draws += sign;
     }
     else
     {
-        increaseLosses(player);
+        winning_player->wins += sign;
+        losing_player->losses += sign;
     }
+}
 
-    return CHESS_SUCCESS;
+static int getPlayedGames(Tournament tournament, int player_index)
+{
+    const PlayerContribution* contribution = findContribution(&tournament->contributions, player_index);
+    return contribution == NULL ? 0 : contribution->wins + contribution->losses + contribution->draws;
 }
 
-static bool isPlayersFirstGame(Tournament tournament, int player_id)
+static void addForfeitedResults(const GameColumns* games, ContributionTable* results)
 {
-    bool found = false;
-    MAP_FOREACH(int*, current_game_id, tournament->games)
+    for (int game = 0; game < games->count; ++game)
     {
-        Game current_game = mapGet(tournament->games, current_game_id);
-        free(current_game_id);
+        if (!isPlayerForfeited(games, game))
+        {
+            continue;
+        }
 
-        if ((found = didPlayerPlay(current_game, player_id)))
+        PlayerContribution* player1 = findContribution(results, getPlayer1Id(games, game));
+        PlayerContribution* player2 = findContribution(results, getPlayer2Id(games, game));
+        Winner winner = getWinner(games, game);
+        if (winner == DRAW)
         {
-            break;
+            ++player1->draws;
+            ++player2->draws;
+        }
+        else
+        {
+            ++(winner == FIRST_PLAYER ? player2 : player1)->losses;
         }
     }
-    return !found;
 }
 
-static ChessResult updatePlayersStatistics(Game game, Map players)
+static bool isBetterCandidate(const PlayerContribution* player, int player_id,
+                              const PlayerContribution* winner, int winner_id)
 {
-    ChessResult error;
-
-    error = updatePlayerStatistics(game, players, getPlayer1Id(game));
-    if (error != CHESS_SUCCESS)
+    int player_score = 2 * player->wins + player->draws, winner_score = 2 * winner->wins + winner->draws;
+    if (player_score != winner_score)
     {
-        return error;
+        return player_score > winner_score;
     }
-
-    return updatePlayerStatistics(game, players, getPlayer2Id(game));
-}
-
-static void setTournamentWinner(Tournament tournament, int winner)
-{
-    tournament->winner = winner;
+    if (player->losses != winner->losses)
+    {
+        return player->losses < winner->losses;
+    }
+    if (player->wins != winner->wins)
+    {
+        return player->wins > winner->wins;
+    }
+    return player_id < winner_id;
 }
@@ -4,7 +4,10 @@
 #include "map.h"
 #include "game.h"
 #include "player.h"
+#include "location.h"
 #include "chessSystem.h"
+#include "typedMap.h"
+#include "roaringBitmap.h"
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
@@ -13,45 +16,65 @@
 
 typedef struct Tournament_t *Tournament;
 
+//Tournaments keyed by their ids, linked through a field of their own (see typedMap.h).
+//The map owns none of them: they are created and freed by the functions below.
+DECLARE_INTRUSIVE_MAP(TournamentMap, tournamentMap, int, struct Tournament_t)
 
 
 //Construction & destruction:
-Tournament createTournament(int tournament_id, const char* location_str,
-                            int max_games_per_player, ChessResult* error);
+//The location is interned in the given table. The tournament is allocated from the given arena, or
+//from the heap if it is NULL; freeTournament must be given the same arena.
+Tournament createTournament(int tournament_id, LocationTable locations, const char* location_str,
+                            int max_games_per_player, Arena arena, ChessResult* error);
 
-void freeTournament(Tournament tournament);
+//Releases the tournament's games and location, and frees it.
+void freeTournament(Tournament tournament, Arena arena);
 
 //Getters & setters:
+//The winner's player id, once the tournament ended.
 int getTournamentWinner(Tournament tournament);
 int getGameCount(Tournament tournament);
 //If game_count is not null, the total game count will be put in it.
-int getTotalPlayerPlayTime(Tournament tournament, int id, int* tournament_game_count);
+int getTotalPlayerPlayTime(Tournament tournament, int player_index, int* tournament_game_count);
 void getGameTimeStatistics(Tournament tournament, int *longest_time, double *average_time);
+//Sum of the lengths of all the tournament's games, in O(1).
+long long getTotalGameTime(Tournament tournament);
 bool isFinished(Tournament tournament);
-char* getLocation(Tournament tournament);
+const char* getLocation(Tournament tournament);
+Location getLocationHandle(Tournament tournament);
+//Every player who had a game in the tournament, counting a player removed from the system and then
+//added back into the tournament twice. Runs in O(1).
 int getPlayerCount(Tournament tournament);
+//The internal indices of the players with a game in the tournament they didn't forfeit by being
+//removed from the system (see didPlayerPlay). Removals from the system only leave the participants
+//of unfinished tournaments.
+const RoaringBitmap* getParticipants(Tournament tournament);
 
 //additional functions:
+//The games refer to players by their internal indices in the system's table (see player.h), which
+//must have been given already; the players get the game's results in the table.
 ChessResult addGameToTournament(Tournament tournament, int first_player, int second_player,
-                                Winner winner, int play_time, Map players_map);
+                                Winner winner, int play_time, PlayerTable* players);
+//Returns the error addGameToTournament would give the game, or CHESS_SUCCESS, without adding it.
+//A player may be NO_PLAYER_INDEX if its id has no index yet, as it has no games then. Whether the
+//players differ is left to the caller, since two such players can't be told apart.
+ChessResult validateGame(Tournament tournament, int first_player, int second_player, int play_time);
 
-//This updates player statistics before a tournament's removal.
-//The players map is the one stored in the ChessSystem.
-ChessResult removeTournamentFromStatistics(Tournament tournament, Map players);
-void decreaseTournamentStatistics(Game game, Player player1, Player player2);
-ChessResult removePlayer(Tournament tournament, int player_id, Map players);
+//This updates player statistics before a tournament's removal: the results every participant got
+//from the tournament are summed up, then taken back with one lookup per participant.
+//The players table is the one stored in the ChessSystem.
+ChessResult removeTournamentFromStatistics(Tournament tournament, PlayerTable* players);
+//Forfeits all of the player's games in the tournament, which it no longer participates in. Opponents who lost such a game now win it;
+//their indices are put in promoted_players, which must fit getGameCount(tournament) of them, so the
+//caller can update their statistics. Only touches the tournament itself, so different tournaments
+//may be handled concurrently. Returns the number of indices put in promoted_players.
+int forfeitPlayerGames(Tournament tournament, int player_index, int* promoted_players);
 bool alreadyExistsInTournament(Tournament tournament, int first_player,int second_player);
-int calculateTournamentWinner(Tournament tournament);
-Map intTournamentPlayersMap(Map players_in_tournament, Tournament tournament);
-Map createTournamentPlayersMap(Tournament tournament);
-Tournament copyTournament(Tournament src);
-ChessResult endTournament(Tournament tournament);
-
-//Map-related functions:
-MapDataElement mapTournamentCopy(MapDataElement tournament);
-MapKeyElement mapTournamentIdCopy(MapKeyElement id);
-void mapTournamentDataFree(MapDataElement tournament);
-void mapTournamentIdFree(MapKeyElement id);
-int mapTournamentKeyCompare(MapKeyElement id1, MapKeyElement id2);
+//Returns the winner's player id (the table translates the indices for the ties broken by id),
+//or NO_WINNER if an allocation failed. The results are judged from the participants'
+//contributions, without going over the games unless some were forfeited.
+int calculateTournamentWinner(Tournament tournament, const PlayerTable* players);
+//Returns CHESS_OUT_OF_MEMORY if the winner could not be calculated.
+ChessResult endTournament(Tournament tournament, const PlayerTable* players);
 
 #endif
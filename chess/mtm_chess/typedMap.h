@@ -0,0 +1,316 @@
+#ifndef TYPED_MAP_H
+#define TYPED_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "avlTree.h"
+#include "arena.h"
+#include "memoryStats.h"
+
+/**
+* Typed maps, generated at compile time
+*
+* Unlike map.h, whose keys and data are void* copied and compared through callbacks, these maps
+* are generated for one key type and one element type, and the key comparison is inlined into the
+* search. They are AVL trees (see avlTree.h) in one of two flavours:
+*
+* Intrusive maps link the caller's objects themselves: the object embeds an AvlLink and its key,
+* so adding it allocates nothing and walking the map touches nothing but the objects. The map never
+* allocates, copies or frees an object; whoever inserted it frees it after removing it. The map is
+* a plain struct, which its owner embeds and initializes:
+*
+*   DECLARE_INTRUSIVE_MAP(TournamentMap, tournamentMap, int, struct Tournament_t)	(tournament.h)
+*   DEFINE_INTRUSIVE_MAP(TournamentMap, tournamentMap, int, struct Tournament_t, link, tournament_id,
+*                        TYPED_MAP_COMPARE_SCALARS)	(tournament.c)
+*
+* The arguments are the map type's name, the prefix of its functions, the key type, the object type,
+* then (for the definition) the names of the object's AvlLink and key fields, and the key comparison.
+*
+* Typed maps own their values instead: each element is a node allocated by the map, holding the
+* link, the key and a copy of the value, all inline:
+*
+*   DECLARE_TYPED_MAP(ScoreMap, scoreMap, int, struct Score_t)
+*   DEFINE_TYPED_MAP(ScoreMap, scoreMap, int, struct Score_t, TYPED_MAP_COMPARE_SCALARS,
+*                    releaseScore, MEMORY_PLAYERS)
+*
+* The last arguments are the key comparison, a function releasing what a value owns (not the value
+* itself, which lives in its node), and the memoryStats.h category of the nodes.
+*
+* In both flavours, a map type is declared where its users can see it, and defined where the element
+* type is complete, so that type may stay opaque to every other file. The functions passed may be
+* function-like macros; the comparison returns a negative number, 0 or a positive number, like strcmp.
+* None of the macros takes a semicolon after it. Elements never move, so their addresses stay valid
+* until they are removed.
+*
+* The generated functions of an intrusive map, for the prefix map:
+*   mapInit		- Makes an empty map
+*   mapGetSize		- Returns the number of objects
+*   mapGet		- Returns the object of the given key, or NULL
+*   mapInsert		- Links an object. If another one has its key already, that one is returned
+*			  and the map is left as it was; otherwise the given object is returned
+*   mapRemove		- Unlinks an object of the map
+*   mapFirst		- Returns the object of the smallest key, or NULL for an empty map
+*   mapNext		- Returns the object of the next key, or NULL after the last one
+*   mapFirstPostorder	- Returns the first and the next object of a walk visiting every object after
+*   mapNextPostorder	  the ones below it, so each may be freed once visited (and mapNextPostorder
+*			  called on it). The map must be initialized again after such a walk.
+*
+* The generated functions of a typed map:
+*   mapCreate		- Creates an empty map, allocating from the given arena unless it's NULL
+*   mapDestroy		- Releases every value and frees the map. Does nothing for NULL
+*   mapGetSize		- Returns the number of elements
+*   mapGet		- Returns the value of the given key, or NULL
+*   mapPut		- Copies the given value in as the key's, releasing the value it replaces.
+*			  Returns the stored value, or NULL (copying nothing) if an allocation failed
+*   mapRemove		- Releases the key's value and removes it. Returns false if there was none
+*   mapFirst		- Returns the value of the smallest key, or NULL for an empty map
+*   mapNext		- Returns the value of the next key, or NULL after the last one
+*   mapKeyOf		- Returns the key of a stored value
+*
+* The maps are not thread safe, and changing them while iterating is undefined, but for removing
+* the current element once mapNext moved past it.
+*/
+
+//Comparison of keys ordered by the built-in operators, such as ints.
+#define TYPED_MAP_COMPARE_SCALARS(key1, key2) (((key1) > (key2)) - ((key1) < (key2)))
+
+#define DECLARE_INTRUSIVE_MAP(Name, prefix, Key, Type) \
+    typedef struct Name##_t \
+    { \
+        AvlTree tree; \
+    } Name; \
+    void prefix##Init(Name* map); \
+    int prefix##GetSize(Name* map); \
+    Type* prefix##Get(Name* map, Key key); \
+    Type* prefix##Insert(Name* map, Type* object); \
+    void prefix##Remove(Name* map, Type* object); \
+    Type* prefix##First(Name* map); \
+    Type* prefix##Next(Name* map, Type* object); \
+    Type* prefix##FirstPostorder(Name* map); \
+    Type* prefix##NextPostorder(Name* map, Type* object);
+
+#define DEFINE_INTRUSIVE_MAP(Name, prefix, Key, Type, link, key, compareKeys) \
+    TYPED_MAP_INTRUSIVE_FUNCTIONS(, Name, prefix, Key, Type, link, key, compareKeys)
+
+//The functions of an intrusive map over any struct MapType with an AvlTree named tree, with the
+//given storage class. Typed maps are intrusive maps of their nodes.
+#define TYPED_MAP_INTRUSIVE_FUNCTIONS(storage, MapType, prefix, Key, Type, link, key, compareKeys) \
+    static inline Type* prefix##ObjectOf(AvlLink* object_link) \
+    { \
+        return object_link == NULL ? NULL : (Type*)((char*)object_link - offsetof(Type, link)); \
+    } \
+    \
+    storage void prefix##Init(MapType* map) \
+    { \
+        avlInit(&map->tree); \
+    } \
+    \
+    storage int prefix##GetSize(MapType* map) \
+    { \
+        return map->tree.size; \
+    } \
+    \
+    storage Type* prefix##Get(MapType* map, Key searched) \
+    { \
+        AvlLink* object_link = map->tree.root; \
+        while (object_link != NULL) \
+        { \
+            int comparison = compareKeys(searched, prefix##ObjectOf(object_link)->key); \
+            if (comparison == 0) \
+            { \
+                return prefix##ObjectOf(object_link); \
+            } \
+            object_link = comparison < 0 ? object_link->left : object_link->right; \
+        } \
+        return NULL; \
+    } \
+    \
+    storage Type* prefix##Insert(MapType* map, Type* object) \
+    { \
+        AvlLink* parent = NULL; \
+        AvlLink** position = &map->tree.root; \
+        while (*position != NULL) \
+        { \
+            parent = *position; \
+            int comparison = compareKeys(object->key, prefix##ObjectOf(parent)->key); \
+            if (comparison == 0) \
+            { \
+                return prefix##ObjectOf(parent); \
+            } \
+            position = comparison < 0 ? &parent->left : &parent->right; \
+        } \
+        avlLink(&map->tree, &object->link, parent, position); \
+        return object; \
+    } \
+    \
+    storage void prefix##Remove(MapType* map, Type* object) \
+    { \
+        avlErase(&map->tree, &object->link); \
+    } \
+    \
+    storage Type* prefix##First(MapType* map) \
+    { \
+        return prefix##ObjectOf(avlFirst(&map->tree)); \
+    } \
+    \
+    storage Type* prefix##Next(MapType* map, Type* object) \
+    { \
+        return prefix##ObjectOf(avlNext(&object->link)); \
+    } \
+    \
+    storage Type* prefix##FirstPostorder(MapType* map) \
+    { \
+        return prefix##ObjectOf(avlFirstPostorder(&map->tree)); \
+    } \
+    \
+    storage Type* prefix##NextPostorder(MapType* map, Type* object) \
+    { \
+        return prefix##ObjectOf(avlNextPostorder(&object->link)); \
+    }
+
+#define DECLARE_TYPED_MAP(Name, prefix, Key, Value) \
+    typedef struct Name##_t *Name; \
+    Name prefix##Create(Arena arena); \
+    void prefix##Destroy(Name map); \
+    int prefix##GetSize(Name map); \
+    Value* prefix##Get(Name map, Key key); \
+    Value* prefix##Put(Name map, Key key, const Value* value); \
+    bool prefix##Remove(Name map, Key key); \
+    Value* prefix##First(Name map); \
+    Value* prefix##Next(Name map, Value* value); \
+    Key prefix##KeyOf(const Value* value);
+
+#define DEFINE_TYPED_MAP(Name, prefix, Key, Value, compareKeys, releaseValue, category) \
+    typedef struct Name##Node_t \
+    { \
+        AvlLink link; \
+        Key key; \
+        Value value; \
+    } Name##Node; \
+    \
+    struct Name##_t \
+    { \
+        AvlTree tree; \
+        Arena arena; /* Where the map and its nodes are allocated; NULL for the heap. */ \
+    }; \
+    \
+    TYPED_MAP_INTRUSIVE_FUNCTIONS(static inline, struct Name##_t, prefix##Nodes, Key, Name##Node, link, key, \
+                                  compareKeys) \
+    \
+    static inline Name##Node* prefix##NodeOf(const Value* value) \
+    { \
+        return (Name##Node*)((char*)value - offsetof(Name##Node, value)); \
+    } \
+    \
+    static inline void prefix##ReleaseNode(Name map, Name##Node* node) \
+    { \
+        if (map->arena != NULL) \
+        { \
+            arenaRelease(map->arena, node, sizeof(*node)); \
+        } \
+        else \
+        { \
+            trackedFree(category, node, sizeof(*node)); \
+        } \
+    } \
+    \
+    Name prefix##Create(Arena arena) \
+    { \
+        Name map = arena != NULL ? arenaAllocate(arena, sizeof(*map)) : malloc(sizeof(*map)); \
+        if (map == NULL) \
+        { \
+            return NULL; \
+        } \
+        prefix##NodesInit(map); \
+        map->arena = arena; \
+        return map; \
+    } \
+    \
+    void prefix##Destroy(Name map) \
+    { \
+        if (map == NULL) \
+        { \
+            return; \
+        } \
+        Name##Node* node = prefix##NodesFirstPostorder(map); \
+        while (node != NULL) \
+        { \
+            Name##Node* next = prefix##NodesNextPostorder(map, node); \
+            releaseValue(&node->value); \
+            prefix##ReleaseNode(map, node); \
+            node = next; \
+        } \
+        if (map->arena != NULL) \
+        { \
+            arenaRelease(map->arena, map, sizeof(*map)); \
+        } \
+        else \
+        { \
+            free(map); \
+        } \
+    } \
+    \
+    int prefix##GetSize(Name map) \
+    { \
+        return prefix##NodesGetSize(map); \
+    } \
+    \
+    Value* prefix##Get(Name map, Key key) \
+    { \
+        Name##Node* node = prefix##NodesGet(map, key); \
+        return node == NULL ? NULL : &node->value; \
+    } \
+    \
+    Value* prefix##Put(Name map, Key key, const Value* value) \
+    { \
+        Name##Node* node = prefix##NodesGet(map, key); \
+        if (node != NULL) \
+        { \
+            releaseValue(&node->value); \
+            node->value = *value; \
+            return &node->value; \
+        } \
+        \
+        node = map->arena != NULL ? arenaAllocate(map->arena, sizeof(*node)) : trackedMalloc(category, sizeof(*node)); \
+        if (node == NULL) \
+        { \
+            return NULL; \
+        } \
+        node->key = key; \
+        node->value = *value; \
+        prefix##NodesInsert(map, node); \
+        return &node->value; \
+    } \
+    \
+    bool prefix##Remove(Name map, Key key) \
+    { \
+        Name##Node* node = prefix##NodesGet(map, key); \
+        if (node == NULL) \
+        { \
+            return false; \
+        } \
+        prefix##NodesRemove(map, node); \
+        releaseValue(&node->value); \
+        prefix##ReleaseNode(map, node); \
+        return true; \
+    } \
+    \
+    Value* prefix##First(Name map) \
+    { \
+        Name##Node* node = prefix##NodesFirst(map); \
+        return node == NULL ? NULL : &node->value; \
+    } \
+    \
+    Value* prefix##Next(Name map, Value* value) \
+    { \
+        Name##Node* node = prefix##NodesNext(map, prefix##NodeOf(value)); \
+        return node == NULL ? NULL : &node->value; \
+    } \
+    \
+    Key prefix##KeyOf(const Value* value) \
+    { \
+        return prefix##NodeOf(value)->key; \
+    }
+
+#endif //TYPED_MAP_H